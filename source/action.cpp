@@ -20,9 +20,305 @@
 #include "action.h"
 #include "settings.h"
 #include "map.h"
+#include "creature.h"
+#include "iomap_otbm.h"
 #include "editor.h"
 #include "gui.h"
 
+TileDelta::TileDelta(Tile* tile, const Tile* base) :
+	location(tile->getLocation()),
+	mapflags(tile->getMapFlags()),
+	statflags(tile->getStatFlags()),
+	house_id(tile->getHouseID()),
+	creature(tile->creature),
+	spawn(tile->spawn),
+	has_ground(tile->ground != nullptr) {
+	tile->creature = nullptr;
+	tile->spawn = nullptr;
+
+	std::vector<const Item*> base_items;
+	if (base) {
+		base_items.push_back(base->ground);
+		base_items.insert(base_items.end(), base->items.begin(), base->items.end());
+	}
+	std::vector<bool> used(base_items.size(), false);
+
+	// Most edits keep the order of the items, so the search starts after the last match
+	size_t next = 0;
+	auto add = [&](Item* item) {
+		Entry entry { NotInBase, item->getID(), item->isSelected(), nullptr };
+		for (size_t n = 0; n < base_items.size(); ++n) {
+			const size_t index = (next + n) % base_items.size();
+			if (!used[index] && item->isSameAs(base_items[index])) {
+				used[index] = true;
+				entry.base_index = uint16_t(index);
+				next = index + 1;
+				break;
+			}
+		}
+
+		if (entry.base_index == NotInBase) {
+			entry.item = item;
+		} else {
+			delete item;
+		}
+		entries.push_back(entry);
+	};
+
+	if (tile->ground) {
+		add(tile->ground);
+		tile->ground = nullptr;
+	}
+	for (Item* item : tile->items) {
+		add(item);
+	}
+	tile->items.clear();
+	entries.shrink_to_fit();
+	delete tile;
+}
+
+TileDelta::TileDelta() :
+	location(nullptr),
+	mapflags(0),
+	statflags(0),
+	house_id(0),
+	creature(nullptr),
+	spawn(nullptr),
+	has_ground(false) {
+	////
+}
+
+TileDelta::~TileDelta() {
+	for (Entry& entry : entries) {
+		delete entry.item;
+	}
+	delete creature;
+	delete spawn;
+}
+
+Tile* TileDelta::restore(BaseMap& map, const Tile* base) {
+	Tile* tile = map.allocator(location);
+	tile->setMapFlags(mapflags);
+	tile->setStatFlags(statflags);
+	tile->house_id = house_id;
+	tile->creature = creature;
+	tile->spawn = spawn;
+	creature = nullptr;
+	spawn = nullptr;
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		Entry& entry = entries[i];
+		Item* item = entry.item;
+		entry.item = nullptr;
+		if (!item) {
+			const Item* base_item = nullptr;
+			if (base && entry.base_index == 0) {
+				base_item = base->ground;
+			} else if (base && entry.base_index <= base->items.size()) {
+				base_item = base->items[entry.base_index - 1];
+			}
+			// Only differs if the map tile was changed outside of the undo history,
+			// the item is then made from its ID alone
+			ASSERT(base_item && base_item->getID() == entry.id);
+			if (base_item && base_item->getID() == entry.id) {
+				item = base_item->deepCopy();
+			} else if (!(item = Item::Create(entry.id))) {
+				continue;
+			}
+			if (entry.selected) {
+				item->select();
+			} else {
+				item->deselect();
+			}
+		}
+
+		if (i == 0 && has_ground) {
+			tile->ground = item;
+		} else {
+			tile->items.push_back(item);
+		}
+	}
+	tile->update();
+	return tile;
+}
+
+Position TileDelta::getPosition() const {
+	return location->getPosition();
+}
+
+uint32_t TileDelta::memsize() const {
+	uint32_t mem = sizeof(*this);
+	mem += sizeof(Entry) * entries.capacity();
+	for (const Entry& entry : entries) {
+		if (entry.item) {
+			mem += entry.item->memsize();
+		}
+	}
+	return mem;
+}
+
+bool TileDelta::serialize(const IOMap& iomap, NodeFileWriteHandle& writer) const {
+	const Position position = getPosition();
+	writer.addU16(position.x);
+	writer.addU16(position.y);
+	writer.addU8(position.z);
+	writer.addU16(mapflags);
+	writer.addU16(statflags);
+	writer.addU32(house_id);
+	writer.addU8(has_ground);
+
+	writer.addU8(creature != nullptr);
+	if (creature) {
+		writer.addString(creature->getName());
+		writer.addU32(creature->getSpawnTime());
+		writer.addU8(creature->getDirection());
+		writer.addU8(creature->isSelected());
+	}
+
+	writer.addU8(spawn != nullptr);
+	if (spawn) {
+		writer.addU32(spawn->getSize());
+		writer.addU8(spawn->isSelected());
+	}
+
+	writer.addU32(entries.size());
+	for (const Entry& entry : entries) {
+		writer.addU16(entry.base_index);
+		writer.addU16(entry.id);
+		writer.addU8(entry.selected);
+	}
+
+	for (const Entry& entry : entries) {
+		if (entry.item && !entry.item->serializeItemNode_OTBM(iomap, writer)) {
+			return false;
+		}
+	}
+	return writer.error_code == FILE_NO_ERROR;
+}
+
+TileDelta* TileDelta::Unserialize(BaseMap& map, const IOMap& iomap, BinaryNode* node) {
+	TileDelta* delta = newd TileDelta();
+
+	uint16_t x, y;
+	uint8_t z, has_ground, has_creature, has_spawn;
+	if (!node->getU16(x) || !node->getU16(y) || !node->getU8(z) || !node->getU16(delta->mapflags) || !node->getU16(delta->statflags) || !node->getU32(delta->house_id) || !node->getU8(has_ground) || !node->getU8(has_creature)) {
+		delete delta;
+		return nullptr;
+	}
+	delta->location = map.createTileL(x, y, z);
+	delta->has_ground = has_ground != 0;
+
+	if (has_creature) {
+		std::string name;
+		uint32_t spawntime;
+		uint8_t direction, selected;
+		if (!node->getString(name) || !node->getU32(spawntime) || !node->getU8(direction) || !node->getU8(selected) || direction > DIRECTION_LAST) {
+			delete delta;
+			return nullptr;
+		}
+		delta->creature = newd Creature(name);
+		delta->creature->setSpawnTime(spawntime);
+		delta->creature->setDirection(Direction(direction));
+		if (selected) {
+			delta->creature->select();
+		}
+	}
+
+	if (!node->getU8(has_spawn)) {
+		delete delta;
+		return nullptr;
+	}
+	if (has_spawn) {
+		uint32_t size;
+		uint8_t selected;
+		if (!node->getU32(size) || !node->getU8(selected)) {
+			delete delta;
+			return nullptr;
+		}
+		delta->spawn = newd Spawn(size);
+		if (selected) {
+			delta->spawn->select();
+		}
+	}
+
+	uint32_t count;
+	if (!node->getU32(count)) {
+		delete delta;
+		return nullptr;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		uint16_t base_index, id;
+		uint8_t selected;
+		if (!node->getU16(base_index) || !node->getU16(id) || !node->getU8(selected)) {
+			delete delta;
+			return nullptr;
+		}
+		delta->entries.push_back(Entry { base_index, id, selected != 0, nullptr });
+	}
+
+	// The items that are not in the base tile follow as child nodes, in order
+	BinaryNode* child = node->getChild();
+	for (Entry& entry : delta->entries) {
+		if (entry.base_index != NotInBase) {
+			continue;
+		}
+
+		uint8_t type;
+		if (!child || !child->getByte(type) || type != OTBM_ITEM) {
+			delete delta;
+			return nullptr;
+		}
+
+		entry.item = Item::Create_OTBM(iomap, child);
+		if (!entry.item || !entry.item->unserializeItemNode_OTBM(iomap, child)) {
+			delete delta;
+			return nullptr;
+		}
+		if (entry.selected) {
+			entry.item->select();
+		} else {
+			entry.item->deselect();
+		}
+		child = child->advance();
+	}
+	return delta;
+}
+
+LeafTiles::LeafTiles(int x, int y, int z) :
+	x(x & ~3),
+	y(y & ~3),
+	z(z),
+	mask(0),
+	tiles {} {
+	////
+}
+
+LeafTiles::~LeafTiles() {
+	for (Tile* tile : tiles) {
+		delete tile;
+	}
+}
+
+int LeafTiles::getTileCount() const {
+	int count = 0;
+	for (int i = 0; i < 16; ++i) {
+		if (mask & (1 << i)) {
+			++count;
+		}
+	}
+	return count;
+}
+
+uint32_t LeafTiles::memsize() const {
+	uint32_t mem = sizeof(*this);
+	for (const Tile* tile : tiles) {
+		if (tile) {
+			mem += tile->memsize();
+		}
+	}
+	return mem;
+}
+
 Change::Change() :
 	type(CHANGE_NONE), data(nullptr) {
 	////
@@ -34,6 +330,12 @@ Change::Change(Tile* t) :
 	data = t;
 }
 
+Change::Change(LeafTiles* leaf) :
+	type(CHANGE_LEAF_TILES) {
+	ASSERT(leaf);
+	data = leaf;
+}
+
 Change* Change::Create(House* house, const Position& where) {
 	Change* c = newd Change();
 	c->type = CHANGE_MOVE_HOUSE_EXIT;
@@ -64,6 +366,14 @@ void Change::clear() {
 			ASSERT(data);
 			delete reinterpret_cast<Tile*>(data);
 			break;
+		case CHANGE_TILE_DELTA:
+			ASSERT(data);
+			delete reinterpret_cast<TileDelta*>(data);
+			break;
+		case CHANGE_LEAF_TILES:
+			ASSERT(data);
+			delete reinterpret_cast<LeafTiles*>(data);
+			break;
 		case CHANGE_MOVE_HOUSE_EXIT:
 			ASSERT(data);
 			delete reinterpret_cast<std::pair<uint32_t, Position>*>(data);
@@ -93,12 +403,34 @@ uint32_t Change::memsize() const {
 			ASSERT(data);
 			mem += reinterpret_cast<Tile*>(data)->memsize();
 			break;
+		case CHANGE_TILE_DELTA:
+			ASSERT(data);
+			mem += reinterpret_cast<TileDelta*>(data)->memsize();
+			break;
+		case CHANGE_LEAF_TILES:
+			ASSERT(data);
+			mem += reinterpret_cast<LeafTiles*>(data)->memsize();
+			break;
 		default:
 			break;
 	}
 	return mem;
 }
 
+void Change::compact(const Tile* base) {
+	ASSERT(type == CHANGE_TILE && data);
+	data = newd TileDelta(reinterpret_cast<Tile*>(data), base);
+	type = CHANGE_TILE_DELTA;
+}
+
+void Change::expand(BaseMap& map) {
+	ASSERT(type == CHANGE_TILE_DELTA && data);
+	TileDelta* delta = reinterpret_cast<TileDelta*>(data);
+	data = delta->restore(map, map.getTile(delta->getPosition()));
+	type = CHANGE_TILE;
+	delete delta;
+}
+
 Action::Action(Editor& editor, ActionIdentifier ident) :
 	commited(false),
 	editor(editor),
@@ -115,7 +447,17 @@ Action::~Action() {
 
 size_t Action::approx_memsize() const {
 	uint32_t mem = sizeof(*this);
-	mem += changes.size() * (sizeof(Change) + sizeof(Tile) + sizeof(Item) + 6 /* approx overhead*/);
+	for (const Change* c : changes) {
+		mem += sizeof(Change) + 6 /* approx overhead*/;
+		// Deltas are often much smaller than a whole tile, so they are counted as they are
+		if (c->type == CHANGE_TILE_DELTA) {
+			mem += reinterpret_cast<const TileDelta*>(c->data)->memsize();
+		} else if (c->type == CHANGE_LEAF_TILES) {
+			mem += sizeof(LeafTiles) + reinterpret_cast<const LeafTiles*>(c->data)->getTileCount() * (sizeof(Tile) + sizeof(Item));
+		} else {
+			mem += sizeof(Tile) + sizeof(Item);
+		}
+	}
 	return mem;
 }
 
@@ -132,6 +474,18 @@ size_t Action::memsize() const {
 				break;
 			}
 
+			case CHANGE_TILE_DELTA: {
+				ASSERT(c->data);
+				mem += reinterpret_cast<TileDelta*>(c->data)->memsize();
+				break;
+			}
+
+			case CHANGE_LEAF_TILES: {
+				ASSERT(c->data);
+				mem += reinterpret_cast<LeafTiles*>(c->data)->memsize();
+				break;
+			}
+
 			default:
 				break;
 		}
@@ -141,10 +495,17 @@ size_t Action::memsize() const {
 }
 
 void Action::commit(DirtyList* dirty_list) {
+	// The live client sends the tiles of the changes as they are
+	const bool compact = !editor.IsLive();
+
 	editor.selection.start(Selection::INTERNAL);
 	ChangeList::const_iterator it = changes.begin();
 	while (it != changes.end()) {
 		Change* c = *it;
+		if (c->type == CHANGE_TILE_DELTA) {
+			c->expand(editor.map);
+		}
+
 		switch (c->type) {
 			case CHANGE_TILE: {
 				void** data = &c->data;
@@ -164,6 +525,7 @@ void Action::commit(DirtyList* dirty_list) {
 
 				Tile* oldtile = editor.map.swapTile(pos, newtile);
 				TileLocation* location = newtile->getLocation();
+				editor.minimap_cache.invalidate(pos);
 
 				// Update other nodes in the network
 				if (editor.IsLiveServer() && dirty_list) {
@@ -205,9 +567,8 @@ void Action::commit(DirtyList* dirty_list) {
 					}
 
 					// oldtile->update();
-					if (oldtile->isSelected()) {
-						editor.selection.removeInternal(oldtile);
-					}
+					// Always removed, a compacted tile is deleted
+					editor.selection.removeInternal(oldtile);
 
 					*data = oldtile;
 				} else {
@@ -227,6 +588,11 @@ void Action::commit(DirtyList* dirty_list) {
 				// Mark the tile as modified
 				newtile->modify();
 
+				// Only keep what differs from the tile now on the map
+				if (compact) {
+					c->compact(newtile);
+				}
+
 				// Update client dirty list
 				if (editor.IsLiveClient() && dirty_list && type != ACTION_REMOTE) {
 					// Local action, assemble changes
@@ -235,6 +601,11 @@ void Action::commit(DirtyList* dirty_list) {
 				break;
 			}
 
+			case CHANGE_LEAF_TILES: {
+				swapLeafTiles(reinterpret_cast<LeafTiles*>(c->data), dirty_list);
+				break;
+			}
+
 			case CHANGE_MOVE_HOUSE_EXIT: {
 				std::pair<uint32_t, Position>* p = reinterpret_cast<std::pair<uint32_t, Position>*>(c->data);
 				ASSERT(p);
@@ -269,7 +640,7 @@ void Action::commit(DirtyList* dirty_list) {
 
 					// Update shit
 					Position oldpos = wp->pos;
-					wp->pos = p->second;
+					editor.map.waypoints.moveWaypoint(wp, p->second);
 					p->second = oldpos;
 				}
 				break;
@@ -289,11 +660,17 @@ void Action::undo(DirtyList* dirty_list) {
 		return;
 	}
 
+	const bool compact = !editor.IsLive();
+
 	editor.selection.start(Selection::INTERNAL);
 	ChangeList::reverse_iterator it = changes.rbegin();
 
 	while (it != changes.rend()) {
 		Change* c = *it;
+		if (c->type == CHANGE_TILE_DELTA) {
+			c->expand(editor.map);
+		}
+
 		switch (c->type) {
 			case CHANGE_TILE: {
 				void** data = &c->data;
@@ -312,6 +689,7 @@ void Action::undo(DirtyList* dirty_list) {
 				}
 
 				Tile* newtile = editor.map.swapTile(pos, oldtile);
+				editor.minimap_cache.invalidate(pos);
 
 				// Update server side change list (for broadcast)
 				if (editor.IsLiveServer() && dirty_list) {
@@ -321,9 +699,8 @@ void Action::undo(DirtyList* dirty_list) {
 				if (oldtile->isSelected()) {
 					editor.selection.addInternal(oldtile);
 				}
-				if (newtile->isSelected()) {
-					editor.selection.removeInternal(newtile);
-				}
+				// Always removed, a compacted tile is deleted
+				editor.selection.removeInternal(newtile);
 
 				if (newtile->getHouseID() != oldtile->getHouseID()) {
 					// oooooomggzzz we need to remove it from the appropriate house!
@@ -354,6 +731,9 @@ void Action::undo(DirtyList* dirty_list) {
 					editor.map.removeSpawn(newtile);
 				}
 				*data = newtile;
+				if (compact) {
+					c->compact(oldtile);
+				}
 
 				// Update client dirty list
 				if (editor.IsLiveClient() && dirty_list && type != ACTION_REMOTE) {
@@ -363,6 +743,11 @@ void Action::undo(DirtyList* dirty_list) {
 				break;
 			}
 
+			case CHANGE_LEAF_TILES: {
+				swapLeafTiles(reinterpret_cast<LeafTiles*>(c->data), dirty_list);
+				break;
+			}
+
 			case CHANGE_MOVE_HOUSE_EXIT: {
 				std::pair<uint32_t, Position>* p = reinterpret_cast<std::pair<uint32_t, Position>*>(c->data);
 				ASSERT(p);
@@ -398,7 +783,7 @@ void Action::undo(DirtyList* dirty_list) {
 
 					// Update shit
 					Position oldpos = wp->pos;
-					wp->pos = p->second;
+					editor.map.waypoints.moveWaypoint(wp, p->second);
 					p->second = oldpos;
 				}
 				break;
@@ -413,6 +798,61 @@ void Action::undo(DirtyList* dirty_list) {
 	commited = false;
 }
 
+void Action::swapLeafTiles(LeafTiles* leaf, DirtyList* dirty_list) {
+	QTreeNode* node = editor.map.getLeaf(leaf->x, leaf->y);
+	ASSERT(node);
+
+	node->swapTiles(leaf->x, leaf->y, leaf->z, leaf->mask, leaf->tiles);
+	editor.minimap_cache.invalidate(leaf->getPosition());
+	if (editor.IsLiveServer() && dirty_list) {
+		dirty_list->AddPosition(leaf->x, leaf->y, leaf->z);
+	}
+
+	// The leaf now holds the tiles that were on the map
+	for (int i = 0; i < 16; ++i) {
+		if (!(leaf->mask & (1 << i))) {
+			continue;
+		}
+
+		Tile* oldtile = leaf->tiles[i];
+		Tile* newtile = node->getTile(leaf->x + (i >> 2), leaf->y + (i & 3), leaf->z)->get();
+		const uint32_t old_house = oldtile ? oldtile->getHouseID() : 0;
+		const uint32_t new_house = newtile ? newtile->getHouseID() : 0;
+		if (old_house != new_house) {
+			House* house = editor.map.houses.getHouse(old_house);
+			if (house) {
+				house->removeTile(oldtile);
+			}
+			house = editor.map.houses.getHouse(new_house);
+			if (house) {
+				house->addTile(newtile);
+			}
+		}
+
+		Spawn* old_spawn = oldtile ? oldtile->spawn : nullptr;
+		Spawn* new_spawn = newtile ? newtile->spawn : nullptr;
+		if (old_spawn != new_spawn && (!old_spawn || !new_spawn || *old_spawn != *new_spawn)) {
+			if (old_spawn) {
+				editor.map.removeSpawn(oldtile);
+			}
+			if (new_spawn) {
+				editor.map.addSpawn(newtile);
+			}
+		}
+
+		if (oldtile) {
+			editor.selection.removeInternal(oldtile);
+		}
+		if (newtile) {
+			if (newtile->isSelected()) {
+				editor.selection.addInternal(newtile);
+			}
+			newtile->update();
+			newtile->modify();
+		}
+	}
+}
+
 BatchAction::BatchAction(Editor& editor, ActionIdentifier ident) :
 	editor(editor),
 	timestamp(0),
@@ -569,21 +1009,7 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		actions.pop_back();
 		delete todelete;
 	}
-
-	while (memory_size > size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE)) && !actions.empty()) {
-		memory_size -= actions.front()->memsize();
-		delete actions.front();
-		actions.pop_front();
-		current--;
-	}
-
-	if (actions.size() > size_t(g_settings.getInteger(Config::UNDO_SIZE)) && !actions.empty()) {
-		memory_size -= actions.front()->memsize();
-		BatchAction* todelete = actions.front();
-		actions.pop_front();
-		delete todelete;
-		current--;
-	}
+	redo_spill.clear();
 
 	do {
 		if (!actions.empty()) {
@@ -602,6 +1028,8 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		batch->timestamp = time(nullptr);
 		current++;
 	} while (false);
+
+	trim();
 }
 
 void ActionQueue::addAction(Action* action, int stacking_delay) {
@@ -616,19 +1044,25 @@ void ActionQueue::addAction(Action* action, int stacking_delay) {
 }
 
 void ActionQueue::undo() {
-	if (current > 0) {
-		current--;
-		BatchAction* batch = actions[current];
-		batch->undo();
+	if (current == 0 && !loadOldest()) {
+		return;
 	}
+
+	current--;
+	BatchAction* batch = actions[current];
+	batch->undo();
+	trim();
 }
 
 void ActionQueue::redo() {
-	if (current < actions.size()) {
-		BatchAction* batch = actions[current];
-		batch->redo();
-		current++;
+	if (current == actions.size() && !loadNewest()) {
+		return;
 	}
+
+	BatchAction* batch = actions[current];
+	batch->redo();
+	current++;
+	trim();
 }
 
 void ActionQueue::clear() {
@@ -637,40 +1071,248 @@ void ActionQueue::clear() {
 		it = actions.erase(it);
 	}
 	current = 0;
+	memory_size = 0;
+	undo_spill.clear();
+	redo_spill.clear();
 }
 
-DirtyList::DirtyList() :
-	owner(0) {
-	;
+bool ActionQueue::isOverLimit() const {
+	return memory_size > size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE)) || actions.size() > size_t(g_settings.getInteger(Config::UNDO_SIZE));
 }
 
-DirtyList::~DirtyList() {
-	;
+void ActionQueue::trim() {
+	while (actions.size() > 1 && isOverLimit()) {
+		if (actions.size() > current + 1) {
+			spillNewest();
+		} else {
+			spillOldest();
+		}
+	}
 }
 
-void DirtyList::AddPosition(int x, int y, int z) {
-	uint32_t m = ((x >> 2) << 18) | ((y >> 2) << 4);
-	ValueType fi = { m, 0 };
-	SetType::iterator s = iset.find(fi);
-	if (s != iset.end()) {
-		ValueType v = *s;
-		iset.erase(s);
-		v.floors = (1 << z) | v.floors;
-		iset.insert(v);
+void ActionQueue::spillOldest() {
+	ASSERT(current > 0);
+	BatchAction* batch = actions.front();
+	actions.pop_front();
+	memory_size -= batch->memsize();
+	current--;
+
+	std::vector<uint8_t> data;
+	if (canSpill(batch) && writeBatch(batch, data) && undo_spill.push(data.data(), data.size())) {
+		const uint64_t limit = uint64_t(g_settings.getInteger(Config::UNDO_DISK_SIZE)) * 1024 * 1024;
+		while (undo_spill.getDiskSize() > limit) {
+			undo_spill.dropOldest();
+		}
+	} else {
+		// The older batches can not be undone without this one
+		undo_spill.clear();
+	}
+	delete batch;
+}
+
+void ActionQueue::spillNewest() {
+	BatchAction* batch = actions.back();
+	actions.pop_back();
+	memory_size -= batch->memsize();
+
+	std::vector<uint8_t> data;
+	if (canSpill(batch) && writeBatch(batch, data) && redo_spill.push(data.data(), data.size())) {
+		const uint64_t limit = uint64_t(g_settings.getInteger(Config::UNDO_DISK_SIZE)) * 1024 * 1024;
+		while (redo_spill.getDiskSize() > limit) {
+			redo_spill.dropOldest();
+		}
 	} else {
-		ValueType v = { m, (uint32_t)(1 << z) };
-		iset.insert(v);
+		// The newer batches can not be redone without this one
+		redo_spill.clear();
 	}
+	delete batch;
 }
 
-void DirtyList::AddChange(Change* c) {
-	ichanges.push_back(c);
+bool ActionQueue::loadOldest() {
+	if (undo_spill.empty()) {
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	BatchAction* batch = undo_spill.pop(data) ? readBatch(data) : nullptr;
+	if (!batch) {
+		undo_spill.clear();
+		return false;
+	}
+
+	actions.push_front(batch);
+	memory_size += batch->memsize(true);
+	current++;
+	return true;
+}
+
+bool ActionQueue::loadNewest() {
+	if (redo_spill.empty()) {
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	BatchAction* batch = redo_spill.pop(data) ? readBatch(data) : nullptr;
+	if (!batch) {
+		redo_spill.clear();
+		return false;
+	}
+
+	actions.push_back(batch);
+	memory_size += batch->memsize(true);
+	return true;
 }
 
-DirtyList::SetType& DirtyList::GetPosList() {
-	return iset;
+bool ActionQueue::canSpill(const BatchAction* batch) const {
+	// Full tiles are only kept in live sessions, where the history stays in memory
+	if (editor.IsLive() || g_settings.getInteger(Config::UNDO_DISK_SIZE) <= 0) {
+		return false;
+	}
+
+	for (const Action* action : batch->batch) {
+		for (const Change* change : action->changes) {
+			switch (change->type) {
+				case CHANGE_NONE:
+				case CHANGE_TILE_DELTA:
+				case CHANGE_MOVE_HOUSE_EXIT:
+				case CHANGE_MOVE_WAYPOINT:
+					break;
+				default:
+					return false;
+			}
+		}
+	}
+	return true;
 }
 
-ChangeList& DirtyList::GetChanges() {
-	return ichanges;
+bool ActionQueue::writeBatch(const BatchAction* batch, std::vector<uint8_t>& data) const {
+	VirtualIOMap iomap(MapVersion(MAP_OTBM_4, CLIENT_VERSION_NONE));
+	MemoryNodeFileWriteHandle writer;
+
+	writer.addNode(batch->type);
+	for (const Action* action : batch->batch) {
+		writer.addNode(action->type);
+		writer.addU8(action->commited);
+		for (const Change* change : action->changes) {
+			switch (change->type) {
+				case CHANGE_TILE_DELTA: {
+					writer.addNode(CHANGE_TILE_DELTA);
+					if (!reinterpret_cast<const TileDelta*>(change->data)->serialize(iomap, writer)) {
+						return false;
+					}
+					writer.endNode();
+					break;
+				}
+
+				case CHANGE_MOVE_HOUSE_EXIT: {
+					const std::pair<uint32_t, Position>* p = reinterpret_cast<const std::pair<uint32_t, Position>*>(change->data);
+					writer.addNode(CHANGE_MOVE_HOUSE_EXIT);
+					writer.addU32(p->first);
+					writer.addU16(p->second.x);
+					writer.addU16(p->second.y);
+					writer.addU8(p->second.z);
+					writer.endNode();
+					break;
+				}
+
+				case CHANGE_MOVE_WAYPOINT: {
+					const std::pair<std::string, Position>* p = reinterpret_cast<const std::pair<std::string, Position>*>(change->data);
+					writer.addNode(CHANGE_MOVE_WAYPOINT);
+					writer.addString(p->first);
+					writer.addU16(p->second.x);
+					writer.addU16(p->second.y);
+					writer.addU8(p->second.z);
+					writer.endNode();
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+		writer.endNode();
+	}
+	writer.endNode();
+
+	if (writer.error_code != FILE_NO_ERROR) {
+		return false;
+	}
+	data.assign(writer.getMemory(), writer.getMemory() + writer.getSize());
+	return true;
+}
+
+BatchAction* ActionQueue::readBatch(const std::vector<uint8_t>& data) {
+	VirtualIOMap iomap(MapVersion(MAP_OTBM_4, CLIENT_VERSION_NONE));
+	MemoryNodeFileReadHandle reader(data.data(), data.size());
+
+	BinaryNode* root = reader.getRootNode();
+	uint8_t batch_type;
+	if (!root || !root->getU8(batch_type)) {
+		return nullptr;
+	}
+
+	BatchAction* batch = createBatch(ActionIdentifier(batch_type));
+	for (BinaryNode* action_node = root->getChild(); action_node; action_node = action_node->advance()) {
+		uint8_t action_type, commited;
+		if (!action_node->getU8(action_type) || !action_node->getU8(commited)) {
+			delete batch;
+			return nullptr;
+		}
+
+		Action* action = createAction(ActionIdentifier(action_type));
+		action->commited = commited != 0;
+		batch->batch.push_back(action);
+
+		for (BinaryNode* change_node = action_node->getChild(); change_node; change_node = change_node->advance()) {
+			uint8_t change_type;
+			if (!change_node->getU8(change_type)) {
+				delete batch;
+				return nullptr;
+			}
+
+			Change* change = newd Change();
+			action->changes.push_back(change);
+			switch (change_type) {
+				case CHANGE_TILE_DELTA: {
+					change->data = TileDelta::Unserialize(editor.map, iomap, change_node);
+					break;
+				}
+
+				case CHANGE_MOVE_HOUSE_EXIT: {
+					uint32_t id;
+					uint16_t x, y;
+					uint8_t z;
+					if (change_node->getU32(id) && change_node->getU16(x) && change_node->getU16(y) && change_node->getU8(z)) {
+						change->data = newd std::pair<uint32_t, Position>(id, Position(x, y, z));
+					}
+					break;
+				}
+
+				case CHANGE_MOVE_WAYPOINT: {
+					std::string name;
+					uint16_t x, y;
+					uint8_t z;
+					if (change_node->getString(name) && change_node->getU16(x) && change_node->getU16(y) && change_node->getU8(z)) {
+						change->data = newd std::pair<std::string, Position>(name, Position(x, y, z));
+					}
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			if (!change->data) {
+				delete batch;
+				return nullptr;
+			}
+			change->type = ChangeType(change_type);
+		}
+	}
+
+	if (reader.error_code != FILE_NO_ERROR) {
+		delete batch;
+		return nullptr;
+	}
+	return batch;
 }
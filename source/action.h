@@ -19,11 +19,22 @@
 #define RME_ACTION_H_
 
 #include "position.h"
+#include "action_spill.h"
+#include "dirty_list.h"
 
 #include <deque>
 
 class Editor;
+class BaseMap;
 class Tile;
+class TileLocation;
+class QTreeNode;
+class Item;
+class Creature;
+class Spawn;
+class IOMap;
+class BinaryNode;
+class NodeFileWriteHandle;
 class House;
 class Waypoint;
 class Change;
@@ -34,10 +45,89 @@ class ActionQueue;
 enum ChangeType {
 	CHANGE_NONE,
 	CHANGE_TILE,
+	CHANGE_TILE_DELTA,
+	CHANGE_LEAF_TILES,
 	CHANGE_MOVE_HOUSE_EXIT,
 	CHANGE_MOVE_WAYPOINT,
 };
 
+// A tile stored as its differences to the tile at the same position on the map.
+// Undo and redo run in order, so that tile is the same again when the delta is
+// turned back into a tile. Plain items that are also on the map tile are only
+// stored as their index and ID there.
+class TileDelta {
+public:
+	// Takes what differs out of tile and deletes the rest of it
+	TileDelta(Tile* tile, const Tile* base);
+	~TileDelta();
+
+	TileDelta(const TileDelta&) = delete;
+	TileDelta& operator=(const TileDelta&) = delete;
+
+	// The tile again, base must be the tile the delta was made against
+	Tile* restore(BaseMap& map, const Tile* base);
+
+	Position getPosition() const;
+	uint32_t memsize() const;
+
+	// Items that are not in the base tile are written as OTBM item nodes
+	bool serialize(const IOMap& iomap, NodeFileWriteHandle& writer) const;
+	static TileDelta* Unserialize(BaseMap& map, const IOMap& iomap, BinaryNode* node);
+
+private:
+	TileDelta();
+
+	static const uint16_t NotInBase = 0xFFFF;
+
+	struct Entry {
+		// 0 is the ground of the base tile, n its item n - 1
+		uint16_t base_index;
+		// Checked against the base item, made anew if it does not match
+		uint16_t id;
+		bool selected;
+		// Only set if the item is not in the base tile
+		Item* item;
+	};
+
+	TileLocation* location;
+	uint16_t mapflags;
+	uint16_t statflags;
+	uint32_t house_id;
+	Creature* creature;
+	Spawn* spawn;
+	bool has_ground;
+	// The ground first if there is one, then the items
+	std::vector<Entry> entries;
+};
+
+// Tiles of one floor of a map leaf (4x4 tiles) that are swapped with the map
+// in one step. Only the offsets in mask are part of the change, a null tile
+// leaves its location empty.
+class LeafTiles {
+public:
+	LeafTiles(int x, int y, int z);
+	~LeafTiles();
+
+	LeafTiles(const LeafTiles&) = delete;
+	LeafTiles& operator=(const LeafTiles&) = delete;
+
+	void setTile(int index, Tile* tile) {
+		tiles[index] = tile;
+		mask |= 1 << index;
+	}
+	int getTileCount() const;
+
+	Position getPosition() const {
+		return Position(x, y, z);
+	}
+	uint32_t memsize() const;
+
+	int x, y, z;
+	uint16_t mask;
+	// Indexed like the locations of a floor, (x & 3) * 4 + (y & 3)
+	Tile* tiles[16];
+};
+
 class Change {
 private:
 	ChangeType type;
@@ -47,6 +137,7 @@ private:
 
 public:
 	Change(Tile* tile);
+	Change(LeafTiles* leaf);
 	static Change* Create(House* house, const Position& where);
 	static Change* Create(Waypoint* wp, const Position& where);
 	~Change();
@@ -62,45 +153,14 @@ public:
 	// Get memory footprint
 	uint32_t memsize() const;
 
-	friend class Action;
-};
-
-typedef std::vector<Change*> ChangeList;
-
-// A dirty list represents a list of all tiles that was changed in an action
-class DirtyList {
-public:
-	DirtyList();
-	~DirtyList();
-
-	struct ValueType {
-		uint32_t pos;
-		uint32_t floors;
-	};
-
-	uint32_t owner;
-
 protected:
-	struct Comparator {
-		bool operator()(const ValueType& a, const ValueType& b) const {
-			return a.pos < b.pos;
-		}
-	};
+	// Stores the tile as a TileDelta against base, the tile now on the map
+	void compact(const Tile* base);
+	// Turns a compacted tile back into a tile
+	void expand(BaseMap& map);
 
-public:
-	typedef std::set<ValueType, Comparator> SetType;
-
-	void AddPosition(int x, int y, int z);
-	void AddChange(Change* c);
-	bool Empty() const {
-		return iset.empty() && ichanges.empty();
-	}
-	SetType& GetPosList();
-	ChangeList& GetChanges();
-
-protected:
-	SetType iset;
-	ChangeList ichanges;
+	friend class Action;
+	friend class ActionQueue;
 };
 
 enum ActionIdentifier {
@@ -149,6 +209,10 @@ public:
 protected:
 	Action(Editor& editor, ActionIdentifier ident);
 
+	// Puts the tiles of the leaf on the map and keeps the ones that were there,
+	// so commit and undo both just swap them
+	void swapLeafTiles(LeafTiles* leaf, DirtyList* dirty_list);
+
 	bool commited;
 	ChangeList changes;
 	Editor& editor;
@@ -218,17 +282,38 @@ public:
 	void clear();
 
 	bool canUndo() {
-		return current > 0;
+		return current > 0 || !undo_spill.empty();
 	}
 	bool canRedo() {
-		return current < actions.size();
+		return current < actions.size() || !redo_spill.empty();
 	}
 
 protected:
+	bool isOverLimit() const;
+	// Keeps the batches in memory within the undo limits, the batches
+	// furthest from the current one are spilled to disk first
+	void trim();
+
+	// Moves the oldest/newest batch in memory to disk, deletes it if that is
+	// not possible (along with what is past it on disk)
+	void spillOldest();
+	void spillNewest();
+	// Reads the batch next to the oldest/newest in memory back from disk
+	bool loadOldest();
+	bool loadNewest();
+
+	bool canSpill(const BatchAction* batch) const;
+	bool writeBatch(const BatchAction* batch, std::vector<uint8_t>& data) const;
+	BatchAction* readBatch(const std::vector<uint8_t>& data);
+
 	size_t current;
 	size_t memory_size;
 	Editor& editor;
 	ActionList actions;
+
+	// Batches older than actions.front() and newer than actions.back()
+	ActionSpillFile undo_spill;
+	ActionSpillFile redo_spill;
 };
 
 #endif
@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "action_spill.h"
+
+#include <wx/filename.h>
+
+#include <zlib.h>
+
+ActionSpillFile::ActionSpillFile() :
+	disk_size(0) {
+	////
+}
+
+ActionSpillFile::~ActionSpillFile() {
+	if (file.IsOpened()) {
+		file.Close();
+	}
+	if (!filename.empty()) {
+		wxRemoveFile(filename);
+	}
+}
+
+bool ActionSpillFile::open() {
+	if (file.IsOpened()) {
+		return true;
+	}
+
+	filename = wxFileName::CreateTempFileName("rme-undo");
+	if (filename.empty()) {
+		return false;
+	}
+	return file.Open(filename, wxFile::read_write);
+}
+
+bool ActionSpillFile::push(const uint8_t* data, size_t size) {
+	if (size > 0xFFFFFFFF || !open()) {
+		return false;
+	}
+
+	std::vector<uint8_t> compressed(compressBound(size));
+	uLongf compressed_size = compressed.size();
+	if (compress2(compressed.data(), &compressed_size, data, size, Z_BEST_SPEED) != Z_OK) {
+		return false;
+	}
+
+	// Blocks that were popped are written over
+	const wxFileOffset offset = blocks.empty() ? 0 : blocks.back().offset + blocks.back().size;
+	if (file.Seek(offset) != offset || file.Write(compressed.data(), compressed_size) != compressed_size) {
+		return false;
+	}
+
+	blocks.push_back(Block { offset, uint32_t(compressed_size), uint32_t(size) });
+	disk_size += compressed_size;
+	return true;
+}
+
+bool ActionSpillFile::pop(std::vector<uint8_t>& data) {
+	if (blocks.empty()) {
+		return false;
+	}
+
+	const Block block = blocks.back();
+	blocks.pop_back();
+	disk_size -= block.size;
+
+	std::vector<uint8_t> compressed(block.size);
+	if (file.Seek(block.offset) != block.offset || file.Read(compressed.data(), block.size) != ssize_t(block.size)) {
+		return false;
+	}
+
+	data.resize(block.raw_size);
+	uLongf size = data.size();
+	return uncompress(data.data(), &size, compressed.data(), compressed.size()) == Z_OK && size == data.size();
+}
+
+void ActionSpillFile::dropOldest() {
+	if (blocks.empty()) {
+		return;
+	}
+
+	disk_size -= blocks.front().size;
+	blocks.pop_front();
+
+	if (!blocks.empty() && uint64_t(blocks.front().offset) > disk_size && !compact()) {
+		clear();
+	}
+}
+
+void ActionSpillFile::clear() {
+	blocks.clear();
+	disk_size = 0;
+	if (file.IsOpened()) {
+		file.Close();
+		wxRemoveFile(filename);
+		filename.clear();
+	}
+}
+
+bool ActionSpillFile::compact() {
+	// Blocks only move towards the start, so they can be copied in order
+	std::vector<uint8_t> buffer;
+	wxFileOffset offset = 0;
+	for (Block& block : blocks) {
+		buffer.resize(block.size);
+		if (file.Seek(block.offset) != block.offset || file.Read(buffer.data(), block.size) != ssize_t(block.size)) {
+			return false;
+		}
+		if (file.Seek(offset) != offset || file.Write(buffer.data(), block.size) != block.size) {
+			return false;
+		}
+		block.offset = offset;
+		offset += block.size;
+	}
+	return true;
+}
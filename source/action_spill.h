@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ACTION_SPILL_H_
+#define RME_ACTION_SPILL_H_
+
+#include <wx/file.h>
+
+#include <deque>
+#include <vector>
+
+// A stack of compressed blocks in a temporary file, used to keep undo history
+// that does not fit in memory. The file is created on the first push and
+// removed with the object.
+class ActionSpillFile {
+public:
+	ActionSpillFile();
+	~ActionSpillFile();
+
+	ActionSpillFile(const ActionSpillFile&) = delete;
+	ActionSpillFile& operator=(const ActionSpillFile&) = delete;
+
+	bool push(const uint8_t* data, size_t size);
+	// Takes the last block pushed
+	bool pop(std::vector<uint8_t>& data);
+	// Forgets the first block pushed
+	void dropOldest();
+	void clear();
+
+	bool empty() const {
+		return blocks.empty();
+	}
+	size_t count() const {
+		return blocks.size();
+	}
+	// Bytes used by the blocks still on the stack
+	uint64_t getDiskSize() const {
+		return disk_size;
+	}
+
+private:
+	struct Block {
+		wxFileOffset offset;
+		uint32_t size;
+		uint32_t raw_size;
+	};
+
+	bool open();
+	// Moves the blocks to the start of the file once the dropped ones take more space
+	bool compact();
+
+	wxFile file;
+	wxString filename;
+	std::deque<Block> blocks;
+	uint64_t disk_size;
+};
+
+#endif
@@ -33,6 +33,8 @@
 #include "materials.h"
 #include "map.h"
 #include "complexitem.h"
+#include "iomap_otbm.h"
+#include "software_renderer.h"
 #include "creature.h"
 
 #include <wx/snglinst.h>
@@ -110,10 +112,14 @@ bool Application::OnInit() {
 	wxAppConsole::SetInstance(this);
 	wxArtProvider::Push(new ArtProvider());
 
+	m_export_image = argc > 1 && argv[1] == "-export-image";
+
 #if defined(__LINUX__) || defined(__WINDOWS__)
-	int argc = 1;
-	char* argv[1] = { wxString(this->argv[0]).char_str() };
-	glutInit(&argc, argv);
+	if (!m_export_image) {
+		int argc = 1;
+		char* argv[1] = { wxString(this->argv[0]).char_str() };
+		glutInit(&argc, argv);
+	}
 #endif
 
 	// Load some internal stuff
@@ -122,6 +128,11 @@ bool Application::OnInit() {
 	g_gui.LoadHotkeys();
 	ClientVersion::loadVersions();
 
+	if (m_export_image) {
+		// Done in OnRun, without windows or an event loop
+		return true;
+	}
+
 #ifdef _USE_PROCESS_COM
 	m_single_instance_checker = newd wxSingleInstanceChecker; // Instance checker has to stay alive throughout the applications lifetime
 	if (g_settings.getInteger(Config::ONLY_ONE_INSTANCE) && m_single_instance_checker->IsAnotherRunning()) {
@@ -267,6 +278,13 @@ bool Application::OnInit() {
 	return true;
 }
 
+int Application::OnRun() {
+	if (m_export_image) {
+		return ExportImage();
+	}
+	return wxApp::OnRun();
+}
+
 void Application::OnEventLoopEnter(wxEventLoopBase* loop) {
 
 	// First startup?
@@ -354,6 +372,68 @@ bool Application::ParseCommandLineMap(wxString& fileName) {
 	return false;
 }
 
+int Application::ExportImage() {
+	if (argc != 9) {
+		std::cerr << "Usage: rme -export-image <map> <png> <from x> <from y> <to x> <to y> <floor>" << std::endl;
+		std::cerr << "Renders an area of a map to a PNG file without opening any window." << std::endl;
+		std::cerr << "wxWidgets still needs a display to start, without one run it under a" << std::endl;
+		std::cerr << "virtual display, e.g. xvfb-run rme -export-image ..." << std::endl;
+		return 1;
+	}
+
+	const FileName map_file(argv[2]);
+	const std::string image_file = nstr(argv[3]);
+
+	long coordinates[5];
+	for (int i = 0; i < 5; ++i) {
+		if (!argv[4 + i].ToLong(&coordinates[i])) {
+			std::cerr << "Invalid coordinate: " << argv[4 + i] << std::endl;
+			return 1;
+		}
+	}
+	const int floor = coordinates[4];
+	if (floor < 0 || floor > MAP_MAX_LAYER) {
+		std::cerr << "Invalid floor: " << floor << std::endl;
+		return 1;
+	}
+	const Position from(std::min(coordinates[0], coordinates[2]), std::min(coordinates[1], coordinates[3]), floor);
+	const Position to(std::max(coordinates[0], coordinates[2]), std::max(coordinates[1], coordinates[3]), floor);
+	if (from.x < 0 || from.y < 0 || to.x > MAP_MAX_WIDTH || to.y > MAP_MAX_HEIGHT) {
+		std::cerr << "The area is outside of the map." << std::endl;
+		return 1;
+	}
+
+	MapVersion version;
+	if (!IOMapOTBM::getVersionInfo(map_file, version)) {
+		std::cerr << "Could not open file \"" << map_file.GetFullPath() << "\"." << std::endl;
+		return 1;
+	}
+
+	wxString error;
+	wxArrayString warnings;
+	if (!g_gui.LoadVersionAssets(version.client, error, warnings)) {
+		std::cerr << error << std::endl;
+		return 1;
+	}
+	for (const wxString& warning : warnings) {
+		std::cerr << warning << std::endl;
+	}
+
+	Map map;
+	if (!map.open(nstr(map_file.GetFullPath()))) {
+		std::cerr << map.getError() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Rendering " << image_file << "..." << std::endl;
+	SoftwareRenderer renderer(map, 0);
+	if (!renderer.writePNG(image_file, from, to, nullptr)) {
+		std::cerr << renderer.getError() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
 MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& size) :
 	wxFrame((wxFrame*)nullptr, -1, title, pos, size, wxDEFAULT_FRAME_STYLE) {
 	// Receive idle events
@@ -39,6 +39,7 @@ class Application : public wxApp {
 public:
 	~Application();
 	virtual bool OnInit();
+	virtual int OnRun();
 	virtual void OnEventLoopEnter(wxEventLoopBase* loop);
 	virtual void MacOpenFiles(const wxArrayString& fileNames);
 	virtual int OnExit();
@@ -50,6 +51,12 @@ private:
 	void FixVersionDiscrapencies();
 	bool ParseCommandLineMap(wxString& fileName);
 
+	// rme -export-image <map> <png> <from x> <from y> <to x> <to y> <floor>
+	// renders an area of a map without opening any window and exits. wxWidgets
+	// still connects to the display on startup (xvfb-run works without one).
+	bool m_export_image;
+	int ExportImage();
+
 	virtual void OnFatalException();
 
 #ifdef _USE_PROCESS_COM
@@ -23,6 +23,7 @@
 BaseMap::BaseMap() :
 	allocator(),
 	tilecount(0),
+	revision(0),
 	root(*this) {
 	////
 }
@@ -117,6 +117,10 @@ public:
 	QTreeNode* createLeaf(int x, int y) {
 		return root.getLeafForce(x, y);
 	}
+	// Get the node covering the 4^(8 - depth) tiles wide area around x, y
+	QTreeNode* getNode(int x, int y, int depth) {
+		return root.getNode(x, y, depth);
+	}
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(int _x, int _y, int _z, Tile* newtile, bool remove = false);
@@ -138,12 +142,17 @@ public:
 	uint64_t getTileCount() const {
 		return tilecount;
 	}
+	// Increased every time any tile is replaced
+	uint64_t getRevision() const {
+		return revision;
+	}
 
 public:
 	MapAllocator allocator;
 
 protected:
 	uint64_t tilecount;
+	uint64_t revision;
 
 	QTreeNode root; // The Quad Tree root
 
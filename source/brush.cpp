@@ -53,6 +53,7 @@ Brushes::~Brushes() {
 }
 
 void Brushes::clear() {
+	GroundBrush::clearTransitionTable();
 	for (auto brushEntry : brushes) {
 		delete brushEntry.second;
 	}
@@ -89,6 +90,8 @@ void Brushes::init() {
 	WallBrush::init();
 	TableBrush::init();
 	CarpetBrush::init();
+
+	GroundBrush::buildTransitionTable();
 }
 
 bool Brushes::unserializeBrush(pugi::xml_node node, wxArrayString& warnings) {
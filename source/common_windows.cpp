@@ -32,8 +32,15 @@
 #include "application.h"
 #include "common_windows.h"
 #include "positionctrl.h"
+#include "map_tab.h"
+#include "map_display.h"
 #include "string_utils.h"
+#include "web_map_exporter.h"
+#include "minimap_exporter.h"
+#include "minimap_importer.h"
+#include "ground_brush.h"
 
+#include <wx/tokenzr.h>
 
 #ifdef _MSC_VER
 	#pragma warning(disable : 4018) // signed/unsigned mismatch
@@ -290,6 +297,8 @@ void MapPropertiesWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
 			}
 			map.convert(new_ver, true);
 		}
+		// The tiles were changed without actions
+		g_gui.GetCurrentEditor()->minimap_cache.clear();
 	} else {
 		map.convert(new_ver, true);
 	}
@@ -445,6 +454,192 @@ void ImportMapWindow::OnClickCancel(wxCommandEvent& WXUNUSED(event)) {
 	EndModal(0);
 }
 
+// ============================================================================
+// Import Minimap window
+
+BEGIN_EVENT_TABLE(ImportMiniMapWindow, wxDialog)
+EVT_BUTTON(MAP_WINDOW_FILE_BUTTON, ImportMiniMapWindow::OnClickBrowse)
+EVT_BUTTON(wxID_OK, ImportMiniMapWindow::OnClickOK)
+EVT_BUTTON(wxID_CANCEL, ImportMiniMapWindow::OnClickCancel)
+END_EVENT_TABLE()
+
+ImportMiniMapWindow::ImportMiniMapWindow(wxWindow* parent, Editor& editor) :
+	wxDialog(parent, wxID_ANY, "Import Minimap", wxDefaultPosition, wxSize(400, 480), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+	editor(editor) {
+	wxBoxSizer* sizer = newd wxBoxSizer(wxVERTICAL);
+	wxStaticBoxSizer* tmpsizer;
+
+	// File
+	tmpsizer = newd wxStaticBoxSizer(new wxStaticBox(this, wxID_ANY, "Minimap Image"), wxHORIZONTAL);
+	file_text_field = newd wxTextCtrl(tmpsizer->GetStaticBox(), wxID_ANY, "", wxDefaultPosition, wxSize(230, 23), wxTE_PROCESS_ENTER);
+	file_text_field->Bind(wxEVT_TEXT_ENTER, &ImportMiniMapWindow::OnFileEntered, this);
+	tmpsizer->Add(file_text_field, 1, wxALL, 5);
+	wxButton* browse_button = newd wxButton(tmpsizer->GetStaticBox(), MAP_WINDOW_FILE_BUTTON, "Browse...", wxDefaultPosition, wxSize(80, 23));
+	tmpsizer->Add(browse_button, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxEXPAND | wxLEFT | wxRIGHT | wxTOP, 5);
+
+	// Import offset
+	tmpsizer = newd wxStaticBoxSizer(new wxStaticBox(this, wxID_ANY, "Import Offset"), wxHORIZONTAL);
+	tmpsizer->Add(newd wxStaticText(tmpsizer->GetStaticBox(), wxID_ANY, "X:"), 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+	x_offset_ctrl = newd wxSpinCtrl(tmpsizer->GetStaticBox(), wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, 23), wxSP_ARROW_KEYS, 0, MAP_MAX_WIDTH);
+	tmpsizer->Add(x_offset_ctrl, 0, wxALL, 5);
+	tmpsizer->Add(newd wxStaticText(tmpsizer->GetStaticBox(), wxID_ANY, "Y:"), 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+	y_offset_ctrl = newd wxSpinCtrl(tmpsizer->GetStaticBox(), wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, 23), wxSP_ARROW_KEYS, 0, MAP_MAX_HEIGHT);
+	tmpsizer->Add(y_offset_ctrl, 0, wxALL, 5);
+	tmpsizer->Add(newd wxStaticText(tmpsizer->GetStaticBox(), wxID_ANY, "Floor:"), 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+	floor_ctrl = newd wxSpinCtrl(tmpsizer->GetStaticBox(), wxID_ANY, i2ws(GROUND_LAYER), wxDefaultPosition, wxSize(50, 23), wxSP_ARROW_KEYS, 0, MAP_MAX_LAYER, GROUND_LAYER);
+	tmpsizer->Add(floor_ctrl, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxEXPAND | wxLEFT | wxRIGHT, 5);
+
+	// Brush of each color
+	tmpsizer = newd wxStaticBoxSizer(new wxStaticBox(this, wxID_ANY, "Ground Brushes"), wxVERTICAL);
+	colors_window = newd wxScrolledWindow(tmpsizer->GetStaticBox(), wxID_ANY, wxDefaultPosition, wxSize(-1, 250));
+	colors_window->SetScrollRate(0, 10);
+	colors_sizer = newd wxFlexGridSizer(3, 5, 5);
+	colors_sizer->AddGrowableCol(2);
+	colors_window->SetSizer(colors_sizer);
+	tmpsizer->Add(colors_window, 1, wxALL | wxEXPAND, 5);
+	sizer->Add(tmpsizer, 1, wxEXPAND | wxLEFT | wxRIGHT, 5);
+
+	for (const auto& it : g_brushes.getMap()) {
+		if (it.second->isGround()) {
+			brushes.push_back(it.second->asGround());
+		}
+	}
+
+	// OK/Cancel buttons
+	wxBoxSizer* buttons = newd wxBoxSizer(wxHORIZONTAL);
+	buttons->Add(newd wxButton(this, wxID_OK, "Ok"), 0, wxALL, 5);
+	buttons->Add(newd wxButton(this, wxID_CANCEL, "Cancel"), 0, wxALL, 5);
+	sizer->Add(buttons, 0, wxCENTER);
+
+	SetSizer(sizer);
+	Layout();
+	Centre(wxBOTH);
+}
+
+ImportMiniMapWindow::~ImportMiniMapWindow() = default;
+
+// The brush names stored as "color=name;" pairs, an empty name leaves the color empty
+static std::map<int, std::string> getSavedMinimapBrushes() {
+	std::map<int, std::string> saved;
+	wxStringTokenizer tokenizer(wxstr(g_settings.getString(Config::MINIMAP_IMPORT_BRUSHES)), ";");
+	while (tokenizer.HasMoreTokens()) {
+		const wxString token = tokenizer.GetNextToken();
+		long color;
+		if (token.BeforeFirst('=').ToLong(&color)) {
+			saved[int(color)] = nstr(token.AfterFirst('='));
+		}
+	}
+	return saved;
+}
+
+void ImportMiniMapWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
+	wxFileDialog dialog(this, "Import...", "", "", "Images (*.bmp;*.png)|*.bmp;*.png", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+	if (dialog.ShowModal() == wxID_OK) {
+		file_text_field->ChangeValue(dialog.GetPath());
+		LoadColors();
+	}
+}
+
+void ImportMiniMapWindow::OnFileEntered(wxCommandEvent& WXUNUSED(event)) {
+	LoadColors();
+}
+
+void ImportMiniMapWindow::LoadColors() {
+	colors_window->Freeze();
+	colors_sizer->Clear(true);
+	color_choices.clear();
+
+	loaded_file = file_text_field->GetValue();
+	importer.reset(newd MinimapImporter(editor.map));
+	if (!importer->load(FileName(loaded_file))) {
+		colors_sizer->Add(newd wxStaticText(colors_window, wxID_ANY, wxstr(importer->getError())));
+		importer.reset();
+	} else {
+		// Brushes picked the last time, by color
+		const std::map<int, std::string> saved = getSavedMinimapBrushes();
+
+		wxArrayString choices;
+		choices.Add("(Leave empty)");
+		for (GroundBrush* brush : brushes) {
+			choices.Add(wxstr(brush->getName()));
+		}
+
+		const std::vector<int64_t>& counts = importer->getColorCounts();
+		for (int color = 0; color < 256; ++color) {
+			if (counts[color] == 0) {
+				continue;
+			}
+
+			wxPanel* swatch = newd wxPanel(colors_window, wxID_ANY, wxDefaultPosition, wxSize(20, 20), wxBORDER_SIMPLE);
+			swatch->SetBackgroundColour(wxColor(minimap_color[color].red, minimap_color[color].green, minimap_color[color].blue));
+			colors_sizer->Add(swatch, 0, wxALIGN_CENTER_VERTICAL);
+			colors_sizer->Add(newd wxStaticText(colors_window, wxID_ANY, wxString::Format("%d (%lld px)", color, (long long)counts[color])), 0, wxALIGN_CENTER_VERTICAL);
+
+			wxChoice* choice = newd wxChoice(colors_window, wxID_ANY, wxDefaultPosition, wxDefaultSize, choices);
+			GroundBrush* brush = nullptr;
+			auto it = saved.find(color);
+			if (it != saved.end()) {
+				Brush* saved_brush = g_brushes.getBrush(it->second);
+				brush = saved_brush && saved_brush->isGround() ? saved_brush->asGround() : nullptr;
+			} else {
+				brush = MinimapImporter::findBrush(uint8_t(color));
+			}
+			auto found = std::find(brushes.begin(), brushes.end(), brush);
+			choice->SetSelection(brush && found != brushes.end() ? int(found - brushes.begin()) + 1 : 0);
+			colors_sizer->Add(choice, 1, wxEXPAND);
+			color_choices[uint8_t(color)] = choice;
+		}
+	}
+
+	colors_window->FitInside();
+	colors_window->Layout();
+	colors_window->Thaw();
+}
+
+void ImportMiniMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
+	wxFileName fn = file_text_field->GetValue();
+	if (!fn.FileExists()) {
+		g_gui.PopupDialog(this, "Error", "The specified image file doesn't exist", wxOK);
+		return;
+	}
+	if (!importer || file_text_field->GetValue() != loaded_file) {
+		// The brushes are picked for the colors of the image in the field
+		LoadColors();
+		return;
+	}
+
+	// Remembered per color for the next import
+	std::map<int, std::string> saved = getSavedMinimapBrushes();
+
+	std::vector<GroundBrush*> color_brushes(256, nullptr);
+	for (const auto& it : color_choices) {
+		const int selection = it.second->GetSelection();
+		if (selection > 0) {
+			color_brushes[it.first] = brushes[selection - 1];
+			saved[it.first] = brushes[selection - 1]->getName();
+		} else {
+			saved[it.first] = "";
+		}
+	}
+
+	std::string table;
+	for (const auto& it : saved) {
+		table += i2s(it.first) + "=" + it.second + ";";
+	}
+	g_settings.setString(Config::MINIMAP_IMPORT_BRUSHES, table);
+
+	EndModal(1);
+
+	editor.importMiniMap(*importer, color_brushes, Position(x_offset_ctrl->GetValue(), y_offset_ctrl->GetValue(), floor_ctrl->GetValue()));
+}
+
+void ImportMiniMapWindow::OnClickCancel(wxCommandEvent& WXUNUSED(event)) {
+	// Just close this window
+	EndModal(0);
+}
+
 // ============================================================================
 // Export Minimap window
 
@@ -505,6 +700,16 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor& editor) :
 	tmpsizer->Add(floor_number, 0, wxALL, 5);
 	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
 
+	// File format
+	wxArrayString formats;
+	formats.Add("BMP (client minimap colors)");
+	formats.Add("PNG");
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Format");
+	format_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, formats);
+	format_options->SetSelection(0);
+	tmpsizer->Add(format_options, 1, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
 	// OK/Cancel buttons
 	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
 	tmpsizer->Add(ok_button = newd wxButton(this, wxID_OK, "OK"), wxSizerFlags(1).Center());
@@ -520,7 +725,7 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor& editor) :
 ExportMiniMapWindow::~ExportMiniMapWindow() = default;
 
 void ExportMiniMapWindow::OnExportTypeChange(wxCommandEvent& event) {
-	floor_number->Enable(event.GetSelection() == 2);
+	floor_number->Enable(floor_options->GetSelection() == 2);
 }
 
 void ExportMiniMapWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
@@ -543,48 +748,33 @@ void ExportMiniMapWindow::OnFileNameChanged(wxKeyEvent& event) {
 }
 
 void ExportMiniMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
-	g_gui.CreateLoadBar("Exporting minimap");
-
-	try {
-		FileName directory(directory_text_field->GetValue());
-		g_settings.setString(Config::MINIMAP_EXPORT_DIR, directory_text_field->GetValue().ToStdString());
-
-		switch (floor_options->GetSelection()) {
-			case 0: { // All floors
-				for (int floor = 0; floor < MAP_LAYERS; ++floor) {
-					g_gui.SetLoadScale(int(floor * (100.f / 16.f)), int((floor + 1) * (100.f / 16.f)));
-					FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
-					file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-					editor.exportMiniMap(file, floor, true);
-				}
-				break;
-			}
-
-			case 1: { // Ground floor
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(GROUND_LAYER) + ".bmp");
-				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-				editor.exportMiniMap(file, GROUND_LAYER, true);
-				break;
-			}
-
-			case 2: { // Specific floors
-				int floor = floor_number->GetValue();
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
-				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-				editor.exportMiniMap(file, floor, true);
-				break;
-			}
-
-			case 3: { // Selected area
-				editor.exportSelectionAsMiniMap(directory, file_name_text_field->GetValue());
-				break;
-			}
-		}
-	} catch (std::bad_alloc&) {
-		g_gui.PopupDialog("Error", "There is not enough memory available to complete the operation.", wxOK);
+	FileName directory(directory_text_field->GetValue());
+	g_settings.setString(Config::MINIMAP_EXPORT_DIR, directory_text_field->GetValue().ToStdString());
+
+	int first_floor = 0;
+	int last_floor = MAP_MAX_LAYER;
+	if (floor_options->GetSelection() == 1) {
+		first_floor = last_floor = GROUND_LAYER;
+	} else if (floor_options->GetSelection() == 2) {
+		first_floor = last_floor = floor_number->GetValue();
 	}
 
-	g_gui.DestroyLoadBar();
+	const MinimapExporter::Format format = format_options->GetSelection() == 1 ? MinimapExporter::FORMAT_PNG : MinimapExporter::FORMAT_BMP;
+	MinimapExporter exporter(editor.map, format);
+	exporter.setSelectionOnly(floor_options->GetSelection() == 3);
+
+	Show(false);
+	wxGenericProgressDialog progress("Exporting minimap", "Writing the minimap images...", 1000, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME | wxPD_AUTO_HIDE);
+	const bool exported = exporter.run(directory, nstr(file_name_text_field->GetValue()), first_floor, last_floor, [&progress](int64_t done, int64_t total) {
+		return progress.Update(total > 0 ? int(done * 999 / total) : 0);
+	});
+	progress.Hide();
+
+	if (exported) {
+		g_gui.SetStatusText(wxString::Format("Exported the minimap of %d floors.", exporter.getImagesWritten()));
+	} else if (!exporter.getError().empty()) {
+		g_gui.PopupDialog("Error", wxstr(exporter.getError()), wxOK);
+	}
 	EndModal(1);
 }
 
@@ -624,6 +814,328 @@ void ExportMiniMapWindow::CheckValues() {
 	ok_button->Enable(true);
 }
 
+// ============================================================================
+// Export Web Map window
+
+BEGIN_EVENT_TABLE(ExportWebMapWindow, wxDialog)
+EVT_BUTTON(MAP_WINDOW_FILE_BUTTON, ExportWebMapWindow::OnClickBrowse)
+EVT_BUTTON(wxID_OK, ExportWebMapWindow::OnClickOK)
+EVT_BUTTON(wxID_CANCEL, ExportWebMapWindow::OnClickCancel)
+END_EVENT_TABLE()
+
+ExportWebMapWindow::ExportWebMapWindow(wxWindow* parent, Editor& editor) :
+	wxDialog(parent, wxID_ANY, "Export Web Map", wxDefaultPosition, wxSize(400, 300)),
+	editor(editor) {
+	wxSizer* sizer = newd wxBoxSizer(wxVERTICAL);
+	wxSizer* tmpsizer;
+
+	// Error field
+	error_field = newd wxStaticText(this, wxID_VIEW_DETAILS, "", wxDefaultPosition, wxDefaultSize);
+	error_field->SetForegroundColour(*wxRED);
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(error_field, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// Output folder
+	directory_text_field = newd wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize);
+	directory_text_field->Bind(wxEVT_KEY_UP, &ExportWebMapWindow::OnDirectoryChanged, this);
+	directory_text_field->SetValue(wxString(g_settings.getString(Config::WEB_MAP_EXPORT_DIR)));
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Output Folder");
+	tmpsizer->Add(directory_text_field, 1, wxALL, 5);
+	tmpsizer->Add(newd wxButton(this, MAP_WINDOW_FILE_BUTTON, "Browse"), 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxALL | wxEXPAND, 5);
+
+	// What the tiles are drawn from
+	wxArrayString sources;
+	sources.Add("Sprites (32 pixels per tile)");
+	sources.Add("Minimap colors (1 pixel per tile)");
+
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Tiles");
+	source_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, sources);
+	source_options->SetSelection(0);
+	tmpsizer->Add(source_options, 1, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// Floors
+	wxArrayString choices;
+	choices.Add("All Floors");
+	choices.Add("Ground Floor");
+	choices.Add("Specific Floor");
+
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Floors");
+	floor_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, choices);
+	floor_options->Bind(wxEVT_CHOICE, &ExportWebMapWindow::OnFloorTypeChange, this);
+	floor_number = newd wxSpinCtrl(this, wxID_ANY, i2ws(GROUND_LAYER), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, MAP_MAX_LAYER, GROUND_LAYER);
+	floor_number->Enable(false);
+	floor_options->SetSelection(0);
+	tmpsizer->Add(floor_options, 1, wxALL, 5);
+	tmpsizer->Add(floor_number, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// OK/Cancel buttons
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(ok_button = newd wxButton(this, wxID_OK, "OK"), wxSizerFlags(1).Center());
+	tmpsizer->Add(newd wxButton(this, wxID_CANCEL, "Cancel"), wxSizerFlags(1).Center());
+	sizer->Add(tmpsizer, 0, wxCENTER, 10);
+
+	SetSizerAndFit(sizer);
+	Centre(wxBOTH);
+	CheckValues();
+}
+
+ExportWebMapWindow::~ExportWebMapWindow() = default;
+
+void ExportWebMapWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
+	wxDirDialog dialog(NULL, "Select the output folder", directory_text_field->GetValue(), wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST);
+	if (dialog.ShowModal() == wxID_OK) {
+		directory_text_field->ChangeValue(dialog.GetPath());
+	}
+	CheckValues();
+}
+
+void ExportWebMapWindow::OnDirectoryChanged(wxKeyEvent& event) {
+	CheckValues();
+	event.Skip();
+}
+
+void ExportWebMapWindow::OnFloorTypeChange(wxCommandEvent& event) {
+	floor_number->Enable(event.GetSelection() == 2);
+}
+
+void ExportWebMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
+	g_settings.setString(Config::WEB_MAP_EXPORT_DIR, directory_text_field->GetValue().ToStdString());
+
+	int first_floor = 0;
+	int last_floor = MAP_MAX_LAYER;
+	if (floor_options->GetSelection() == 1) {
+		first_floor = last_floor = GROUND_LAYER;
+	} else if (floor_options->GetSelection() == 2) {
+		first_floor = last_floor = floor_number->GetValue();
+	}
+
+	const WebMapExporter::Source source = source_options->GetSelection() == 1 ? WebMapExporter::SOURCE_MINIMAP : WebMapExporter::SOURCE_SPRITES;
+	WebMapExporter exporter(editor.map, nstr(directory_text_field->GetValue()), source);
+
+	Show(false);
+	wxGenericProgressDialog progress("Exporting web map", "Drawing the map tiles...", 1000, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME | wxPD_AUTO_HIDE);
+	const bool exported = exporter.run(first_floor, last_floor, 0, [&progress](int64_t done, int64_t total) {
+		return progress.Update(total > 0 ? int(done * 999 / total) : 0);
+	});
+	progress.Hide();
+
+	if (exported) {
+		g_gui.SetStatusText(wxString::Format("Exported the web map, %lld tiles drawn and %lld unchanged.", (long long)exporter.getTilesWritten(), (long long)exporter.getTilesSkipped()));
+	} else if (!exporter.getError().empty()) {
+		g_gui.PopupDialog("Error", wxstr(exporter.getError()), wxOK);
+	}
+	EndModal(1);
+}
+
+void ExportWebMapWindow::OnClickCancel(wxCommandEvent& WXUNUSED(event)) {
+	// Just close this window
+	EndModal(0);
+}
+
+void ExportWebMapWindow::CheckValues() {
+	if (directory_text_field->IsEmpty()) {
+		error_field->SetLabel("Type or select an output folder.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	FileName directory(directory_text_field->GetValue());
+
+	if (!directory.Exists()) {
+		error_field->SetLabel("Output folder not found.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	if (!directory.IsDirWritable()) {
+		error_field->SetLabel("Output folder is not writable.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	error_field->SetLabel(wxEmptyString);
+	ok_button->Enable(true);
+}
+
+// ============================================================================
+// Export Region Image window
+
+BEGIN_EVENT_TABLE(ExportRegionImageWindow, wxDialog)
+EVT_BUTTON(REGION_IMAGE_FILE_BUTTON, ExportRegionImageWindow::OnClickBrowse)
+EVT_BUTTON(wxID_OK, ExportRegionImageWindow::OnClickOK)
+EVT_BUTTON(wxID_CANCEL, ExportRegionImageWindow::OnClickCancel)
+EVT_TEXT(wxID_ANY, ExportRegionImageWindow::OnValueChanged)
+EVT_CHOICE(wxID_ANY, ExportRegionImageWindow::OnValueChanged)
+EVT_CHECKBOX(wxID_ANY, ExportRegionImageWindow::OnValueChanged)
+END_EVENT_TABLE()
+
+ExportRegionImageWindow::ExportRegionImageWindow(wxWindow* parent, Editor& editor) :
+	wxDialog(parent, wxID_ANY, "Export Region Image", wxDefaultPosition, wxSize(400, 400)),
+	editor(editor),
+	error_field(nullptr),
+	size_field(nullptr),
+	file_text_field(nullptr),
+	from_position(nullptr),
+	to_position(nullptr),
+	zoom_options(nullptr),
+	software_checkbox(nullptr),
+	ok_button(nullptr) {
+	wxSizer* sizer = newd wxBoxSizer(wxVERTICAL);
+	wxSizer* tmpsizer;
+
+	// Error field
+	error_field = newd wxStaticText(this, wxID_VIEW_DETAILS, "", wxDefaultPosition, wxDefaultSize);
+	error_field->SetForegroundColour(*wxRED);
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(error_field, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// Output file
+	wxString mapName(editor.map.getName().c_str(), wxConvUTF8);
+	FileName file(mapName.BeforeLast('.') + ".png");
+	file.Normalize(wxPATH_NORM_ALL, wxstr(g_settings.getString(Config::SCREENSHOT_DIRECTORY)));
+	file_text_field = newd wxTextCtrl(this, wxID_ANY, file.GetFullPath(), wxDefaultPosition, wxDefaultSize);
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Output File");
+	tmpsizer->Add(file_text_field, 1, wxALL, 5);
+	tmpsizer->Add(newd wxButton(this, REGION_IMAGE_FILE_BUTTON, "Browse"), 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxALL | wxEXPAND, 5);
+
+	// Area, the selection or else the whole map
+	Position from(0, 0, g_gui.GetCurrentFloor());
+	Position to(editor.map.getWidth() - 1, editor.map.getHeight() - 1, g_gui.GetCurrentFloor());
+	if (editor.hasSelection()) {
+		from = editor.selection.minPosition();
+		to = editor.selection.maxPosition();
+		to.z = from.z;
+	}
+	from_position = newd PositionCtrl(this, "From", from.x, from.y, from.z, editor.map.getWidth(), editor.map.getHeight());
+	sizer->Add(from_position, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+	to_position = newd PositionCtrl(this, "To", to.x, to.y, to.z, editor.map.getWidth(), editor.map.getHeight());
+	sizer->Add(to_position, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// Zoom
+	wxArrayString choices;
+	choices.Add("200%");
+	choices.Add("100%");
+	choices.Add("50%");
+	choices.Add("25%");
+	choices.Add("12.5%");
+
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Zoom");
+	zoom_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, choices);
+	zoom_options->SetSelection(1);
+	tmpsizer->Add(zoom_options, 1, wxALL, 5);
+	size_field = newd wxStaticText(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize);
+	tmpsizer->Add(size_field, 1, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	software_checkbox = newd wxCheckBox(this, wxID_ANY, "Render on the CPU");
+	software_checkbox->SetToolTip("Renders without OpenGL, at 100% zoom and without light or animations.");
+	sizer->Add(software_checkbox, 0, wxLEFT | wxRIGHT | wxBOTTOM, 10);
+
+	// OK/Cancel buttons
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(ok_button = newd wxButton(this, wxID_OK, "OK"), wxSizerFlags(1).Center());
+	tmpsizer->Add(newd wxButton(this, wxID_CANCEL, "Cancel"), wxSizerFlags(1).Center());
+	sizer->Add(tmpsizer, 0, wxCENTER, 10);
+
+	SetSizerAndFit(sizer);
+	Centre(wxBOTH);
+	CheckValues();
+}
+
+ExportRegionImageWindow::~ExportRegionImageWindow() = default;
+
+void ExportRegionImageWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
+	FileName file(file_text_field->GetValue());
+	wxFileDialog dialog(this, "Export image...", file.GetPath(), file.GetFullName(), "PNG files (*.png)|*.png", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dialog.ShowModal() == wxID_OK) {
+		file_text_field->ChangeValue(dialog.GetPath());
+	}
+	CheckValues();
+}
+
+void ExportRegionImageWindow::OnValueChanged(wxCommandEvent& event) {
+	// The controls send events while the dialog is still being built
+	if (ok_button) {
+		CheckValues();
+	}
+	event.Skip();
+}
+
+void ExportRegionImageWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
+	MapTab* tab = g_gui.GetCurrentMapTab();
+	if (!tab || tab->GetEditor() != &editor) {
+		EndModal(0);
+		return;
+	}
+
+	Position from = from_position->GetPosition();
+	Position to = to_position->GetPosition();
+	Position start(std::min(from.x, to.x), std::min(from.y, to.y), from.z);
+	Position end(std::max(from.x, to.x), std::max(from.y, to.y), from.z);
+
+	Show(false);
+	if (software_checkbox->GetValue()) {
+		if (editor.exportRegionImage(FileName(file_text_field->GetValue()), start, end)) {
+			g_gui.SetStatusText("Exported image to " + file_text_field->GetValue());
+		}
+	} else {
+		tab->GetCanvas()->ExportRegion(file_text_field->GetValue(), start, end, GetZoom());
+	}
+	EndModal(1);
+}
+
+void ExportRegionImageWindow::OnClickCancel(wxCommandEvent& WXUNUSED(event)) {
+	// Just close this window
+	EndModal(0);
+}
+
+double ExportRegionImageWindow::GetZoom() const {
+	static const double zooms[] = { 0.5, 1.0, 2.0, 4.0, 8.0 };
+	int selection = zoom_options->GetSelection();
+	return selection >= 0 && selection < 5 ? zooms[selection] : 1.0;
+}
+
+void ExportRegionImageWindow::CheckValues() {
+	const int tile_pixels = int(TileSize / GetZoom());
+	const long width = (std::abs(to_position->GetX() - from_position->GetX()) + 1) * tile_pixels;
+	const long height = (std::abs(to_position->GetY() - from_position->GetY()) + 1) * tile_pixels;
+	size_field->SetLabel(wxString::Format("%ldx%ld pixels", width, height));
+
+	if (file_text_field->IsEmpty()) {
+		error_field->SetLabel("Type or select an output file.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	FileName file(file_text_field->GetValue());
+	if (!wxFileName::DirExists(file.GetPath())) {
+		error_field->SetLabel("Output folder not found.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	if (from_position->GetZ() != to_position->GetZ()) {
+		error_field->SetLabel("Both corners must be on the same floor.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	if (software_checkbox->GetValue() && zoom_options->GetSelection() != 1) {
+		error_field->SetLabel("CPU rendering only supports 100% zoom.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	error_field->SetLabel(wxEmptyString);
+	ok_button->Enable(true);
+}
+
 // ============================================================================
 // Export Tilesets window
 
@@ -24,7 +24,9 @@
 #include "positionctrl.h"
 
 class GameSprite;
+class GroundBrush;
 class MapTab;
+class MinimapImporter;
 
 /**
  * A toggle button with an item on it.
@@ -102,6 +104,43 @@ protected:
 	DECLARE_EVENT_TABLE();
 };
 
+/**
+ * The import minimap dialog, pick an image and the ground brush
+ * drawn for each of the minimap colors in it.
+ */
+class ImportMiniMapWindow : public wxDialog {
+public:
+	ImportMiniMapWindow(wxWindow* parent, Editor& editor);
+	virtual ~ImportMiniMapWindow();
+
+	void OnClickBrowse(wxCommandEvent&);
+	void OnFileEntered(wxCommandEvent&);
+	void OnClickOK(wxCommandEvent&);
+	void OnClickCancel(wxCommandEvent&);
+
+protected:
+	// Lists the colors of the image with a brush choice for each
+	void LoadColors();
+
+	Editor& editor;
+
+	wxTextCtrl* file_text_field;
+	wxSpinCtrl* x_offset_ctrl;
+	wxSpinCtrl* y_offset_ctrl;
+	wxSpinCtrl* floor_ctrl;
+	wxScrolledWindow* colors_window;
+	wxFlexGridSizer* colors_sizer;
+
+	std::vector<GroundBrush*> brushes;
+	// The image the colors are listed for, imported on OK
+	std::unique_ptr<MinimapImporter> importer;
+	wxString loaded_file;
+	// Choice of each color in the image, by minimap color
+	std::map<uint8_t, wxChoice*> color_choices;
+
+	DECLARE_EVENT_TABLE();
+};
+
 /**
  * The export minimap dialog, select output path and what floors to export.
  */
@@ -127,6 +166,67 @@ protected:
 	wxTextCtrl* file_name_text_field;
 	wxChoice* floor_options;
 	wxSpinCtrl* floor_number;
+	wxChoice* format_options;
+	wxButton* ok_button;
+
+	DECLARE_EVENT_TABLE();
+};
+
+/**
+ * The export web map dialog, writes the map as zoomable PNG tiles.
+ */
+class ExportWebMapWindow : public wxDialog {
+public:
+	ExportWebMapWindow(wxWindow* parent, Editor& editor);
+	virtual ~ExportWebMapWindow();
+
+	void OnClickBrowse(wxCommandEvent&);
+	void OnDirectoryChanged(wxKeyEvent&);
+	void OnFloorTypeChange(wxCommandEvent&);
+	void OnClickOK(wxCommandEvent&);
+	void OnClickCancel(wxCommandEvent&);
+
+protected:
+	void CheckValues();
+
+	Editor& editor;
+
+	wxStaticText* error_field;
+	wxTextCtrl* directory_text_field;
+	wxChoice* source_options;
+	wxChoice* floor_options;
+	wxSpinCtrl* floor_number;
+	wxButton* ok_button;
+
+	DECLARE_EVENT_TABLE();
+};
+
+/**
+ * The export region image dialog, select the area, zoom and output file.
+ */
+class ExportRegionImageWindow : public wxDialog {
+public:
+	ExportRegionImageWindow(wxWindow* parent, Editor& editor);
+	virtual ~ExportRegionImageWindow();
+
+	void OnClickBrowse(wxCommandEvent&);
+	void OnValueChanged(wxCommandEvent&);
+	void OnClickOK(wxCommandEvent&);
+	void OnClickCancel(wxCommandEvent&);
+
+protected:
+	void CheckValues();
+	double GetZoom() const;
+
+	Editor& editor;
+
+	wxStaticText* error_field;
+	wxStaticText* size_field;
+	wxTextCtrl* file_text_field;
+	PositionCtrl* from_position;
+	PositionCtrl* to_position;
+	wxChoice* zoom_options;
+	wxCheckBox* software_checkbox;
 	wxButton* ok_button;
 
 	DECLARE_EVENT_TABLE();
@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "dirty_list.h"
+
+#include <algorithm>
+
+DirtyList::DirtyList() :
+	owner(0),
+	last_pos(0xFFFFFFFF),
+	last_index(0),
+	sorted(true) {
+	;
+}
+
+DirtyList::~DirtyList() {
+	;
+}
+
+void DirtyList::AddPosition(int x, int y, int z) {
+	uint32_t m = ((x >> 2) << 18) | ((y >> 2) << 4);
+	// Tiles are mostly changed a leaf at a time
+	if (m != last_pos) {
+		auto it = index.find(m);
+		if (it == index.end()) {
+			it = index.emplace(m, uint32_t(positions.size())).first;
+			if (!positions.empty() && positions.back().pos > m) {
+				sorted = false;
+			}
+			positions.push_back(ValueType { m, 0 });
+		}
+		last_pos = m;
+		last_index = it->second;
+	}
+	positions[last_index].floors |= 1 << z;
+}
+
+void DirtyList::AddChange(Change* c) {
+	ichanges.push_back(c);
+}
+
+DirtyList::ListType& DirtyList::GetPosList() {
+	if (!sorted) {
+		std::sort(positions.begin(), positions.end(), [](const ValueType& a, const ValueType& b) {
+			return a.pos < b.pos;
+		});
+		for (uint32_t i = 0; i < positions.size(); ++i) {
+			index[positions[i].pos] = i;
+		}
+		last_pos = 0xFFFFFFFF;
+		sorted = true;
+	}
+	return positions;
+}
+
+ChangeList& DirtyList::GetChanges() {
+	return ichanges;
+}
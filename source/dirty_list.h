@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_DIRTY_LIST_H_
+#define RME_DIRTY_LIST_H_
+
+// Kept free of wx, tools/dirty_list_bench.cpp builds against it on its own
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Change;
+
+typedef std::vector<Change*> ChangeList;
+
+// A dirty list represents a list of all tiles that was changed in an action
+class DirtyList {
+public:
+	DirtyList();
+	~DirtyList();
+
+	struct ValueType {
+		uint32_t pos;
+		uint32_t floors;
+	};
+
+	uint32_t owner;
+
+	typedef std::vector<ValueType> ListType;
+
+	void AddPosition(int x, int y, int z);
+	void AddChange(Change* c);
+	bool Empty() const {
+		return positions.empty() && ichanges.empty();
+	}
+	// Sorted by position, so nodes are always sent in the same order
+	ListType& GetPosList();
+	ChangeList& GetChanges();
+
+protected:
+	// One entry per leaf, the floors are or'ed into it in place
+	ListType positions;
+	std::unordered_map<uint32_t, uint32_t> index;
+	uint32_t last_pos;
+	uint32_t last_index;
+	bool sorted;
+
+	ChangeList ichanges;
+};
+
+#endif
@@ -41,6 +41,14 @@
 #include "live_action.h"
 #include "minimap_window.h"
 #include "borderize_window.h"
+#include "software_renderer.h"
+#include "minimap_importer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
 
 Editor::Editor(CopyBuffer& copybuffer) :
 	live_server(nullptr),
@@ -49,7 +57,8 @@ Editor::Editor(CopyBuffer& copybuffer) :
 	actionQueue(newd ActionQueue(*this)),
 	selection(*this),
 	copybuffer(copybuffer),
-	replace_brush(nullptr) {
+	replace_brush(nullptr),
+	minimap_cache(map) {
 	wxString error;
 	wxArrayString warnings;
 	bool ok = true;
@@ -100,7 +109,8 @@ Editor::Editor(CopyBuffer& copybuffer, const FileName& fn) :
 	actionQueue(newd ActionQueue(*this)),
 	selection(*this),
 	copybuffer(copybuffer),
-	replace_brush(nullptr) {
+	replace_brush(nullptr),
+	minimap_cache(map) {
 	MapVersion ver;
 	if (!IOMapOTBM::getVersionInfo(fn, ver)) {
 		// g_gui.PopupDialog("Error", "Could not open file \"" + fn.GetFullPath() + "\".", wxOK);
@@ -136,6 +146,9 @@ Editor::Editor(CopyBuffer& copybuffer, const FileName& fn) :
 	if (success) {
 		ScopedLoadingBar LoadingBar("Loading OTBM map...");
 		success = map.open(nstr(fn.GetFullPath()));
+		if (success) {
+			minimap_cache.load(fn);
+		}
 		/* TODO
 		if(success && ver.client == CLIENT_VERSION_854_BAD) {
 			int ok = g_gui.PopupDialog("Incorrect OTB", "This map has been saved with an incorrect OTB version, do you want to convert it to the new OTB version?\n\nIf you are not sure, click Yes.", wxYES | wxNO);
@@ -155,7 +168,8 @@ Editor::Editor(CopyBuffer& copybuffer, LiveClient* client) :
 	actionQueue(newd NetworkedActionQueue(*this)),
 	selection(*this),
 	copybuffer(copybuffer),
-	replace_brush(nullptr) {
+	replace_brush(nullptr),
+	minimap_cache(map) {
 	;
 }
 
@@ -373,116 +387,45 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 		std::remove(backup_spawn.c_str());
 	}
 
-	map.clearChanges();
-}
-
-bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
-	return false;
-}
-
-bool Editor::exportMiniMap(FileName filename, int floor /*= GROUND_LAYER*/, bool displaydialog) {
-	return map.exportMinimap(filename, floor, displaydialog);
-}
-
-bool Editor::exportSelectionAsMiniMap(FileName directory, wxString fileName) {
-	if (!directory.Exists() || !directory.IsDirWritable()) {
-		return false;
+	if (g_settings.getInteger(Config::SAVE_MINIMAP_CACHE)) {
+		minimap_cache.save(FileName(wxstr(savefile)));
 	}
 
-	int min_x = MAP_MAX_WIDTH + 1, min_y = MAP_MAX_HEIGHT + 1, min_z = MAP_MAX_LAYER + 1;
-	int max_x = 0, max_y = 0, max_z = 0;
-
-	const TileSet& tiles = selection.getTiles();
-	for (Tile* tile : tiles) {
-		if (tile->empty()) {
-			continue;
-		}
+	map.clearChanges();
+}
 
-		Position pos = tile->getPosition();
+bool Editor::importMiniMap(MinimapImporter& importer, const std::vector<GroundBrush*>& brushes, const Position& offset) {
+	wxBusyCursor busy;
+	BatchAction* batch = actionQueue->createBatch(ACTION_DRAW);
+	Action* action = actionQueue->createAction(batch);
+	const int64_t tiles = importer.run(brushes, offset, *action);
+	batch->addAndCommitAction(action);
+	addBatch(batch);
 
-		if (pos.x < min_x) {
-			min_x = pos.x;
-		}
-		if (pos.x > max_x) {
-			max_x = pos.x;
-		}
+	map.setWidth(std::max(map.getWidth(), offset.x + importer.getWidth()));
+	map.setHeight(std::max(map.getHeight(), offset.y + importer.getHeight()));
 
-		if (pos.y < min_y) {
-			min_y = pos.y;
-		}
-		if (pos.y > max_y) {
-			max_y = pos.y;
-		}
+	g_gui.SetStatusText(wxString::Format("Imported the minimap, %lld tiles drawn.", (long long)tiles));
+	g_gui.RefreshView();
+	g_gui.UpdateMinimap(true);
+	return true;
+}
 
-		if (pos.z < min_z) {
-			min_z = pos.z;
-		}
-		if (pos.z > max_z) {
-			max_z = pos.z;
-		}
-	}
+bool Editor::exportRegionImage(const FileName& filename, const Position& from, const Position& to) {
+	SoftwareRenderer renderer(map, 0);
+	g_gui.CreateLoadBar("Rendering image...");
 
-	int numtiles = (max_x - min_x) * (max_y - min_y);
-	int minimap_width = max_x - min_x + 1;
-	int minimap_height = max_y - min_y + 1;
+	const bool written = renderer.writePNG(nstr(filename.GetFullPath()), from, to, [](int done) {
+		g_gui.SetLoadDone(std::min(99, done));
+		return true;
+	});
 
-	if (numtiles == 0) {
-		return false;
-	}
+	g_gui.DestroyLoadBar();
 
-	if (minimap_width > 2048 || minimap_height > 2048) {
-		g_gui.PopupDialog("Error", "Minimap size greater than 2048px.", wxOK);
+	if (!written) {
+		g_gui.PopupDialog("Error", wxstr(renderer.getError()), wxOK);
 		return false;
 	}
-
-	int tiles_iterated = 0;
-
-	for (int z = min_z; z <= max_z; z++) {
-		uint8_t* pixels = newd uint8_t[minimap_width * minimap_height * 3]; // 3 bytes per pixel
-		memset(pixels, 0, minimap_width * minimap_height * 3);
-
-		for (Tile* tile : tiles) {
-			if (tile->getZ() != z) {
-				continue;
-			}
-
-			++tiles_iterated;
-			if (tiles_iterated % 8192 == 0) {
-				g_gui.SetLoadDone(int(tiles_iterated / double(tiles.size()) * 90.0));
-			}
-
-			if (tile->empty()) {
-				continue;
-			}
-
-			uint8_t color = 0;
-
-			for (Item* item : tile->items) {
-				if (item->getMiniMapColor() != 0) {
-					color = item->getMiniMapColor();
-					break;
-				}
-			}
-
-			if (color == 0 && tile->hasGround()) {
-				color = tile->ground->getMiniMapColor();
-			}
-
-			uint32_t index = ((tile->getY() - min_y) * minimap_width + (tile->getX() - min_x)) * 3;
-
-			pixels[index] = (uint8_t)(int(color / 36) % 6 * 51); // red
-			pixels[index + 1] = (uint8_t)(int(color / 6) % 6 * 51); // green
-			pixels[index + 2] = (uint8_t)(color % 6 * 51); // blue
-		}
-
-		FileName file(fileName + "_" + i2ws(z) + ".png");
-		file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-		wxImage* image = newd wxImage(minimap_width, minimap_height, pixels, true);
-		image->SaveFile(file.GetFullPath(), wxBITMAP_TYPE_PNG);
-		image->Destroy();
-		delete[] pixels;
-	}
-
 	return true;
 }
 
@@ -714,12 +657,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 	}
 
 	// Plain merge of waypoints, very simple! :)
-	for (WaypointMap::iterator iter = imported_map.waypoints.begin(); iter != imported_map.waypoints.end(); ++iter) {
-		iter->second->pos += offset;
-	}
-
-	map.waypoints.waypoints.insert(imported_map.waypoints.begin(), imported_map.waypoints.end());
-	imported_map.waypoints.waypoints.clear();
+	map.waypoints.merge(imported_map.waypoints, offset);
 
 	uint64_t tiles_merged = 0;
 	uint64_t tiles_to_import = imported_map.tilecount;
@@ -814,6 +752,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 
 	map.setWidth(newsize_x);
 	map.setHeight(newsize_y);
+	minimap_cache.clear();
 	g_gui.PopupDialog("Success", "Map imported successfully, " + i2ws(discarded_tiles) + " tiles were discarded as invalid.", wxOK);
 
 	g_gui.RefreshPalettes();
@@ -834,21 +773,30 @@ void Editor::borderizeSelection() {
 }
 
 void Editor::borderizeMap(bool showdialog) {
-	if (!showdialog) {
-		// Old immediate processing for automated calls
-		uint64_t tiles_done = 0;
-		for (TileLocation* tileLocation : map) {
-			Tile* tile = tileLocation->get();
-			ASSERT(tile);
-			tile->borderize(&map);
-			++tiles_done;
+	// Only the border items change, so comparing the item ids is enough
+	auto borderize = [this](const Tile* tile, Tile* copy) {
+		copy->borderize(&map);
+		if (copy->items.size() != tile->items.size()) {
+			return true;
 		}
+		for (size_t i = 0; i < copy->items.size(); ++i) {
+			if (copy->items[i]->getID() != tile->items[i]->getID()) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	std::vector<Tile*> tiles;
+	if (!processMapTiles(borderize, showdialog ? "Borderizing map..." : "", tiles)) {
 		return;
 	}
 
-	BorderizeWindow* window = newd BorderizeWindow(g_gui.root, *this);
-	window->Start();
-	window->Destroy();
+	Action* action = actionQueue->createAction(ACTION_BORDERIZE);
+	for (Tile* tile : tiles) {
+		action->addChange(newd Change(tile));
+	}
+	addAction(action);
 }
 
 void Editor::randomizeSelection() {
@@ -878,46 +826,141 @@ void Editor::randomizeSelection() {
 }
 
 void Editor::randomizeMap(bool showdialog) {
-	if (showdialog) {
-		g_gui.CreateLoadBar("Randomizing map...");
+	auto randomize = [](const Tile* tile, Tile* copy) {
+		GroundBrush* groundBrush = copy->getGroundBrush();
+		if (!groundBrush || !copy->ground) {
+			return false;
+		}
+
+		// The random generator of the editor can not be shared between threads
+		thread_local std::mt19937 generator(std::random_device {}());
+		std::uniform_int_distribution<int> chance(1, std::max(1, groundBrush->getTotalChance()));
+		const uint16_t groundId = groundBrush->getGroundID(chance(generator));
+		if (groundId == 0 || groundId == copy->ground->getID()) {
+			return false;
+		}
+
+		Item* oldGround = copy->ground;
+		Item* newGround = Item::Create(groundId);
+		newGround->setActionID(oldGround->getActionID());
+		newGround->setUniqueID(oldGround->getUniqueID());
+		copy->addItem(newGround);
+		copy->update();
+		return true;
+	};
+
+	std::vector<Tile*> tiles;
+	if (!processMapTiles(randomize, showdialog ? "Randomizing map..." : "", tiles)) {
+		return;
 	}
 
-	uint64_t tiles_done = 0;
-	for (TileLocation* tileLocation : map) {
-		if (showdialog && tiles_done % 4096 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
+	Action* action = actionQueue->createAction(ACTION_RANDOMIZE);
+	for (Tile* tile : tiles) {
+		action->addChange(newd Change(tile));
+	}
+	addAction(action);
+}
+
+bool Editor::processMapTiles(const std::function<bool(const Tile*, Tile*)>& process, const std::string& message, std::vector<Tile*>& tiles) {
+	// Leaves are only read by the threads, the map tree is walked here
+	std::vector<QTreeNode*> leaves;
+	for (int node_x = 0; node_x < map.getWidth(); node_x += 256) {
+		for (int node_y = 0; node_y < map.getHeight(); node_y += 256) {
+			if (!map.getNode(node_x, node_y, 4)) {
+				continue;
+			}
+			for (int nd_x = node_x; nd_x < node_x + 256; nd_x += 4) {
+				for (int nd_y = node_y; nd_y < node_y + 256; nd_y += 4) {
+					QTreeNode* leaf = map.getLeaf(nd_x, nd_y);
+					if (leaf) {
+						leaves.push_back(leaf);
+					}
+				}
+			}
 		}
+	}
 
-		Tile* tile = tileLocation->get();
-		ASSERT(tile);
+	// Each job works on copies of the tiles of a few leaves and keeps its own
+	// results. The map is not changed until all are done, so tiles at the edge
+	// of a job see their neighbours as they were before.
+	const size_t LeavesPerJob = 64;
+	const size_t jobs = (leaves.size() + LeavesPerJob - 1) / LeavesPerJob;
+	std::vector<std::vector<Tile*>> results(jobs);
 
-		GroundBrush* groundBrush = tile->getGroundBrush();
-		if (groundBrush) {
-			Item* oldGround = tile->ground;
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> done(0);
+	std::atomic<bool> cancelled(false);
+	std::mutex mutex;
+	std::condition_variable finished;
 
-			uint16_t actionId, uniqueId;
-			if (oldGround) {
-				actionId = oldGround->getActionID();
-				uniqueId = oldGround->getUniqueID();
-			} else {
-				actionId = 0;
-				uniqueId = 0;
-			}
-			groundBrush->draw(&map, tile, nullptr);
+	auto work = [&]() {
+		for (size_t job = next++; job < jobs && !cancelled; job = next++) {
+			const size_t last = std::min(leaves.size(), (job + 1) * LeavesPerJob);
+			for (size_t index = job * LeavesPerJob; index < last; ++index) {
+				QTreeNode* leaf = leaves[index];
+				for (int z = 0; z < MAP_LAYERS; ++z) {
+					Floor* floor = leaf->getFloor(z);
+					if (!floor) {
+						continue;
+					}
+					for (TileLocation& location : floor->locs) {
+						Tile* tile = location.get();
+						if (!tile) {
+							continue;
+						}
 
-			Item* newGround = tile->ground;
-			if (newGround) {
-				newGround->setActionID(actionId);
-				newGround->setUniqueID(uniqueId);
+						Tile* copy = tile->deepCopy(map);
+						if (process(tile, copy)) {
+							results[job].push_back(copy);
+						} else {
+							delete copy;
+						}
+					}
+				}
+			}
+			if (++done == jobs) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
 			}
-			tile->update();
 		}
-		++tiles_done;
+	};
+
+	const int threads = std::max<int>(1, std::min<int>(g_settings.getWorkerThreads(), jobs));
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i) {
+		workers.emplace_back(work);
 	}
 
-	if (showdialog) {
+	if (!message.empty()) {
+		g_gui.CreateLoadBar(wxstr(message), true);
+	}
+	while (done < jobs && !cancelled) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait_for(lock, std::chrono::milliseconds(100), [&]() { return done >= jobs; });
+		}
+		if (!message.empty() && !g_gui.SetLoadDone(int32_t(done * 100 / std::max<size_t>(1, jobs)))) {
+			cancelled = true;
+		}
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (!message.empty()) {
 		g_gui.DestroyLoadBar();
 	}
+
+	for (std::vector<Tile*>& result : results) {
+		if (cancelled) {
+			for (Tile* tile : result) {
+				delete tile;
+			}
+		} else {
+			tiles.insert(tiles.end(), result.begin(), result.end());
+		}
+	}
+	return !cancelled;
 }
 
 void Editor::clearInvalidHouseTiles(bool showdialog) {
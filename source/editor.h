@@ -26,8 +26,13 @@
 #include "action.h"
 #include "selection.h"
 #include "minimap_window.h"
+#include "minimap_cache.h"
+
+#include <functional>
 
 class BaseMap;
+class GroundBrush;
+class MinimapImporter;
 class CopyBuffer;
 class LiveClient;
 class LiveServer;
@@ -52,6 +57,7 @@ public:
 	CopyBuffer& copybuffer;
 	GroundBrush* replace_brush;
 	Map map; // The map that is being edited
+	MinimapCache minimap_cache;
 
 public: // Functions
 	// Live Server handling
@@ -89,9 +95,10 @@ public: // Functions
 		return map.getError();
 	}
 	bool importMap(FileName filename, int import_x_offset, int import_y_offset, ImportType house_import_type, ImportType spawn_import_type);
-	bool importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset);
-	bool exportMiniMap(FileName filename, int floor /*= GROUND_LAYER*/, bool displaydialog);
-	bool exportSelectionAsMiniMap(FileName directory, wxString fileName);
+	// Draws the grounds of brushes[color] where the loaded image has that minimap color, as one undoable action
+	bool importMiniMap(MinimapImporter& importer, const std::vector<GroundBrush*>& brushes, const Position& offset);
+	// Renders the area on the CPU into a PNG, works without OpenGL
+	bool exportRegionImage(const FileName& filename, const Position& from, const Position& to);
 
 	// Adds an action to the action queue (this allows the user to undo the action)
 	// Invalidates the action pointer
@@ -114,7 +121,8 @@ public: // Functions
 	void randomizeSelection();
 
 	// Same as above although it applies to the entire map
-	// action queue is flushed when these functions are called
+	// borderize and randomize are done on several threads as a single action,
+	// action queue is flushed when the others are called
 	// showdialog is whether a progress bar should be shown
 	void borderizeMap(bool showdialog);
 	void randomizeMap(bool showdialog);
@@ -136,6 +144,11 @@ public: // Functions
 	void updateMinimapTile(Tile* tile);
 
 protected:
+	// Gives process a copy of each tile of the map on the worker threads, the
+	// copies it returns true for are added to tiles. With a message a
+	// cancellable progress bar is shown, returns false if it was cancelled.
+	bool processMapTiles(const std::function<bool(const Tile*, Tile*)>& process, const std::string& message, std::vector<Tile*>& tiles);
+
 	void drawInternal(const Position offset, bool alt, bool dodraw);
 	void drawInternal(const PositionVector& posvec, bool alt, bool dodraw);
 	void drawInternal(const PositionVector& todraw, PositionVector& toborder, bool alt, bool dodraw);
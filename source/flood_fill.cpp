@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "flood_fill.h"
+
+#include <limits>
+
+namespace {
+	inline uint32_t getLeafKey(int x, int y) {
+		return (uint32_t(y >> 2) << 16) | uint32_t(x >> 2);
+	}
+
+	inline uint16_t getLeafBit(int x, int y) {
+		return uint16_t(1u << (((y & 3) << 2) | (x & 3)));
+	}
+}
+
+FloodFill::FloodFill(int z, const Predicate& inside) :
+	z(z),
+	inside(inside),
+	min_x(0),
+	min_y(0),
+	max_x(MAP_MAX_WIDTH),
+	max_y(MAP_MAX_HEIGHT),
+	max_area(std::numeric_limits<int64_t>::max()),
+	enclosed(false),
+	area(0),
+	last_key(0),
+	last_leaf(nullptr) {
+	////
+}
+
+void FloodFill::setBounds(int min_x, int min_y, int max_x, int max_y) {
+	this->min_x = std::max(0, min_x);
+	this->min_y = std::max(0, min_y);
+	this->max_x = std::min(MAP_MAX_WIDTH, max_x);
+	this->max_y = std::min(MAP_MAX_HEIGHT, max_y);
+}
+
+bool FloodFill::isVisited(int x, int y) {
+	const uint32_t key = getLeafKey(x, y);
+	if (!last_leaf || key != last_key) {
+		auto it = visited.find(key);
+		if (it == visited.end()) {
+			return false;
+		}
+		last_key = key;
+		last_leaf = &it->second;
+	}
+	return (*last_leaf & getLeafBit(x, y)) != 0;
+}
+
+void FloodFill::setVisited(int x, int y) {
+	const uint32_t key = getLeafKey(x, y);
+	if (!last_leaf || key != last_key) {
+		// Inserting does not move the other values of an unordered_map
+		last_key = key;
+		last_leaf = &visited[key];
+	}
+	*last_leaf |= getLeafBit(x, y);
+}
+
+FloodFill::Result FloodFill::run(const Position& start, size_t chunk_size, const Receiver& receiver) {
+	visited.clear();
+	last_leaf = nullptr;
+	area = 0;
+
+	if (start.x < min_x || start.x > max_x || start.y < min_y || start.y > max_y || !inside(start.x, start.y)) {
+		return FILL_DONE;
+	}
+
+	chunk_size = std::max<size_t>(1, chunk_size);
+	PositionVector chunk;
+	chunk.reserve(chunk_size);
+
+	// Each seed is a tile of a span that was not walked yet
+	std::vector<std::pair<int, int>> seeds;
+	seeds.emplace_back(start.x, start.y);
+	while (!seeds.empty()) {
+		const int x = seeds.back().first;
+		const int y = seeds.back().second;
+		seeds.pop_back();
+		if (isVisited(x, y)) {
+			continue;
+		}
+
+		int left = x;
+		while (left > min_x && isOpen(left - 1, y)) {
+			--left;
+		}
+		int right = x;
+		while (right < max_x && isOpen(right + 1, y)) {
+			++right;
+		}
+
+		area += right - left + 1;
+		if (area > max_area) {
+			return FILL_TOO_LARGE;
+		}
+		if (enclosed && (left == min_x || right == max_x || y == min_y || y == max_y)) {
+			return FILL_NOT_ENCLOSED;
+		}
+
+		for (int span_x = left; span_x <= right; ++span_x) {
+			setVisited(span_x, y);
+			chunk.push_back(Position(span_x, y, z));
+			if (chunk.size() == chunk_size) {
+				if (!receiver(chunk)) {
+					return FILL_CANCELLED;
+				}
+				chunk.clear();
+			}
+		}
+
+		// One seed for every run of open tiles above and below the span
+		for (int next_y = y - 1; next_y <= y + 1; next_y += 2) {
+			if (next_y < min_y || next_y > max_y) {
+				continue;
+			}
+			bool in_run = false;
+			for (int span_x = left; span_x <= right; ++span_x) {
+				if (isOpen(span_x, next_y)) {
+					if (!in_run) {
+						seeds.emplace_back(span_x, next_y);
+						in_run = true;
+					}
+				} else {
+					in_run = false;
+				}
+			}
+		}
+	}
+
+	if (!chunk.empty() && !receiver(chunk)) {
+		return FILL_CANCELLED;
+	}
+	return FILL_DONE;
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_FLOOD_FILL_H_
+#define RME_FLOOD_FILL_H_
+
+#include "position.h"
+
+#include <functional>
+#include <unordered_map>
+
+// Finds the 4-connected area around a position on one floor, a horizontal
+// span of tiles at a time. Visited tiles are kept as one bit per tile of a
+// map leaf (4x4 tiles), so memory grows with the area and not with the map.
+// The positions found are handed out in chunks while the search goes on.
+class FloodFill {
+public:
+	enum Result {
+		FILL_DONE,
+		FILL_CANCELLED,
+		// The area has more tiles than the maximum
+		FILL_TOO_LARGE,
+		// The area touches the edge of the bounds, see setEnclosed
+		FILL_NOT_ENCLOSED,
+	};
+
+	// Whether the tile at x, y belongs to the area, called at most a few times per tile
+	typedef std::function<bool(int x, int y)> Predicate;
+	// Gets the next positions of the area, returning false cancels the fill
+	typedef std::function<bool(const PositionVector& positions)> Receiver;
+
+	FloodFill(int z, const Predicate& inside);
+
+	FloodFill(const FloodFill&) = delete;
+	FloodFill& operator=(const FloodFill&) = delete;
+
+	// Tiles outside of the bounds (inclusive) never belong to the area
+	void setBounds(int min_x, int min_y, int max_x, int max_y);
+	void setMaxArea(int64_t max_area) {
+		this->max_area = max_area;
+	}
+	// Fails the fill if the area reaches the edge of the bounds
+	void setEnclosed(bool enclosed) {
+		this->enclosed = enclosed;
+	}
+
+	// Chunks have chunk_size positions except for the last one. Once the fill
+	// fails, the positions it did not hand out yet are dropped.
+	Result run(const Position& start, size_t chunk_size, const Receiver& receiver);
+
+	// Tiles found by the last run
+	int64_t getArea() const {
+		return area;
+	}
+
+private:
+	bool isVisited(int x, int y);
+	void setVisited(int x, int y);
+	bool isOpen(int x, int y) {
+		return !isVisited(x, y) && inside(x, y);
+	}
+
+	int z;
+	Predicate inside;
+	int min_x, min_y;
+	int max_x, max_y;
+	int64_t max_area;
+	bool enclosed;
+	int64_t area;
+
+	// Bit (y & 3) * 4 + (x & 3) of the leaf (x >> 2, y >> 2)
+	std::unordered_map<uint32_t, uint16_t> visited;
+	uint32_t last_key;
+	uint16_t* last_leaf;
+};
+
+#endif
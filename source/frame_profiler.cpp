@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "frame_profiler.h"
+
+FrameProfiler g_profiler;
+
+FrameProfiler::FrameProfiler() :
+	enabled(false),
+	in_frame(false) {
+	////
+}
+
+void FrameProfiler::setEnabled(bool enabled) {
+	if (this->enabled == enabled) {
+		return;
+	}
+	this->enabled = enabled;
+	in_frame = false;
+	if (!enabled) {
+		clear();
+	}
+}
+
+void FrameProfiler::beginFrame() {
+	if (!enabled) {
+		return;
+	}
+	current = Frame();
+	frame_start = Clock::now();
+	in_frame = true;
+}
+
+void FrameProfiler::endFrame() {
+	if (!enabled || !in_frame) {
+		return;
+	}
+	in_frame = false;
+	current.total = elapsed(frame_start);
+
+	history.push_back(current);
+	while (history.size() > HistorySize) {
+		history.pop_front();
+	}
+}
+
+void FrameProfiler::beginStage(Stage stage) {
+	if (enabled) {
+		stage_start[stage] = Clock::now();
+	}
+}
+
+void FrameProfiler::endStage(Stage stage) {
+	if (enabled && in_frame) {
+		current.stages[stage] += elapsed(stage_start[stage]);
+	}
+}
+
+FrameProfiler::Frame FrameProfiler::getAverage() const {
+	Frame average;
+	if (history.empty()) {
+		return average;
+	}
+
+	for (const Frame& frame : history) {
+		average.total += frame.total;
+		for (int i = 0; i < STAGE_COUNT; ++i) {
+			average.stages[i] += frame.stages[i];
+		}
+		for (int i = 0; i < COUNTER_COUNT; ++i) {
+			average.counters[i] += frame.counters[i];
+		}
+	}
+
+	const size_t frames = history.size();
+	average.total /= frames;
+	for (int i = 0; i < STAGE_COUNT; ++i) {
+		average.stages[i] /= frames;
+	}
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		average.counters[i] /= frames;
+	}
+	return average;
+}
+
+void FrameProfiler::clear() {
+	history.clear();
+	current = Frame();
+}
+
+bool FrameProfiler::exportCSV(const std::string& filename) const {
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file << "frame,total_ms";
+	for (int i = 0; i < STAGE_COUNT; ++i) {
+		file << "," << getStageName(static_cast<Stage>(i)) << "_ms";
+	}
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		file << "," << getCounterName(static_cast<Counter>(i));
+	}
+	file << "\n";
+
+	file << std::fixed << std::setprecision(3);
+	int index = 0;
+	for (const Frame& frame : history) {
+		file << index++ << "," << frame.total;
+		for (int i = 0; i < STAGE_COUNT; ++i) {
+			file << "," << frame.stages[i];
+		}
+		for (int i = 0; i < COUNTER_COUNT; ++i) {
+			file << "," << frame.counters[i];
+		}
+		file << "\n";
+	}
+	return file.good();
+}
+
+const char* FrameProfiler::getStageName(Stage stage) {
+	switch (stage) {
+		case STAGE_SPRITE_UPLOAD:
+			return "sprite_upload";
+		case STAGE_SETUP:
+			return "setup";
+		case STAGE_BACKGROUND:
+			return "background";
+		case STAGE_MAP:
+			return "map";
+		case STAGE_HIGHER_FLOORS:
+			return "higher_floors";
+		case STAGE_LIGHT:
+			return "light";
+		case STAGE_TOOLTIPS:
+			return "tooltips";
+		case STAGE_BRUSH:
+			return "brush";
+		default:
+			return "";
+	}
+}
+
+uint32_t FrameProfiler::getStageColor(Stage stage) {
+	switch (stage) {
+		case STAGE_SPRITE_UPLOAD:
+			return 0xC04040;
+		case STAGE_SETUP:
+			return 0x808080;
+		case STAGE_BACKGROUND:
+			return 0x4060C0;
+		case STAGE_MAP:
+			return 0x40C040;
+		case STAGE_HIGHER_FLOORS:
+			return 0x40C0C0;
+		case STAGE_LIGHT:
+			return 0xE0C040;
+		case STAGE_TOOLTIPS:
+			return 0xE08040;
+		case STAGE_BRUSH:
+			return 0xC040C0;
+		default:
+			return 0xFFFFFF;
+	}
+}
+
+const char* FrameProfiler::getCounterName(Counter counter) {
+	switch (counter) {
+		case COUNTER_TILES:
+			return "tiles";
+		case COUNTER_ITEMS:
+			return "items";
+		case COUNTER_TEXTURE_BINDS:
+			return "texture_binds";
+		case COUNTER_TEXTURES_CREATED:
+			return "textures_created";
+		case COUNTER_LIGHTS:
+			return "lights";
+		default:
+			return "";
+	}
+}
@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_FRAME_PROFILER_H_
+#define RME_FRAME_PROFILER_H_
+
+#include <chrono>
+#include <deque>
+
+// Collects the time spent in each drawing stage and a few counters for every
+// painted frame of the map view. Nothing is recorded while it is disabled.
+class FrameProfiler {
+public:
+	enum Stage {
+		STAGE_SPRITE_UPLOAD,
+		STAGE_SETUP,
+		STAGE_BACKGROUND,
+		STAGE_MAP,
+		STAGE_HIGHER_FLOORS,
+		STAGE_LIGHT,
+		STAGE_TOOLTIPS,
+		STAGE_BRUSH,
+		STAGE_COUNT
+	};
+
+	enum Counter {
+		COUNTER_TILES,
+		COUNTER_ITEMS,
+		COUNTER_TEXTURE_BINDS,
+		COUNTER_TEXTURES_CREATED,
+		COUNTER_LIGHTS,
+		COUNTER_COUNT
+	};
+
+	struct Frame {
+		double total = 0.0; // Milliseconds
+		double stages[STAGE_COUNT] = {};
+		uint64_t counters[COUNTER_COUNT] = {};
+	};
+
+	// Times a stage for as long as it lives
+	class ScopedStage {
+	public:
+		ScopedStage(FrameProfiler& profiler, Stage stage) :
+			profiler(profiler), stage(stage) {
+			profiler.beginStage(stage);
+		}
+		~ScopedStage() {
+			profiler.endStage(stage);
+		}
+
+	private:
+		FrameProfiler& profiler;
+		Stage stage;
+	};
+
+	FrameProfiler();
+
+	bool isEnabled() const noexcept {
+		return enabled;
+	}
+	void setEnabled(bool enabled);
+
+	void beginFrame();
+	void endFrame();
+	void beginStage(Stage stage);
+	void endStage(Stage stage);
+
+	void count(Counter counter, uint64_t amount = 1) {
+		if (enabled) {
+			current.counters[counter] += amount;
+		}
+	}
+
+	// Finished frames, oldest first
+	const std::deque<Frame>& getHistory() const noexcept {
+		return history;
+	}
+	Frame getAverage() const;
+	void clear();
+
+	bool exportCSV(const std::string& filename) const;
+
+	static const char* getStageName(Stage stage);
+	static const char* getCounterName(Counter counter);
+	// Color of the stage in the histograms, as 0xRRGGBB
+	static uint32_t getStageColor(Stage stage);
+
+	static const size_t HistorySize = 240;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static double elapsed(Clock::time_point since) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+	}
+
+	bool enabled;
+	bool in_frame;
+	Frame current;
+	Clock::time_point frame_start;
+	Clock::time_point stage_start[STAGE_COUNT];
+	std::deque<Frame> history;
+};
+
+extern FrameProfiler g_profiler;
+
+#endif
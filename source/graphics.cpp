@@ -23,10 +23,12 @@
 #include "settings.h"
 #include "gui.h"
 #include "otml.h"
+#include "frame_profiler.h"
 
 #include <wx/mstream.h>
 #include <wx/stopwatch.h>
 #include <wx/dir.h>
+#include <memory>
 #include "pngfiles.h"
 
 #include "../brushes/door_normal.xpm"
@@ -179,6 +181,20 @@ static uint32_t TemplateOutfitLookupTable[] = {
 	0x7F0000,
 };
 
+static uint8_t getValidOutfitColor(int color) {
+	return color >= 0 && size_t(color) < sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]) ? uint8_t(color) : 0;
+}
+
+static void colorizeOutfitPixel(uint8_t color, uint8_t& red, uint8_t& green, uint8_t& blue) {
+	// Thanks! Khaos, or was it mips? Hmmm... =)
+	uint8_t ro = (TemplateOutfitLookupTable[color] & 0xFF0000) >> 16; // rgb outfit
+	uint8_t go = (TemplateOutfitLookupTable[color] & 0xFF00) >> 8;
+	uint8_t bo = (TemplateOutfitLookupTable[color] & 0xFF);
+	red = (uint8_t)(red * (ro / 255.f));
+	green = (uint8_t)(green * (go / 255.f));
+	blue = (uint8_t)(blue * (bo / 255.f));
+}
+
 GraphicManager::GraphicManager() :
 	client_version(nullptr),
 	unloaded(true),
@@ -188,13 +204,23 @@ GraphicManager::GraphicManager() :
 	has_transparency(false),
 	has_frame_durations(false),
 	has_frame_groups(false),
+	kept_dump_bytes(0),
 	loaded_textures(0),
-	lastclean(0) {
+	lru_head(nullptr),
+	lru_tail(nullptr),
+	texture_frame(0),
+	texture_uploads(0),
+	texture_evictions(0),
+	synchronous_loading(false),
+	placeholder_texture(0) {
 	animation_timer = newd wxStopWatch();
 	animation_timer->Start();
 }
 
 GraphicManager::~GraphicManager() {
+	// The workers may still be reading the sprite dumps
+	sprite_loader.stop();
+
 	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
 		delete iter->second;
 	}
@@ -215,11 +241,78 @@ bool GraphicManager::isUnloaded() const {
 }
 
 GLuint GraphicManager::getFreeTextureID() {
+	if (!free_texture_ids.empty()) {
+		GLuint id = free_texture_ids.back();
+		free_texture_ids.pop_back();
+		return id;
+	}
 	static GLuint id_counter = 0x10000000;
 	return id_counter++; // This should (hopefully) never run out
 }
 
+void GraphicManager::releaseTextureID(GLuint id) {
+	free_texture_ids.push_back(id);
+}
+
+bool GraphicManager::requestSprite(GameSprite::NormalImage* image) {
+	if (synchronous_loading || g_settings.getInteger(Config::SPRITE_UPLOAD_BUDGET) <= 0) {
+		return false;
+	}
+
+	// Memcached dumps stay around until the sprites are cleared, the others are read from the file by the loader
+	bool memcached = g_settings.getInteger(Config::USE_MEMCACHED_SPRITES);
+	if (memcached && !image->dump) {
+		return false;
+	}
+
+	if (!image->pending) {
+		if (!sprite_loader.isRunning()) {
+			sprite_loader.start(spritefile, is_extended, has_transparency, g_settings.getWorkerThreads());
+		}
+		sprite_loader.request(image->id, memcached ? image->dump : nullptr, memcached ? image->size : 0);
+		image->pending = true;
+	}
+	return true;
+}
+
+bool GraphicManager::uploadDecodedSprites() {
+	if (!sprite_loader.isRunning()) {
+		return false;
+	}
+
+	std::vector<SpriteLoader::Decoded> sprites;
+	sprite_loader.takeDecoded(sprites, std::max(g_settings.getInteger(Config::SPRITE_UPLOAD_BUDGET), 1));
+
+	for (SpriteLoader::Decoded& sprite : sprites) {
+		ImageMap::iterator it = image_space.find(sprite.id);
+		GameSprite::NormalImage* image = it != image_space.end() ? dynamic_cast<GameSprite::NormalImage*>(it->second) : nullptr;
+		// Sprites that failed to load keep their placeholder instead of being requested every frame
+		if (image && sprite.rgba) {
+			image->pending = false;
+			if (!image->isGLLoaded) {
+				image->uploadGLTexture(image->id, sprite.rgba);
+			}
+		}
+		delete[] sprite.rgba;
+	}
+	return sprite_loader.hasDecoded();
+}
+
+GLuint GraphicManager::getPlaceholderTextureID() {
+	if (placeholder_texture == 0) {
+		const uint8_t pixel[PixelFormatRGBA] = { 0x80, 0x80, 0x80, 0x40 };
+		placeholder_texture = getFreeTextureID();
+		glBindTexture(GL_TEXTURE_2D, placeholder_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	}
+	return placeholder_texture;
+}
+
 void GraphicManager::clear() {
+	sprite_loader.stop();
+
 	SpriteMap new_sprite_space;
 	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
 		if (iter->first >= 0) { // Don't clean internal sprites
@@ -236,11 +329,11 @@ void GraphicManager::clear() {
 	sprite_space.swap(new_sprite_space);
 	image_space.clear();
 	cleanup_list.clear();
+	kept_dumps.clear();
+	kept_dump_bytes = 0;
 
 	item_count = 0;
 	creature_count = 0;
-	loaded_textures = 0;
-	lastclean = time(nullptr);
 	spritefile = "";
 
 	unloaded = true;
@@ -692,10 +785,8 @@ bool GraphicManager::loadSpriteMetadataFlags(FileReadHandle& file, GameSprite* s
 			case DatFlagHookEast:
 			case DatFlagRotateable:
 			case DatFlagDontHide:
-			case DatFlagTranslucent:
 			case DatFlagLyingCorpse:
 			case DatFlagAnimateAlways:
-			case DatFlagFullGround:
 			case DatFlagLook:
 			case DatFlagWrappable:
 			case DatFlagUnwrappable:
@@ -705,6 +796,14 @@ bool GraphicManager::loadSpriteMetadataFlags(FileReadHandle& file, GameSprite* s
 			case DatFlagChargeable:
 				break;
 
+			case DatFlagTranslucent:
+				sType->translucent = true;
+				break;
+
+			case DatFlagFullGround:
+				sType->full_ground = true;
+				break;
+
 			case DatFlagGround:
 			case DatFlagWritable:
 			case DatFlagWritableOnce:
@@ -891,6 +990,18 @@ bool GraphicManager::loadSpriteDump(uint8_t*& target, uint16_t& size, int sprite
 	return false;
 }
 
+void GraphicManager::keepSpriteDump(GameSprite::NormalImage* image) {
+	kept_dumps.push_back(image);
+	kept_dump_bytes += image->size;
+	while (kept_dump_bytes > MaxKeptDumpBytes) {
+		GameSprite::NormalImage* oldest = kept_dumps.front();
+		kept_dumps.pop_front();
+		kept_dump_bytes -= oldest->size;
+		delete[] oldest->dump;
+		oldest->dump = nullptr;
+	}
+}
+
 void GraphicManager::addSpriteToCleanup(GameSprite* spr) {
 	cleanup_list.push_back(spr);
 	// Clean if needed
@@ -904,24 +1015,75 @@ void GraphicManager::addSpriteToCleanup(GameSprite* spr) {
 
 void GraphicManager::garbageCollection() {
 	if (g_settings.getInteger(Config::TEXTURE_MANAGEMENT)) {
-		int t = time(nullptr);
-		if (loaded_textures > g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD) && t - lastclean > g_settings.getInteger(Config::TEXTURE_CLEAN_PULSE)) {
-			ImageMap::iterator iit = image_space.begin();
-			while (iit != image_space.end()) {
-				iit->second->clean(t);
-				++iit;
-			}
-			SpriteMap::iterator sit = sprite_space.begin();
-			while (sit != sprite_space.end()) {
-				GameSprite* gs = dynamic_cast<GameSprite*>(sit->second);
-				if (gs) {
-					gs->clean(t);
-				}
-				++sit;
-			}
-			lastclean = t;
+		// Textures drawn this frame stay, even if that means going over the budget
+		int budget = g_settings.getInteger(Config::TEXTURE_MEMORY_BUDGET) * 1024 * 1024 / (SPRITE_PIXELS_SIZE * PixelFormatRGBA);
+		while (loaded_textures > budget && lru_tail && lru_tail->lastaccess != texture_frame) {
+			lru_tail->unloadTexture();
+			++texture_evictions;
 		}
 	}
+	++texture_frame;
+}
+
+GraphicManager::TextureStats GraphicManager::getTextureStats() const {
+	TextureStats stats;
+	stats.resident = loaded_textures;
+	stats.resident_bytes = static_cast<size_t>(loaded_textures) * SPRITE_PIXELS_SIZE * PixelFormatRGBA;
+	stats.uploads = texture_uploads;
+	stats.evictions = texture_evictions;
+	return stats;
+}
+
+void GraphicManager::addTexture(GameSprite::Image* image) {
+	image->lru_prev = nullptr;
+	image->lru_next = lru_head;
+	if (lru_head) {
+		lru_head->lru_prev = image;
+	} else {
+		lru_tail = image;
+	}
+	lru_head = image;
+
+	++loaded_textures;
+	++texture_uploads;
+	g_profiler.count(FrameProfiler::COUNTER_TEXTURES_CREATED);
+}
+
+void GraphicManager::touchTexture(GameSprite::Image* image) {
+	image->lastaccess = texture_frame;
+	if (!image->isGLLoaded || image == lru_head) {
+		return;
+	}
+
+	// Unlink, the image isn't the head so it has a previous entry
+	image->lru_prev->lru_next = image->lru_next;
+	if (image->lru_next) {
+		image->lru_next->lru_prev = image->lru_prev;
+	} else {
+		lru_tail = image->lru_prev;
+	}
+
+	image->lru_prev = nullptr;
+	image->lru_next = lru_head;
+	lru_head->lru_prev = image;
+	lru_head = image;
+}
+
+void GraphicManager::removeTexture(GameSprite::Image* image) {
+	if (image->lru_prev) {
+		image->lru_prev->lru_next = image->lru_next;
+	} else {
+		lru_head = image->lru_next;
+	}
+	if (image->lru_next) {
+		image->lru_next->lru_prev = image->lru_prev;
+	} else {
+		lru_tail = image->lru_prev;
+	}
+	image->lru_prev = nullptr;
+	image->lru_next = nullptr;
+
+	--loaded_textures;
 }
 
 EditorSprite::EditorSprite(wxBitmap* b16x16, wxBitmap* b32x32) {
@@ -968,21 +1130,13 @@ GameSprite::GameSprite() :
 
 GameSprite::~GameSprite() {
 	unloadDC();
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin(); iter != instanced_templates.end(); ++iter) {
-		delete *iter;
+	for (auto& it : instanced_templates) {
+		delete it.second;
 	}
 
 	delete animator;
 }
 
-void GameSprite::clean(int time) {
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin();
-		 iter != instanced_templates.end();
-		 ++iter) {
-		(*iter)->clean(time);
-	}
-}
-
 void GameSprite::unloadDC() {
 	delete dc[SPRITE_SIZE_16x16];
 	delete dc[SPRITE_SIZE_32x32];
@@ -1002,11 +1156,59 @@ uint8_t GameSprite::getMiniMapColor() const {
 	return minimap_color;
 }
 
+void GameSprite::prefetch() {
+	for (NormalImage* image : spriteList) {
+		if (!image->isGLLoaded) {
+			g_gui.gfx.requestSprite(image);
+		}
+	}
+}
+
+uint32_t GameSprite::getAverageColor() {
+	if (has_average_color) {
+		return average_color;
+	}
+	has_average_color = true;
+
+	uint8_t* rgba = spriteList.empty() ? nullptr : spriteList[0]->getRGBAData();
+	if (!rgba) {
+		// Fall back to the minimap color if the sprite can't be read
+		if (minimap_color != 0) {
+			const RGBQuad& color = ::minimap_color[minimap_color];
+			average_color = color.red | (color.green << 8) | (color.blue << 16) | (0xFFu << 24);
+		}
+		return average_color;
+	}
+
+	uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+	for (int i = 0; i < SPRITE_PIXELS_SIZE * 4; i += 4) {
+		uint32_t a = rgba[i + 3];
+		red += rgba[i] * a;
+		green += rgba[i + 1] * a;
+		blue += rgba[i + 2] * a;
+		alpha += a;
+	}
+	delete[] rgba;
+
+	if (alpha != 0) {
+		red /= alpha;
+		green /= alpha;
+		blue /= alpha;
+		alpha /= SPRITE_PIXELS_SIZE;
+		average_color = red | (green << 8) | (blue << 16) | (alpha << 24);
+	}
+	return average_color;
+}
+
 int GameSprite::getIndex(int width, int height, int layer, int pattern_x, int pattern_y, int pattern_z, int frame) const {
 	return ((((((frame % this->frames) * this->pattern_z + pattern_z) * this->pattern_y + pattern_y) * this->pattern_x + pattern_x) * this->layers + layer) * this->height + height) * this->width + width;
 }
 
 GLuint GameSprite::getHardwareID(int _x, int _y, int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) {
+	return spriteList[getSpriteIndex(_x, _y, _layer, _count, _pattern_x, _pattern_y, _pattern_z, _frame)]->getHardwareID();
+}
+
+uint32_t GameSprite::getSpriteIndex(int _x, int _y, int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) const {
 	uint32_t v;
 	if (_count >= 0 && height <= 1 && width <= 1) {
 		v = _count;
@@ -1020,31 +1222,56 @@ GLuint GameSprite::getHardwareID(int _x, int _y, int _layer, int _count, int _pa
 			v %= numsprites;
 		}
 	}
-	return spriteList[v]->getHardwareID();
+	return v;
+}
+
+uint32_t GameSprite::getSpriteID(uint32_t sprite_index) const {
+	return spriteList[sprite_index]->id;
+}
+
+uint8_t* GameSprite::decodeRGBAData(uint32_t sprite_index, FileReadHandle* fh) const {
+	const NormalImage* image = spriteList[sprite_index];
+	if (!fh) {
+		// Memcached dumps stay until the sprites are cleared
+		return image->dump ? SpriteLoader::decode(image->dump, image->size, g_gui.gfx.hasTransparency()) : nullptr;
+	}
+
+	std::vector<uint8_t> dump;
+	if (!fh->isOk() || !SpriteLoader::readDump(*fh, g_gui.gfx.isExtended(), image->id, dump)) {
+		return nullptr;
+	}
+	return SpriteLoader::decode(dump.data(), static_cast<uint16_t>(dump.size()), g_gui.gfx.hasTransparency());
 }
 
 GameSprite::TemplateImage* GameSprite::getTemplateImage(int sprite_index, const Outfit& outfit) {
-	if (instanced_templates.empty()) {
-		TemplateImage* img = newd TemplateImage(this, sprite_index, outfit);
-		instanced_templates.push_back(img);
-		return img;
-	}
-	// While this is linear lookup, it is very rare for the list to contain more than 4-8 entries, so it's faster than a hashmap anyways.
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin(); iter != instanced_templates.end(); ++iter) {
-		TemplateImage* img = *iter;
-		if (img->sprite_index == sprite_index) {
-			uint32_t lookHash = img->lookHead << 24 | img->lookBody << 16 | img->lookLegs << 8 | img->lookFeet;
-			if (outfit.getColorHash() == lookHash) {
-				return img;
+	const uint64_t key = (uint64_t(sprite_index) << 32) | outfit.getColorHash();
+	auto it = instanced_templates.find(key);
+	if (it != instanced_templates.end()) {
+		return it->second;
+	}
+
+	if (instanced_templates.size() >= MaxTemplateImages) {
+		// Spawns with many differently dressed creatures would otherwise keep a texture for every outfit.
+		// Templates drawn in this frame are still needed, so with more of them on screen the cache grows.
+		const int frame = g_gui.gfx.getTextureFrame();
+		auto oldest = instanced_templates.end();
+		for (auto iter = instanced_templates.begin(); iter != instanced_templates.end(); ++iter) {
+			if (iter->second->lastaccess != frame && (oldest == instanced_templates.end() || iter->second->lastaccess < oldest->second->lastaccess)) {
+				oldest = iter;
 			}
 		}
+		if (oldest != instanced_templates.end()) {
+			delete oldest->second;
+			instanced_templates.erase(oldest);
+		}
 	}
+
 	TemplateImage* img = newd TemplateImage(this, sprite_index, outfit);
-	instanced_templates.push_back(img);
+	instanced_templates.emplace(key, img);
 	return img;
 }
 
-GLuint GameSprite::getHardwareID(int _x, int _y, int _dir, int _addon, int _pattern_z, const Outfit& _outfit, int _frame) {
+uint32_t GameSprite::getOutfitSpriteIndex(int _x, int _y, int _dir, int _addon, int _pattern_z, int _frame) const {
 	uint32_t v = getIndex(_x, _y, 0, _dir, _addon, _pattern_z, _frame);
 	if (v >= numsprites) {
 		if (numsprites == 1) {
@@ -1053,6 +1280,47 @@ GLuint GameSprite::getHardwareID(int _x, int _y, int _dir, int _addon, int _patt
 			v %= numsprites;
 		}
 	}
+	return v;
+}
+
+uint8_t* GameSprite::decodeOutfitRGBAData(uint32_t sprite_index, const Outfit& outfit, FileReadHandle* fh) const {
+	uint8_t* rgba = decodeRGBAData(sprite_index, fh);
+	const uint32_t template_index = sprite_index + height * width;
+	if (!rgba || layers <= 1 || template_index >= numsprites) {
+		return rgba;
+	}
+
+	std::unique_ptr<uint8_t[]> mask(decodeRGBAData(template_index, fh));
+	if (!mask) {
+		return rgba;
+	}
+
+	const uint8_t head = getValidOutfitColor(outfit.lookHead);
+	const uint8_t body = getValidOutfitColor(outfit.lookBody);
+	const uint8_t legs = getValidOutfitColor(outfit.lookLegs);
+	const uint8_t feet = getValidOutfitColor(outfit.lookFeet);
+	for (int i = 0; i < SPRITE_PIXELS_SIZE * 4; i += 4) {
+		const uint8_t* t = &mask[i];
+		uint8_t& red = rgba[i + 0];
+		uint8_t& green = rgba[i + 1];
+		uint8_t& blue = rgba[i + 2];
+		if (t[3] == 0) {
+			continue;
+		} else if (t[0] && t[1] && !t[2]) { // yellow => head
+			colorizeOutfitPixel(head, red, green, blue);
+		} else if (t[0] && !t[1] && !t[2]) { // red => body
+			colorizeOutfitPixel(body, red, green, blue);
+		} else if (!t[0] && t[1] && !t[2]) { // green => legs
+			colorizeOutfitPixel(legs, red, green, blue);
+		} else if (!t[0] && !t[1] && t[2]) { // blue => feet
+			colorizeOutfitPixel(feet, red, green, blue);
+		}
+	}
+	return rgba;
+}
+
+GLuint GameSprite::getHardwareID(int _x, int _y, int _dir, int _addon, int _pattern_z, const Outfit& _outfit, int _frame) {
+	const uint32_t v = getOutfitSpriteIndex(_x, _y, _dir, _addon, _pattern_z, _frame);
 	if (layers > 1) { // Template
 		TemplateImage* img = getTemplateImage(v, _outfit);
 		return img->getHardwareID();
@@ -1121,7 +1389,9 @@ void GameSprite::DrawTo(wxDC* dc, SpriteSize sz, int start_x, int start_y, int w
 
 GameSprite::Image::Image() :
 	isGLLoaded(false),
-	lastaccess(0) {
+	lastaccess(0),
+	lru_prev(nullptr),
+	lru_next(nullptr) {
 	////
 }
 
@@ -1137,8 +1407,13 @@ void GameSprite::Image::createGLTexture(GLuint whatid) {
 		return;
 	}
 
+	uploadGLTexture(whatid, rgba);
+	delete[] rgba;
+}
+
+void GameSprite::Image::uploadGLTexture(GLuint whatid, const uint8_t* rgba) {
 	isGLLoaded = true;
-	g_gui.gfx.loaded_textures += 1;
+	g_gui.gfx.addTexture(this);
 
 	glBindTexture(GL_TEXTURE_2D, whatid);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Linear Filtering
@@ -1146,31 +1421,25 @@ void GameSprite::Image::createGLTexture(GLuint whatid) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); // GL_CLAMP_TO_EDGE
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F); // GL_CLAMP_TO_EDGE
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SPRITE_PIXELS, SPRITE_PIXELS, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
-
-	delete[] rgba;
-#undef SPRITE_SIZE
 }
 
 void GameSprite::Image::unloadGLTexture(GLuint whatid) {
+	if (isGLLoaded) {
+		g_gui.gfx.removeTexture(this);
+	}
 	isGLLoaded = false;
-	g_gui.gfx.loaded_textures -= 1;
 	glDeleteTextures(1, &whatid);
 }
 
 void GameSprite::Image::visit() {
-	lastaccess = time(nullptr);
-}
-
-void GameSprite::Image::clean(int time) {
-	if (isGLLoaded && time - lastaccess > g_settings.getInteger(Config::TEXTURE_LONGEVITY)) {
-		unloadGLTexture(0);
-	}
+	g_gui.gfx.touchTexture(this);
 }
 
 GameSprite::NormalImage::NormalImage() :
 	id(0),
 	size(0),
-	dump(nullptr) {
+	dump(nullptr),
+	pending(false) {
 	////
 }
 
@@ -1178,23 +1447,9 @@ GameSprite::NormalImage::~NormalImage() {
 	delete[] dump;
 }
 
-void GameSprite::NormalImage::clean(int time) {
-	Image::clean(time);
-	if (time - lastaccess > 5 && !g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) { // We keep dumps around for 5 seconds.
-		delete[] dump;
-		dump = nullptr;
-	}
-}
-
 uint8_t* GameSprite::NormalImage::getRGBData() {
-	if (!dump) {
-		if (g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) {
-			return nullptr;
-		}
-
-		if (!g_gui.gfx.loadSpriteDump(dump, size, id)) {
-			return nullptr;
-		}
+	if (!loadDump()) {
+		return nullptr;
 	}
 
 	const int pixels_data_size = SPRITE_PIXELS * SPRITE_PIXELS * 3;
@@ -1232,67 +1487,36 @@ uint8_t* GameSprite::NormalImage::getRGBData() {
 		data[write + 2] = 0xFF; // blue
 		write += 3;
 	}
+
 	return data;
 }
 
 uint8_t* GameSprite::NormalImage::getRGBAData() {
-	if (!dump) {
-		if (g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) {
-			return nullptr;
-		}
-
-		if (!g_gui.gfx.loadSpriteDump(dump, size, id)) {
-			return nullptr;
-		}
+	if (!loadDump()) {
+		return nullptr;
 	}
 
-	const int pixels_data_size = SPRITE_PIXELS_SIZE * 4;
-	uint8_t* data = newd uint8_t[pixels_data_size];
-	bool use_alpha = g_gui.gfx.hasTransparency();
-	uint8_t bpp = use_alpha ? 4 : 3;
-	int write = 0;
-	int read = 0;
-
-	// decompress pixels
-	while (read < size && write < pixels_data_size) {
-		int transparent = dump[read] | dump[read + 1] << 8;
-		if (use_alpha && transparent >= SPRITE_PIXELS_SIZE) { // Corrupted sprite?
-			break;
-		}
-		read += 2;
-		for (int i = 0; i < transparent && write < pixels_data_size; i++) {
-			data[write + 0] = 0x00; // red
-			data[write + 1] = 0x00; // green
-			data[write + 2] = 0x00; // blue
-			data[write + 3] = 0x00; // alpha
-			write += 4;
-		}
+	return SpriteLoader::decode(dump, size, g_gui.gfx.hasTransparency());
+}
 
-		int colored = dump[read] | dump[read + 1] << 8;
-		read += 2;
-		for (int i = 0; i < colored && write < pixels_data_size; i++) {
-			data[write + 0] = dump[read + 0]; // red
-			data[write + 1] = dump[read + 1]; // green
-			data[write + 2] = dump[read + 2]; // blue
-			data[write + 3] = use_alpha ? dump[read + 3] : 0xFF; // alpha
-			write += 4;
-			read += bpp;
-		}
+bool GameSprite::NormalImage::loadDump() {
+	if (dump) {
+		return true;
 	}
-
-	// fill remaining pixels
-	while (write < pixels_data_size) {
-		data[write + 0] = 0x00; // red
-		data[write + 1] = 0x00; // green
-		data[write + 2] = 0x00; // blue
-		data[write + 3] = 0x00; // alpha
-		write += 4;
+	if (g_settings.getInteger(Config::USE_MEMCACHED_SPRITES) || !g_gui.gfx.loadSpriteDump(dump, size, id)) {
+		return false;
 	}
-	return data;
+	if (dump) {
+		g_gui.gfx.keepSpriteDump(this);
+	}
+	return true;
 }
 
 GLuint GameSprite::NormalImage::getHardwareID() {
 	if (!isGLLoaded) {
+		if (g_gui.gfx.requestSprite(this)) {
+			return g_gui.gfx.getPlaceholderTextureID();
+		}
 		createGLTexture(id);
 	}
 	visit();
@@ -1315,21 +1539,21 @@ GameSprite::TemplateImage::TemplateImage(GameSprite* parent, int v, const Outfit
 	lookBody(outfit.lookBody),
 	lookLegs(outfit.lookLegs),
 	lookFeet(outfit.lookFeet) {
-	////
+	lookHead = getValidOutfitColor(lookHead);
+	lookBody = getValidOutfitColor(lookBody);
+	lookLegs = getValidOutfitColor(lookLegs);
+	lookFeet = getValidOutfitColor(lookFeet);
 }
 
 GameSprite::TemplateImage::~TemplateImage() {
-	////
+	unloadTexture();
+	if (gl_tid != 0) {
+		g_gui.gfx.releaseTextureID(gl_tid);
+	}
 }
 
 void GameSprite::TemplateImage::colorizePixel(uint8_t color, uint8_t& red, uint8_t& green, uint8_t& blue) {
-	// Thanks! Khaos, or was it mips? Hmmm... =)
-	uint8_t ro = (TemplateOutfitLookupTable[color] & 0xFF0000) >> 16; // rgb outfit
-	uint8_t go = (TemplateOutfitLookupTable[color] & 0xFF00) >> 8;
-	uint8_t bo = (TemplateOutfitLookupTable[color] & 0xFF);
-	red = (uint8_t)(red * (ro / 255.f));
-	green = (uint8_t)(green * (go / 255.f));
-	blue = (uint8_t)(blue * (bo / 255.f));
+	colorizeOutfitPixel(color, red, green, blue);
 }
 
 uint8_t* GameSprite::TemplateImage::getRGBData() {
@@ -1345,19 +1569,6 @@ uint8_t* GameSprite::TemplateImage::getRGBData() {
 		return nullptr;
 	}
 
-	if (lookHead > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookHead = 0;
-	}
-	if (lookBody > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookBody = 0;
-	}
-	if (lookLegs > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookLegs = 0;
-	}
-	if (lookFeet > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookFeet = 0;
-	}
-
 	for (int y = 0; y < SPRITE_PIXELS; ++y) {
 		for (int x = 0; x < SPRITE_PIXELS; ++x) {
 			uint8_t& red = rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 0];
@@ -1396,19 +1607,6 @@ uint8_t* GameSprite::TemplateImage::getRGBAData() {
 		return nullptr;
 	}
 
-	if (lookHead > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookHead = 0;
-	}
-	if (lookBody > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookBody = 0;
-	}
-	if (lookLegs > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookLegs = 0;
-	}
-	if (lookFeet > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		lookFeet = 0;
-	}
-
 	for (int y = 0; y < SPRITE_PIXELS; ++y) {
 		for (int x = 0; x < SPRITE_PIXELS; ++x) {
 			uint8_t& red = rgbadata[y * SPRITE_PIXELS * 4 + x * 4 + 0];
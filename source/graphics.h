@@ -21,8 +21,10 @@
 #include "outfit.h"
 #include "common.h"
 #include <deque>
+#include <unordered_map>
 
 #include "client_version.h"
+#include "sprite_loader.h"
 
 enum SpriteSize {
 	SPRITE_SIZE_16x16,
@@ -82,13 +84,22 @@ public:
 
 	int getIndex(int width, int height, int layer, int pattern_x, int pattern_y, int pattern_z, int frame) const;
 	GLuint getHardwareID(int _x, int _y, int _layer, int _subtype, int _pattern_x, int _pattern_y, int _pattern_z, int _frame);
+	// Index in the sprite list of the image getHardwareID draws
+	uint32_t getSpriteIndex(int _x, int _y, int _layer, int _subtype, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) const;
+	uint32_t getSpriteID(uint32_t sprite_index) const;
+	// Decoded 32x32 RGBA pixels allocated with new[], nullptr if the sprite can't be read.
+	// Nothing is cached so any thread may call it, fh is the caller's own handle of the
+	// sprite file (see GraphicManager::getSpriteFile), nullptr if the sprites are memcached
+	uint8_t* decodeRGBAData(uint32_t sprite_index, FileReadHandle* fh) const;
+	// Index in the sprite list of the image the outfit getHardwareID draws
+	uint32_t getOutfitSpriteIndex(int _x, int _y, int _dir, int _addon, int _pattern_z, int _frame) const;
+	// Same as decodeRGBAData, with the template of the sprite painted in the colors of the outfit
+	uint8_t* decodeOutfitRGBAData(uint32_t sprite_index, const Outfit& outfit, FileReadHandle* fh) const;
 	GLuint getHardwareID(int _x, int _y, int _dir, int _addon, int _pattern_z, const Outfit& _outfit, int _frame); // CreatureDatabase
 	virtual void DrawTo(wxDC* dc, SpriteSize sz, int start_x, int start_y, int width = -1, int height = -1);
 
 	virtual void unloadDC();
 
-	void clean(int time);
-
 	int getDrawHeight() const;
 	std::pair<int, int> getDrawOffset() const;
 	uint8_t getMiniMapColor() const;
@@ -99,6 +110,14 @@ public:
 	const SpriteLight& getLight() const noexcept {
 		return light;
 	}
+	// Opaque ground that completely hides whatever is drawn below it
+	bool isFullGround() const noexcept {
+		return full_ground && !translucent;
+	}
+	// Mean color of the first sprite weighted by its alpha, packed as RGBA bytes (alpha is the coverage)
+	uint32_t getAverageColor();
+	// Queues every image of this sprite that isn't on the GPU yet for background loading
+	void prefetch();
 
 protected:
 	class Image;
@@ -114,15 +133,23 @@ protected:
 		virtual ~Image();
 
 		bool isGLLoaded;
-		int lastaccess;
+		int lastaccess; // Frame the texture was last drawn in
+
+		// Intrusive list of the resident textures, most recently used first
+		Image* lru_prev;
+		Image* lru_next;
 
 		void visit();
-		virtual void clean(int time);
+		void unloadTexture() {
+			unloadGLTexture(0);
+		}
 
 		virtual GLuint getHardwareID() = 0;
 		virtual uint8_t* getRGBData() = 0;
 		virtual uint8_t* getRGBAData() = 0;
 
+		void uploadGLTexture(GLuint whatid, const uint8_t* rgba);
+
 	protected:
 		virtual void createGLTexture(GLuint whatid);
 		virtual void unloadGLTexture(GLuint whatid);
@@ -140,13 +167,17 @@ protected:
 		uint16_t size;
 		uint8_t* dump;
 
-		virtual void clean(int time);
+		// Queued for background loading
+		bool pending;
 
 		virtual GLuint getHardwareID();
 		virtual uint8_t* getRGBData();
 		virtual uint8_t* getRGBAData();
 
 	protected:
+		// Reads the dump from the sprite file if it's not in memory
+		bool loadDump();
+
 		virtual void createGLTexture(GLuint ignored = 0);
 		virtual void unloadGLTexture(GLuint ignored = 0);
 	};
@@ -200,8 +231,18 @@ public:
 	bool has_light = false;
 	SpriteLight light;
 
+	bool full_ground = false;
+	bool translucent = false;
+
+	bool has_average_color = false;
+	uint32_t average_color = 0;
+
 	std::vector<NormalImage*> spriteList;
-	std::list<TemplateImage*> instanced_templates; // Templates that use this sprite
+	// Colorized templates of this sprite by sprite index and outfit colors, once
+	// MaxTemplateImages is reached the least recently drawn one is dropped, unless
+	// all of them were drawn in the current frame
+	std::unordered_map<uint64_t, TemplateImage*> instanced_templates;
+	static const size_t MaxTemplateImages = 64;
 
 	friend class GraphicManager;
 };
@@ -283,6 +324,23 @@ public:
 
 	// Get an unused texture id (this is acquired by simply increasing a value starting from 0x10000000)
 	GLuint getFreeTextureID();
+	// Gives back an id from getFreeTextureID once its texture was deleted
+	void releaseTextureID(GLuint id);
+	// Increased after every paint, textures drawn in it have it as lastaccess
+	int getTextureFrame() const {
+		return texture_frame;
+	}
+
+	// Queues the image for background decoding, returns false if it has to be loaded right away
+	bool requestSprite(GameSprite::NormalImage* image);
+	// Uploads the decoded images within the per frame budget, returns true if some are still waiting
+	bool uploadDecodedSprites();
+	// Drawn in place of images that are still being loaded
+	GLuint getPlaceholderTextureID();
+	// Disables background loading, for screenshots
+	void setSynchronousLoading(bool sync) {
+		synchronous_loading = sync;
+	}
 
 	// This is part of the binary
 	bool loadEditorSprites();
@@ -293,7 +351,7 @@ public:
 	bool loadSpriteMetadataFlags(FileReadHandle& file, GameSprite* sType, wxString& error, wxArrayString& warnings);
 	bool loadSpriteData(const FileName& datafile, wxString& error, wxArrayString& warnings);
 
-	// Cleans old & unused textures according to config settings
+	// Unloads the least recently used textures until the texture budget is met
 	void garbageCollection();
 	void addSpriteToCleanup(GameSprite* spr);
 
@@ -306,6 +364,20 @@ public:
 
 	bool hasTransparency() const;
 	bool isUnloaded() const;
+	bool isExtended() const {
+		return is_extended;
+	}
+	const std::string& getSpriteFile() const {
+		return spritefile;
+	}
+
+	struct TextureStats {
+		int resident;
+		size_t resident_bytes;
+		uint64_t uploads;
+		uint64_t evictions;
+	};
+	TextureStats getTextureStats() const;
 
 	ClientVersion* client_version;
 
@@ -332,8 +404,30 @@ private:
 	wxFileName metadata_file;
 	wxFileName sprites_file;
 
+	// Dumps read from the sprite file are kept until this many bytes of newer
+	// ones were read, so templates and average colors don't read them again
+	void keepSpriteDump(GameSprite::NormalImage* image);
+	std::deque<GameSprite::NormalImage*> kept_dumps;
+	size_t kept_dump_bytes;
+	static const size_t MaxKeptDumpBytes = 4 * 1024 * 1024;
+
+	// Resident textures, kept in least recently used order
+	void addTexture(GameSprite::Image* image);
+	void touchTexture(GameSprite::Image* image);
+	void removeTexture(GameSprite::Image* image);
+
 	int loaded_textures;
-	int lastclean;
+	GameSprite::Image* lru_head;
+	GameSprite::Image* lru_tail;
+	int texture_frame;
+	uint64_t texture_uploads;
+	uint64_t texture_evictions;
+
+	std::vector<GLuint> free_texture_ids;
+
+	SpriteLoader sprite_loader;
+	bool synchronous_loading;
+	GLuint placeholder_texture;
 
 	wxStopWatch* animation_timer;
 
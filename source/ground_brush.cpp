@@ -22,6 +22,9 @@
 #include "basemap.h"
 
 uint32_t GroundBrush::border_types[256];
+std::vector<const GroundBrush::BorderBlock*> GroundBrush::transition_blocks;
+std::vector<uint16_t> GroundBrush::transition_table;
+uint32_t GroundBrush::transition_size = 0;
 
 int AutoBorder::edgeNameToID(const std::string& edgename) {
 	if (edgename == "n") {
@@ -122,7 +125,8 @@ GroundBrush::GroundBrush() :
 	optional_border(nullptr),
 	use_only_optional(false),
 	randomize(true),
-	total_chance(0) {
+	total_chance(0),
+	table_index(0) {
 	////
 }
 
@@ -556,22 +560,87 @@ void GroundBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 			return;
 		}
 	}
-	int chance = random(1, total_chance);
-	uint16_t id = 0;
+	tile->addItem(Item::Create(getGroundID(random(1, total_chance))));
+}
+
+uint16_t GroundBrush::getGroundID(int chance) const {
+	if (border_items.empty()) {
+		return 0;
+	}
+
 	for (std::vector<ItemChanceBlock>::const_iterator it = border_items.begin(); it != border_items.end(); ++it) {
 		if (chance < it->chance) {
-			id = it->id;
-			break;
+			return it->id;
 		}
 	}
-	if (id == 0) {
-		id = border_items.front().id;
+	return border_items.front().id;
+}
+
+const GroundBrush::BorderBlock* GroundBrush::getBrushTo(GroundBrush* first, GroundBrush* second) {
+	const uint32_t first_index = first ? first->table_index : 0;
+	const uint32_t second_index = second ? second->table_index : 0;
+	if (transition_size == 0 || (first && first_index == 0) || (second && second_index == 0)) {
+		return findBrushTo(first, second);
+	}
+	return transition_blocks[transition_table[first_index * transition_size + second_index]];
+}
+
+void GroundBrush::buildTransitionTable() {
+	clearTransitionTable();
+
+	std::vector<GroundBrush*> grounds;
+	for (const auto& brushEntry : g_brushes.getMap()) {
+		if (brushEntry.second->isGround()) {
+			grounds.push_back(brushEntry.second->asGround());
+		}
+	}
+	if (grounds.size() >= MaxTransitionBrushes) {
+		return;
 	}
 
-	tile->addItem(Item::Create(id));
+	const uint32_t size = grounds.size() + 1;
+	for (uint32_t i = 0; i < grounds.size(); ++i) {
+		grounds[i]->table_index = i + 1;
+	}
+
+	std::map<const BorderBlock*, uint16_t> block_indexes;
+	transition_blocks.push_back(nullptr);
+	transition_table.assign(size * size, 0);
+	for (uint32_t first = 0; first < size; ++first) {
+		for (uint32_t second = 0; second < size; ++second) {
+			const BorderBlock* borderBlock = findBrushTo(first ? grounds[first - 1] : nullptr, second ? grounds[second - 1] : nullptr);
+			if (!borderBlock) {
+				continue;
+			}
+
+			auto it = block_indexes.find(borderBlock);
+			if (it == block_indexes.end()) {
+				if (transition_blocks.size() > 0xFFFF) {
+					// Can not be indexed, leave it to the search
+					clearTransitionTable();
+					return;
+				}
+				it = block_indexes.emplace(borderBlock, uint16_t(transition_blocks.size())).first;
+				transition_blocks.push_back(borderBlock);
+			}
+			transition_table[first * size + second] = it->second;
+		}
+	}
+	transition_size = size;
 }
 
-const GroundBrush::BorderBlock* GroundBrush::getBrushTo(GroundBrush* first, GroundBrush* second) {
+void GroundBrush::clearTransitionTable() {
+	for (const auto& brushEntry : g_brushes.getMap()) {
+		if (brushEntry.second->isGround()) {
+			brushEntry.second->asGround()->table_index = 0;
+		}
+	}
+	transition_blocks.clear();
+	transition_table.clear();
+	transition_size = 0;
+}
+
+const GroundBrush::BorderBlock* GroundBrush::findBrushTo(GroundBrush* first, GroundBrush* second) {
 	// printf("Border from %s to %s : ", first->getName().c_str(), second->getName().c_str());
 	if (first) {
 		if (second) {
@@ -710,7 +779,8 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		neighbours[7] = { false, extractGroundBrushFromTile(map, x + 1, y + 1, z) };
 	}
 
-	static std::vector<const BorderBlock*> specificList;
+	// Borders are made on several threads at once by Editor::borderizeMap
+	thread_local std::vector<const BorderBlock*> specificList;
 	specificList.clear();
 
 	std::vector<BorderCluster> borderList;
@@ -46,6 +46,11 @@ public:
 	static void doBorders(BaseMap* map, Tile* tile);
 	static const BorderBlock* getBrushTo(GroundBrush* first, GroundBrush* second);
 
+	// Looks up the border between every pair of ground brushes, so getBrushTo
+	// does not search the border lists. Done once all brushes are loaded.
+	static void buildTransitionTable();
+	static void clearTransitionTable();
+
 	virtual int32_t getZ() const {
 		return z_order;
 	}
@@ -72,6 +77,12 @@ public:
 		return optional_border != nullptr;
 	}
 
+	// Ground item drawn for a chance from 1 to getTotalChance()
+	uint16_t getGroundID(int chance) const;
+	int getTotalChance() const {
+		return total_chance;
+	}
+
 protected: // Members
 	int32_t z_order;
 	bool has_zilch_outer_border;
@@ -118,9 +129,21 @@ protected: // Members
 		}
 	};
 
+	static const BorderBlock* findBrushTo(GroundBrush* first, GroundBrush* second);
+
 	std::vector<BorderBlock*> borders;
 	std::vector<ItemChanceBlock> border_items;
 	int total_chance;
+	// Row and column of the brush in the transition table, 0 if it is not in it
+	uint32_t table_index;
+
+	// More brushes than this are searched instead, the table grows with the square
+	static const uint32_t MaxTransitionBrushes = 4096;
+	// transition_blocks[transition_table[first * transition_size + second]],
+	// index 0 stands for no brush
+	static std::vector<const BorderBlock*> transition_blocks;
+	static std::vector<uint16_t> transition_table;
+	static uint32_t transition_size;
 
 public: // Static global members
 	static uint32_t border_types[256];
@@ -164,6 +164,7 @@
 
 #include "common_windows.h"
 #include "result_window.h"
+#include "profiler_window.h"
 #include "minimap_window.h"
 #include "palette_window.h"
 #include "map_display.h"
@@ -191,6 +192,7 @@ GUI::GUI() :
 	minimap_enabled(false),
 	gem(nullptr),
 	search_result_window(nullptr),
+	profiler_window(nullptr),
 	secondary_map(nullptr),
 	doodad_buffer_map(nullptr),
 
@@ -415,6 +417,27 @@ bool GUI::LoadVersion(ClientVersionID version, wxString& error, wxArrayString& w
 	return true;
 }
 
+bool GUI::LoadVersionAssets(ClientVersionID version, wxString& error, wxArrayString& warnings) {
+	if (ClientVersion::get(version) == nullptr) {
+		error = "Unsupported client version! (8)";
+		return false;
+	}
+
+	loaded_version = version;
+	if (!getLoadedVersion()->hasValidPaths() && !getLoadedVersion()->loadValidPaths()) {
+		error = "Couldn't load relevant asset files";
+		loaded_version = CLIENT_VERSION_NONE;
+		return false;
+	}
+
+	if (!LoadAssetFiles(error, warnings)) {
+		gfx.clear();
+		loaded_version = CLIENT_VERSION_NONE;
+		return false;
+	}
+	return true;
+}
+
 void GUI::EnableHotkeys() {
 	hotkeys_enabled = true;
 }
@@ -443,67 +466,66 @@ void GUI::CycleTab(bool forward) {
 	tabbook->CycleTab(forward);
 }
 
-bool GUI::LoadDataFiles(wxString& error, wxArrayString& warnings) {
-	minimap_enabled = false;
+bool GUI::LoadAssetFiles(wxString& error, wxArrayString& warnings) {
 	FileName data_path = getLoadedVersion()->getDataPath();
 	FileName client_path = getLoadedVersion()->getClientPath();
-	FileName extension_path = GetExtensionsDirectory();
+	const wxString data_directory = data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR);
 
-	FileName exec_directory;
-	try {
-		exec_directory = dynamic_cast<wxStandardPaths&>(wxStandardPaths::Get()).GetExecutablePath();
-	} catch (std::bad_cast&) {
-		error = "Couldn't establish working directory...";
-		return false;
-	}
-
-	g_gui.gfx.client_version = getLoadedVersion();
-
-	if (!g_gui.gfx.loadOTFI(client_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR), error, warnings)) {
+	gfx.client_version = getLoadedVersion();
+	if (!gfx.loadOTFI(client_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR), error, warnings)) {
 		error = "Couldn't load otfi file: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
 		return false;
 	}
 
-	g_gui.CreateLoadBar("Loading asset files");
-	g_gui.SetLoadDone(0, "Loading metadata file...");
-
-	wxFileName metadata_path = g_gui.gfx.getMetadataFileName();
-	if (!g_gui.gfx.loadSpriteMetadata(metadata_path, error, warnings)) {
+	SetLoadDone(0, "Loading metadata file...");
+	if (!gfx.loadSpriteMetadata(gfx.getMetadataFileName(), error, warnings)) {
 		error = "Couldn't load metadata: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
 		return false;
 	}
 
-	g_gui.SetLoadDone(10, "Loading sprites file...");
-
-	wxFileName sprites_path = g_gui.gfx.getSpritesFileName();
-	if (!g_gui.gfx.loadSpriteData(sprites_path.GetFullPath(), error, warnings)) {
+	SetLoadDone(10, "Loading sprites file...");
+	if (!gfx.loadSpriteData(gfx.getSpritesFileName().GetFullPath(), error, warnings)) {
 		error = "Couldn't load sprites: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
 		return false;
 	}
 
-	g_gui.SetLoadDone(20, "Loading items.otb file...");
-	if (!g_items.loadFromOtb(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "items.otb"), error, warnings)) {
+	SetLoadDone(20, "Loading items.otb file...");
+	if (!g_items.loadFromOtb(data_directory + "items.otb", error, warnings)) {
 		error = "Couldn't load items.otb: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
 		return false;
 	}
 
-	g_gui.SetLoadDone(30, "Loading items.xml ...");
-	if (!g_items.loadFromGameXml(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "items.xml"), error, warnings)) {
+	SetLoadDone(30, "Loading items.xml ...");
+	if (!g_items.loadFromGameXml(data_directory + "items.xml", error, warnings)) {
 		warnings.push_back("Couldn't load items.xml: " + error);
 	}
 
-	g_gui.SetLoadDone(45, "Loading creatures.xml ...");
-	if (!g_creatures.loadFromXML(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "creatures.xml"), true, error, warnings)) {
+	SetLoadDone(45, "Loading creatures.xml ...");
+	if (!g_creatures.loadFromXML(data_directory + "creatures.xml", true, error, warnings)) {
 		warnings.push_back("Couldn't load creatures.xml: " + error);
 	}
+	return true;
+}
+
+bool GUI::LoadDataFiles(wxString& error, wxArrayString& warnings) {
+	minimap_enabled = false;
+	FileName data_path = getLoadedVersion()->getDataPath();
+	FileName extension_path = GetExtensionsDirectory();
+
+	FileName exec_directory;
+	try {
+		exec_directory = dynamic_cast<wxStandardPaths&>(wxStandardPaths::Get()).GetExecutablePath();
+	} catch (std::bad_cast&) {
+		error = "Couldn't establish working directory...";
+		return false;
+	}
+
+	g_gui.CreateLoadBar("Loading asset files");
+	if (!LoadAssetFiles(error, warnings)) {
+		g_gui.DestroyLoadBar();
+		UnloadVersion();
+		return false;
+	}
 
 	g_gui.SetLoadDone(45, "Loading user creatures.xml ...");
 	{
@@ -1005,6 +1027,20 @@ SearchResultWindow* GUI::ShowSearchWindow() {
 	return search_result_window;
 }
 
+void GUI::ShowProfilerWindow() {
+	if (profiler_window == nullptr) {
+		profiler_window = newd ProfilerWindow(root);
+		aui_manager->AddPane(profiler_window, wxAuiPaneInfo().Caption("Frame Profiler").Float().FloatingSize(wxSize(260, 420)));
+	} else {
+		aui_manager->GetPane(profiler_window).Show();
+	}
+	aui_manager->Update();
+}
+
+bool GUI::IsProfilerWindowVisible() const {
+	return profiler_window && aui_manager->GetPane(profiler_window).IsShown();
+}
+
 //=============================================================================
 // Palette Window Interface implementation
 
@@ -1251,17 +1287,17 @@ bool GUI::SetLoadDone(int32_t done, const wxString& newMessage) {
 	int32_t newProgress = progressFrom + static_cast<int32_t>((done / 100.f) * (progressTo - progressFrom));
 	newProgress = std::max<int32_t>(0, std::min<int32_t>(100, newProgress));
 
-	bool skip = false;
+	bool keep_going = true;
 	if (progressBar) {
-		progressBar->Update(
+		keep_going = progressBar->Update(
 			newProgress,
-			wxString::Format("%s (%d%%)", progressText, newProgress),
-			&skip
+			wxString::Format("%s (%d%%)", progressText, newProgress)
 		);
 		currentProgress = newProgress;
 	}
 
-	for (int32_t index = 0; index < tabbook->GetTabCount(); ++index) {
+	// There are no tabs when running from the command line
+	for (int32_t index = 0; tabbook && index < tabbook->GetTabCount(); ++index) {
 		auto* mapTab = dynamic_cast<MapTab*>(tabbook->GetTab(index));
 		if (mapTab && mapTab->GetEditor()) {
 			LiveServer* server = mapTab->GetEditor()->GetLiveServer();
@@ -1271,7 +1307,7 @@ bool GUI::SetLoadDone(int32_t done, const wxString& newMessage) {
 		}
 	}
 
-	return skip;
+	return keep_going;
 }
 
 void GUI::DestroyLoadBar() {
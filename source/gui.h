@@ -50,6 +50,7 @@ class MapWindow;
 class MapCanvas;
 
 class SearchResultWindow;
+class ProfilerWindow;
 class MinimapWindow;
 class PaletteWindow;
 class OldPropertiesWindow;
@@ -213,6 +214,10 @@ public:
 	SearchResultWindow* ShowSearchWindow();
 	void HideSearchWindow();
 
+	// Frame profiler
+	void ShowProfilerWindow();
+	bool IsProfilerWindowVisible() const;
+
 	// Minimap
 	void CreateMinimap();
 	void HideMinimap();
@@ -291,6 +296,8 @@ public:
 	// Load/unload a client version (takes care of dialogs aswell)
 	void UnloadVersion();
 	bool LoadVersion(ClientVersionID ver, wxString& error, wxArrayString& warnings, bool force = false);
+	// Loads only the sprites, items and creatures, without palettes or load bars (for the command line)
+	bool LoadVersionAssets(ClientVersionID ver, wxString& error, wxArrayString& warnings);
 	// The current version loaded (returns CLIENT_VERSION_NONE if no version is loaded)
 	const ClientVersion& GetCurrentVersion() const;
 	ClientVersionID GetCurrentVersionID() const;
@@ -354,6 +361,8 @@ public:
 	bool LoadMap(const FileName& fileName);
 
 protected:
+	// Sprites, items and creatures, shared by LoadDataFiles and LoadVersionAssets
+	bool LoadAssetFiles(wxString& error, wxArrayString& warnings);
 	bool LoadDataFiles(wxString& error, wxArrayString& warnings);
 	ClientVersion* getLoadedVersion() const {
 		return loaded_version == CLIENT_VERSION_NONE ? nullptr : ClientVersion::get(loaded_version);
@@ -402,6 +411,7 @@ public:
 	MinimapWindow* minimap;
 	DCButton* gem; // The small gem in the lower-right corner
 	SearchResultWindow* search_result_window;
+	ProfilerWindow* profiler_window;
 	GraphicManager gfx;
 
 	BaseMap* secondary_map; // A buffer map
@@ -99,6 +99,7 @@ enum EditorActionID {
 
 	MAP_WINDOW_FILE_BUTTON,
 	TILESET_FILE_BUTTON,
+	REGION_IMAGE_FILE_BUTTON,
 
 	PALETTE_ITEM_CHOICEBOOK,
 	PALETTE_CHOICEBOOK,
@@ -30,6 +30,8 @@
 #include "table_brush.h"
 #include "wall_brush.h"
 
+#include <typeinfo>
+
 Item* Item::Create(uint16_t _type, uint16_t _subtype /*= 0xFFFF*/) {
 	if (_type == 0) {
 		return nullptr;
@@ -94,6 +96,16 @@ Item* Item::deepCopy() const {
 	return copy;
 }
 
+bool Item::isSameAs(const Item* other) const {
+	if (!other || typeid(*this) != typeid(Item) || typeid(*other) != typeid(Item)) {
+		return false;
+	}
+	if (id != other->id || subtype != other->subtype) {
+		return false;
+	}
+	return (!attributes || attributes->empty()) && (!other->attributes || other->attributes->empty());
+}
+
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 	if (old_item == nullptr) {
 		return nullptr;
@@ -261,6 +273,14 @@ SpriteLight Item::getLight() const {
 	return SpriteLight { 0, 0 };
 }
 
+bool Item::isFullGround() const {
+	const ItemType& type = g_items.getItemType(id);
+	if (type.sprite) {
+		return type.sprite->isFullGround();
+	}
+	return false;
+}
+
 double Item::getWeight() const {
 	ItemType& it = g_items[id];
 	if (it.stackable) {
@@ -418,6 +438,46 @@ void Item::animate() {
 	frame = sprite->animator->getFrame();
 }
 
+void Item::getSpritePattern(const GameSprite* sprite, const Position& pos, const Tile* tile, int& subtype, int& pattern_x, int& pattern_y, int& pattern_z) const {
+	const ItemType& type = g_items[id];
+
+	subtype = -1;
+	pattern_x = pos.x % sprite->pattern_x;
+	pattern_y = pos.y % sprite->pattern_y;
+	pattern_z = pos.z % sprite->pattern_z;
+
+	if (type.isSplash() || type.isFluidContainer()) {
+		subtype = getSubtype();
+	} else if (type.isHangable) {
+		if (tile && tile->hasProperty(HOOK_SOUTH)) {
+			pattern_x = 1;
+		} else if (tile && tile->hasProperty(HOOK_EAST)) {
+			pattern_x = 2;
+		} else {
+			pattern_x = 0;
+		}
+	} else if (type.stackable) {
+		const uint16_t count = getSubtype();
+		if (count <= 1) {
+			subtype = 0;
+		} else if (count <= 2) {
+			subtype = 1;
+		} else if (count <= 3) {
+			subtype = 2;
+		} else if (count <= 4) {
+			subtype = 3;
+		} else if (count < 10) {
+			subtype = 4;
+		} else if (count < 25) {
+			subtype = 5;
+		} else if (count < 50) {
+			subtype = 6;
+		} else {
+			subtype = 7;
+		}
+	}
+}
+
 // ============================================================================
 // Static conversions
 
@@ -28,6 +28,7 @@
 class Creature;
 class Border;
 class Tile;
+class GameSprite;
 
 struct SpriteLight;
 
@@ -92,6 +93,9 @@ public:
 
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
+	// True if a deep copy of other would be this item, apart from the selection.
+	// Complex items (containers, doors...) are never the same.
+	bool isSameAs(const Item* other) const;
 
 	// Get memory footprint size
 	uint32_t memsize() const;
@@ -224,6 +228,7 @@ public:
 
 	bool hasLight() const;
 	SpriteLight getLight() const;
+	bool isFullGround() const;
 
 	// Item types
 	bool hasProperty(enum ITEMPROPERTY prop) const;
@@ -394,6 +399,8 @@ public:
 	std::string getDescription() const;
 
 	void animate();
+	// Variation of the sprite to draw at pos, tile tells which wall hangables hang on
+	void getSpritePattern(const GameSprite* sprite, const Position& pos, const Tile* tile, int& subtype, int& pattern_x, int& pattern_y, int& pattern_z) const;
 	int getFrame() const {
 		return frame;
 	}
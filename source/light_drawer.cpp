@@ -17,10 +17,19 @@
 
 #include "main.h"
 #include "light_drawer.h"
+#include "frame_profiler.h"
 
 LightDrawer::LightDrawer() {
 	texture = 0;
 	global_color = wxColor(50, 50, 50, 255);
+
+	for (int intensity = 0; intensity < FalloffIntensities; ++intensity) {
+		for (int dy = 0; dy <= MaxLightIntensity; ++dy) {
+			for (int dx = 0; dx <= MaxLightIntensity; ++dx) {
+				falloff[intensity][dy][dx] = calculateIntensity(dx, dy, intensity);
+			}
+		}
+	}
 }
 
 LightDrawer::~LightDrawer() {
@@ -39,30 +48,40 @@ void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x,
 
 	buffer.resize(static_cast<size_t>(w * h * PixelFormatRGBA));
 
-	for (int x = 0; x < w; ++x) {
-		for (int y = 0; y < h; ++y) {
-			int mx = (map_x + x);
-			int my = (map_y + y);
-			int index = (y * w + x);
-			int color_index = index * PixelFormatRGBA;
-
-			buffer[color_index] = global_color.Red();
-			buffer[color_index + 1] = global_color.Green();
-			buffer[color_index + 2] = global_color.Blue();
-			buffer[color_index + 3] = 140; // global_color.Alpha();
-
-			for (auto& light : lights) {
-				float intensity = calculateIntensity(mx, my, light);
-				if (intensity == 0.f) {
-					continue;
-				}
-				wxColor light_color = colorFromEightBit(light.color);
-				uint8_t red = static_cast<uint8_t>(light_color.Red() * intensity);
-				uint8_t green = static_cast<uint8_t>(light_color.Green() * intensity);
-				uint8_t blue = static_cast<uint8_t>(light_color.Blue() * intensity);
-				buffer[color_index] = std::max(buffer[color_index], red);
-				buffer[color_index + 1] = std::max(buffer[color_index + 1], green);
-				buffer[color_index + 2] = std::max(buffer[color_index + 2], blue);
+	const uint8_t global_red = global_color.Red();
+	const uint8_t global_green = global_color.Green();
+	const uint8_t global_blue = global_color.Blue();
+	for (size_t color_index = 0; color_index < buffer.size(); color_index += PixelFormatRGBA) {
+		buffer[color_index] = global_red;
+		buffer[color_index + 1] = global_green;
+		buffer[color_index + 2] = global_blue;
+		buffer[color_index + 3] = 140; // global_color.Alpha();
+	}
+
+	// Every light only brightens the tiles within its range, instead of every tile checking every light
+	for (const Light& light : lights) {
+		const int radius = std::min<int>(light.intensity, MaxLightIntensity);
+		const int start_x = std::max<int>(light.map_x - radius, map_x);
+		const int start_y = std::max<int>(light.map_y - radius, map_y);
+		const int last_x = std::min<int>(light.map_x + radius, end_x - 1);
+		const int last_y = std::min<int>(light.map_y + radius, end_y - 1);
+		if (start_x > last_x || start_y > last_y) {
+			continue;
+		}
+
+		const wxColor light_color = colorFromEightBit(light.color);
+		const float light_red = light_color.Red();
+		const float light_green = light_color.Green();
+		const float light_blue = light_color.Blue();
+
+		for (int my = start_y; my <= last_y; ++my) {
+			const float* row = falloff[std::min<int>(light.intensity, FalloffIntensities - 1)][std::abs(my - light.map_y)];
+			uint8_t* pixel = &buffer[((my - map_y) * w + (start_x - map_x)) * PixelFormatRGBA];
+			for (int mx = start_x; mx <= last_x; ++mx, pixel += PixelFormatRGBA) {
+				const float intensity = row[std::abs(mx - light.map_x)];
+				pixel[0] = std::max(pixel[0], static_cast<uint8_t>(light_red * intensity));
+				pixel[1] = std::max(pixel[1], static_cast<uint8_t>(light_green * intensity));
+				pixel[2] = std::max(pixel[2], static_cast<uint8_t>(light_blue * intensity));
 			}
 		}
 	}
@@ -136,6 +155,7 @@ void LightDrawer::addLight(int map_x, int map_y, int map_z, const SpriteLight& l
 	}
 
 	lights.push_back(Light { static_cast<uint16_t>(map_x), static_cast<uint16_t>(map_y), light.color, intensity });
+	g_profiler.count(FrameProfiler::COUNTER_LIGHTS);
 }
 
 void LightDrawer::clear() noexcept {
@@ -43,20 +43,25 @@ private:
 	void createGLTexture();
 	void unloadGLTexture();
 
-	inline float calculateIntensity(int map_x, int map_y, const Light& light) {
-		int dx = map_x - light.map_x;
-		int dy = map_y - light.map_y;
+	inline float calculateIntensity(int dx, int dy, int light_intensity) {
 		float distance = std::sqrt(dx * dx + dy * dy);
 		if (distance > MaxLightIntensity) {
 			return 0.f;
 		}
-		float intensity = (-distance + light.intensity) * 0.2f;
+		float intensity = (-distance + light_intensity) * 0.2f;
 		if (intensity < 0.01f) {
 			return 0.f;
 		}
 		return std::min(intensity, 1.f);
 	}
 
+	// Stronger lights are at full intensity everywhere within MaxLightIntensity
+	static const int FalloffIntensities = MaxLightIntensity + 6;
+
+	// Intensity by light intensity and distance along each axis, a light never reaches
+	// further than its intensity so only the tiles in that square are visited
+	float falloff[FalloffIntensities][MaxLightIntensity + 1][MaxLightIntensity + 1];
+
 	GLuint texture;
 	std::vector<Light> lights;
 	std::vector<uint8_t> buffer;
@@ -0,0 +1,240 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "lod_drawer.h"
+
+#include "gui.h"
+#include "basemap.h"
+#include "tile.h"
+#include "items.h"
+
+LodDrawer::LodDrawer() :
+	frame(0) {
+	////
+}
+
+LodDrawer::~LodDrawer() {
+	clear();
+}
+
+void LodDrawer::draw(BaseMap& map, int map_z, int offset, int scroll_x, int scroll_y, int width, int height) {
+	const int block_pixels = BlockSize * TileSize;
+	const int block_start_x = std::max(scroll_x + offset, 0) / block_pixels;
+	const int block_start_y = std::max(scroll_y + offset, 0) / block_pixels;
+	const int block_end_x = std::min(scroll_x + offset + width, MAP_MAX_WIDTH * TileSize) / block_pixels;
+	const int block_end_y = std::min(scroll_y + offset + height, MAP_MAX_HEIGHT * TileSize) / block_pixels;
+	const uint64_t map_revision = map.getRevision();
+
+	glColor4ub(255, 255, 255, 255);
+
+	for (int block_x = block_start_x; block_x <= block_end_x; ++block_x) {
+		for (int block_y = block_start_y; block_y <= block_end_y; ++block_y) {
+			Block& block = blocks[makeKey(block_x, block_y, map_z)];
+			block.lastframe = frame;
+
+			// Only walk the leaves again if something on the map has changed since the last check
+			if (block.map_revision != map_revision) {
+				block.map_revision = map_revision;
+
+				QTreeNode* node = map.getNode(block_x * BlockSize, block_y * BlockSize, BlockDepth);
+				uint64_t revision = node ? node->getRevision() : 0;
+				if (revision != block.revision) {
+					block.revision = revision;
+					buildBlock(map, block, block_x, block_y, map_z);
+				}
+			}
+
+			if (block.empty) {
+				continue;
+			}
+
+			int draw_x = block_x * block_pixels - scroll_x - offset;
+			int draw_y = block_y * block_pixels - scroll_y - offset;
+
+			glBindTexture(GL_TEXTURE_2D, block.texture);
+			glBegin(GL_QUADS);
+			glTexCoord2f(0.f, 0.f);
+			glVertex2f(draw_x, draw_y);
+			glTexCoord2f(1.f, 0.f);
+			glVertex2f(draw_x + block_pixels, draw_y);
+			glTexCoord2f(1.f, 1.f);
+			glVertex2f(draw_x + block_pixels, draw_y + block_pixels);
+			glTexCoord2f(0.f, 1.f);
+			glVertex2f(draw_x, draw_y + block_pixels);
+			glEnd();
+		}
+	}
+}
+
+void LodDrawer::finishFrame() {
+	++frame;
+	if (blocks.size() <= static_cast<size_t>(MaxBlocks)) {
+		return;
+	}
+
+	// Drop everything that wasn't drawn this frame
+	for (auto it = blocks.begin(); it != blocks.end();) {
+		Block& block = it->second;
+		if (block.lastframe != frame - 1) {
+			if (block.texture != 0) {
+				glDeleteTextures(1, &block.texture);
+			}
+			it = blocks.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void LodDrawer::clear() {
+	for (auto& it : blocks) {
+		if (it.second.texture != 0) {
+			glDeleteTextures(1, &it.second.texture);
+		}
+	}
+	blocks.clear();
+}
+
+void LodDrawer::buildBlock(BaseMap& map, Block& block, int block_x, int block_y, int map_z) {
+	const int base_x = block_x * BlockSize;
+	const int base_y = block_y * BlockSize;
+
+	buffer.assign(BlockSize * BlockSize * PixelFormatRGBA, 0);
+	block.empty = true;
+
+	for (int leaf_x = 0; leaf_x < BlockSize; leaf_x += 4) {
+		for (int leaf_y = 0; leaf_y < BlockSize; leaf_y += 4) {
+			QTreeNode* leaf = map.getLeaf(base_x + leaf_x, base_y + leaf_y);
+			if (!leaf) {
+				continue;
+			}
+
+			Floor* floor = leaf->getFloor(map_z);
+			if (!floor) {
+				continue;
+			}
+
+			for (int i = 0; i < MAP_LAYERS; ++i) {
+				const Tile* tile = floor->locs[i].get();
+				if (!tile) {
+					continue;
+				}
+
+				uint32_t color = getTileColor(tile);
+				if ((color >> 24) == 0) {
+					continue;
+				}
+
+				int x = leaf_x + (i >> 2);
+				int y = leaf_y + (i & 3);
+				uint8_t* texel = &buffer[(y * BlockSize + x) * PixelFormatRGBA];
+				texel[0] = color & 0xFF;
+				texel[1] = (color >> 8) & 0xFF;
+				texel[2] = (color >> 16) & 0xFF;
+				texel[3] = color >> 24;
+				block.empty = false;
+			}
+		}
+	}
+
+	if (block.empty) {
+		if (block.texture != 0) {
+			glDeleteTextures(1, &block.texture);
+			block.texture = 0;
+		}
+		return;
+	}
+
+	if (block.texture == 0) {
+		block.texture = g_gui.gfx.getFreeTextureID();
+	}
+
+	glBindTexture(GL_TEXTURE_2D, block.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BlockSize, BlockSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+
+	// Build the rest of the pyramid, colors are weighted by alpha so empty tiles don't darken the edges
+	int level = 0;
+	for (int size = BlockSize / 2; size >= 1; size /= 2) {
+		mipmap.resize(size * size * PixelFormatRGBA);
+		const int source_size = size * 2;
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+				for (int i = 0; i < 4; ++i) {
+					const uint8_t* texel = &buffer[((y * 2 + (i >> 1)) * source_size + x * 2 + (i & 1)) * PixelFormatRGBA];
+					red += texel[0] * texel[3];
+					green += texel[1] * texel[3];
+					blue += texel[2] * texel[3];
+					alpha += texel[3];
+				}
+
+				uint8_t* texel = &mipmap[(y * size + x) * PixelFormatRGBA];
+				texel[0] = alpha ? red / alpha : 0;
+				texel[1] = alpha ? green / alpha : 0;
+				texel[2] = alpha ? blue / alpha : 0;
+				texel[3] = alpha / 4;
+			}
+		}
+		glTexImage2D(GL_TEXTURE_2D, ++level, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, mipmap.data());
+		buffer.swap(mipmap);
+	}
+}
+
+uint32_t LodDrawer::getTileColor(const Tile* tile) const {
+	uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+
+	auto blend = [&](const Item* item) {
+		GameSprite* sprite = g_items[item->getID()].sprite;
+		if (!sprite) {
+			return;
+		}
+
+		uint32_t color = sprite->getAverageColor();
+		uint32_t source_alpha = color >> 24;
+		if (source_alpha == 0) {
+			return;
+		}
+
+		// Source over destination
+		uint32_t below = alpha * (255 - source_alpha) / 255;
+		uint32_t result = source_alpha + below;
+		red = ((color & 0xFF) * source_alpha + red * below) / result;
+		green = (((color >> 8) & 0xFF) * source_alpha + green * below) / result;
+		blue = (((color >> 16) & 0xFF) * source_alpha + blue * below) / result;
+		alpha = result;
+	};
+
+	if (tile->ground) {
+		blend(tile->ground);
+	}
+	for (const Item* item : tile->items) {
+		blend(item);
+	}
+
+	if (tile->isSelected()) {
+		red /= 2;
+		green /= 2;
+		blue /= 2;
+	}
+
+	return red | (green << 8) | (blue << 16) | (alpha << 24);
+}
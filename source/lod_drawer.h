@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_LOD_DRAWER_H
+#define RME_LOD_DRAWER_H
+
+#include "graphics.h"
+
+#include <unordered_map>
+
+class BaseMap;
+class Tile;
+
+// Draws the map far zoomed out from cached textures with one texel per tile,
+// built from the average sprite colors of every tile and mipmapped on the CPU.
+// Each texture covers a 64x64 tiles block and is rebuilt when the leaf revisions
+// inside it change.
+class LodDrawer {
+	struct Block {
+		GLuint texture = 0;
+		uint64_t revision = 0; // Leaf revisions the texture was built from
+		uint64_t map_revision = 0; // Map revision when the leaves were last checked
+		int lastframe = 0;
+		bool empty = true;
+	};
+
+public:
+	LodDrawer();
+	virtual ~LodDrawer();
+
+	// Draws the blocks of floor map_z that are visible in the width x height pixels view
+	void draw(BaseMap& map, int map_z, int offset, int scroll_x, int scroll_y, int width, int height);
+	// Must be called once per frame, after all floors have been drawn
+	void finishFrame();
+	void clear();
+
+	static const int BlockSize = 64;
+	static const int BlockDepth = 5; // Depth of the 64x64 tiles nodes in the map tree
+	static const int MaxBlocks = 1024;
+
+private:
+	void buildBlock(BaseMap& map, Block& block, int block_x, int block_y, int map_z);
+	uint32_t getTileColor(const Tile* tile) const;
+
+	static uint64_t makeKey(int block_x, int block_y, int map_z) {
+		return (uint64_t(block_x) << 32) | (uint64_t(block_y) << 8) | uint64_t(map_z);
+	}
+
+	std::unordered_map<uint64_t, Block> blocks;
+	std::vector<uint8_t> buffer;
+	std::vector<uint8_t> mipmap;
+	int frame;
+};
+
+#endif
@@ -63,6 +63,8 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(IMPORT_MONSTERS, wxITEM_NORMAL, OnImportMonsterData);
 	MAKE_ACTION(IMPORT_MINIMAP, wxITEM_NORMAL, OnImportMinimap);
 	MAKE_ACTION(EXPORT_MINIMAP, wxITEM_NORMAL, OnExportMinimap);
+	MAKE_ACTION(EXPORT_REGION_IMAGE, wxITEM_NORMAL, OnExportRegionImage);
+	MAKE_ACTION(EXPORT_WEB_MAP, wxITEM_NORMAL, OnExportWebMap);
 	MAKE_ACTION(EXPORT_TILESETS, wxITEM_NORMAL, OnExportTilesets);
 
 	MAKE_ACTION(RELOAD_DATA, wxITEM_NORMAL, OnReloadDataFiles);
@@ -157,6 +159,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(SHOW_PATHING, wxITEM_CHECK, OnChangeViewSettings);
 	MAKE_ACTION(SHOW_TOOLTIPS, wxITEM_CHECK, OnChangeViewSettings);
 	MAKE_ACTION(SHOW_PREVIEW, wxITEM_CHECK, OnChangeViewSettings);
+	MAKE_ACTION(SHOW_FRAME_PROFILER, wxITEM_CHECK, OnChangeViewSettings);
 	MAKE_ACTION(SHOW_WALL_HOOKS, wxITEM_CHECK, OnChangeViewSettings);
 	MAKE_ACTION(SHOW_TOWNS, wxITEM_CHECK, OnChangeViewSettings);
 	MAKE_ACTION(ALWAYS_SHOW_ZONES, wxITEM_CHECK, OnChangeViewSettings);
@@ -165,6 +168,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(EXPERIMENTAL_FOG, wxITEM_CHECK, OnChangeViewSettings); // experimental
 
 	MAKE_ACTION(WIN_MINIMAP, wxITEM_NORMAL, OnMinimapWindow);
+	MAKE_ACTION(WIN_PROFILER, wxITEM_NORMAL, OnProfilerWindow);
 	MAKE_ACTION(NEW_PALETTE, wxITEM_NORMAL, OnNewPalette);
 	MAKE_ACTION(TAKE_SCREENSHOT, wxITEM_NORMAL, OnTakeScreenshot);
 
@@ -336,8 +340,10 @@ void MainMenuBar::Update() {
 
 	EnableItem(IMPORT_MAP, is_local);
 	EnableItem(IMPORT_MONSTERS, is_local);
-	EnableItem(IMPORT_MINIMAP, false);
+	EnableItem(IMPORT_MINIMAP, is_local);
 	EnableItem(EXPORT_MINIMAP, is_local);
+	EnableItem(EXPORT_REGION_IMAGE, is_local);
+	EnableItem(EXPORT_WEB_MAP, is_local);
 	EnableItem(EXPORT_TILESETS, loaded);
 
 	EnableItem(FIND_ITEM, is_host);
@@ -394,6 +400,7 @@ void MainMenuBar::Update() {
 	}
 
 	EnableItem(WIN_MINIMAP, loaded);
+	EnableItem(WIN_PROFILER, loaded);
 	EnableItem(NEW_PALETTE, loaded);
 	EnableItem(SELECT_TERRAIN, loaded);
 	EnableItem(SELECT_DOODAD, loaded);
@@ -473,6 +480,7 @@ void MainMenuBar::LoadValues() {
 	CheckItem(SHOW_TOWNS, g_settings.getBoolean(Config::SHOW_TOWNS));
 	CheckItem(ALWAYS_SHOW_ZONES, g_settings.getBoolean(Config::ALWAYS_SHOW_ZONES));
 	CheckItem(EXT_HOUSE_SHADER, g_settings.getBoolean(Config::EXT_HOUSE_SHADER));
+	CheckItem(SHOW_FRAME_PROFILER, g_settings.getBoolean(Config::SHOW_FRAME_PROFILER));
 
 	CheckItem(EXPERIMENTAL_FOG, g_settings.getBoolean(Config::EXPERIMENTAL_FOG));
 }
@@ -791,9 +799,11 @@ void MainMenuBar::OnImportMonsterData(wxCommandEvent& WXUNUSED(event)) {
 }
 
 void MainMenuBar::OnImportMinimap(wxCommandEvent& WXUNUSED(event)) {
-	ASSERT(g_gui.IsEditorOpen());
-	// wxDialog* importmap = newd ImportMapWindow();
-	// importmap->ShowModal();
+	if (g_gui.GetCurrentEditor()) {
+		ImportMiniMapWindow dlg(frame, *g_gui.GetCurrentEditor());
+		dlg.ShowModal();
+		dlg.Destroy();
+	}
 }
 
 void MainMenuBar::OnExportMinimap(wxCommandEvent& WXUNUSED(event)) {
@@ -804,6 +814,22 @@ void MainMenuBar::OnExportMinimap(wxCommandEvent& WXUNUSED(event)) {
 	}
 }
 
+void MainMenuBar::OnExportRegionImage(wxCommandEvent& WXUNUSED(event)) {
+	if (g_gui.GetCurrentEditor()) {
+		ExportRegionImageWindow dlg(frame, *g_gui.GetCurrentEditor());
+		dlg.ShowModal();
+		dlg.Destroy();
+	}
+}
+
+void MainMenuBar::OnExportWebMap(wxCommandEvent& WXUNUSED(event)) {
+	if (g_gui.GetCurrentEditor()) {
+		ExportWebMapWindow dlg(frame, *g_gui.GetCurrentEditor());
+		dlg.ShowModal();
+		dlg.Destroy();
+	}
+}
+
 void MainMenuBar::OnExportTilesets(wxCommandEvent& WXUNUSED(event)) {
 	if (g_gui.GetCurrentEditor()) {
 		ExportTilesetsWindow dlg(frame, *g_gui.GetCurrentEditor());
@@ -1290,6 +1316,7 @@ void MainMenuBar::OnRemoveItemOnSelection(wxCommandEvent& WXUNUSED(event)) {
         msg << count << " items removed.";
         g_gui.PopupDialog("Remove Items", msg, wxOK);
         g_gui.GetCurrentMap().doChange();
+        g_gui.GetCurrentEditor()->minimap_cache.clear();
         g_gui.RefreshView();
     }
     dialog.Destroy();
@@ -1344,7 +1371,7 @@ void MainMenuBar::OnBorderizeMap(wxCommandEvent& WXUNUSED(event)) {
     }
 
     int ret = g_gui.PopupDialog("Borderize Map", 
-        "Do you want to borderize the entire map? This will process the map in chunks.", wxYES | wxNO);
+        "Do you want to borderize the entire map?", wxYES | wxNO);
     if (ret == wxID_YES) {
         g_gui.GetCurrentEditor()->borderizeMap(true);
     }
@@ -1366,7 +1393,7 @@ void MainMenuBar::OnRandomizeMap(wxCommandEvent& WXUNUSED(event)) {
 		return;
 	}
 
-	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map (this action cannot be undone)?", wxYES | wxNO);
+	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map?", wxYES | wxNO);
 	if (ret == wxID_YES) {
 		g_gui.GetCurrentEditor()->randomizeMap(true);
 	}
@@ -1453,6 +1480,7 @@ void MainMenuBar::OnMapRemoveItems(wxCommandEvent& WXUNUSED(event)) {
 
 		g_gui.PopupDialog("Search completed", msg, wxOK);
 		g_gui.GetCurrentMap().doChange();
+		g_gui.GetCurrentEditor()->minimap_cache.clear();
 		g_gui.RefreshView();
 	}
 	dialog.Destroy();
@@ -1494,6 +1522,7 @@ void MainMenuBar::OnMapRemoveCorpses(wxCommandEvent& WXUNUSED(event)) {
 		msg << count << " items deleted.";
 		g_gui.PopupDialog("Search completed", msg, wxOK);
 		g_gui.GetCurrentMap().doChange();
+		g_gui.GetCurrentEditor()->minimap_cache.clear();
 	}
 }
 
@@ -1650,6 +1679,7 @@ void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent& WXUNUSED(event)) {
         g_gui.PopupDialog("Search completed", msg, wxOK);
 
         g_gui.GetCurrentMap().doChange();
+        g_gui.GetCurrentEditor()->minimap_cache.clear();
     }
     
     dialog->Destroy();
@@ -2165,6 +2195,7 @@ void MainMenuBar::OnMapCleanup(wxCommandEvent& WXUNUSED(event)) {
             g_gui.PopupDialog("Cleanup Complete", msg, wxOK);
             
             currentMap.doChange();
+            g_gui.GetCurrentEditor()->minimap_cache.clear();
         }
         catch (...) {
             g_gui.PopupDialog("Error", "An error occurred during cleanup.", wxOK | wxICON_ERROR);
@@ -2291,6 +2322,7 @@ void MainMenuBar::OnChangeViewSettings(wxCommandEvent& event) {
 	g_settings.setInteger(Config::SHOW_TOWNS, IsItemChecked(MenuBar::SHOW_TOWNS));
 	g_settings.setInteger(Config::ALWAYS_SHOW_ZONES, IsItemChecked(MenuBar::ALWAYS_SHOW_ZONES));
 	g_settings.setInteger(Config::EXT_HOUSE_SHADER, IsItemChecked(MenuBar::EXT_HOUSE_SHADER));
+	g_settings.setInteger(Config::SHOW_FRAME_PROFILER, IsItemChecked(MenuBar::SHOW_FRAME_PROFILER));
 
 	g_settings.setInteger(Config::EXPERIMENTAL_FOG, IsItemChecked(MenuBar::EXPERIMENTAL_FOG));
 
@@ -2318,6 +2350,10 @@ void MainMenuBar::OnMinimapWindow(wxCommandEvent& event) {
 	g_gui.CreateMinimap();
 }
 
+void MainMenuBar::OnProfilerWindow(wxCommandEvent& event) {
+	g_gui.ShowProfilerWindow();
+}
+
 void MainMenuBar::OnNewPalette(wxCommandEvent& event) {
 	g_gui.NewPalette();
 }
@@ -2745,6 +2781,7 @@ void MainMenuBar::OnMapRemoveDuplicates(wxCommandEvent& WXUNUSED(event)) {
         g_gui.CreateLoadBar("Removing all duplicate items...");
         uint32_t removed = editor->map.cleanDuplicateItems(std::vector<std::pair<uint16_t, uint16_t>>(), flags);
         g_gui.DestroyLoadBar();
+        editor->minimap_cache.clear();
 
         std::ostringstream ss;
         ss << "Remove Duplicates completed:\n" << removed << " duplicate items removed.";
@@ -2780,6 +2817,7 @@ void MainMenuBar::OnMapRemoveDuplicates(wxCommandEvent& WXUNUSED(event)) {
         g_gui.CreateLoadBar("Removing selected item duplicates...");
         uint32_t removed = editor->map.cleanDuplicateItems(range, flags);
         g_gui.DestroyLoadBar();
+        editor->minimap_cache.clear();
 
         std::ostringstream ss;
         ss << "Remove Duplicates completed:\n" << removed << " duplicates of item " << itemId << " removed.";
@@ -2837,6 +2875,7 @@ void MainMenuBar::OnMapRemoveDuplicates(wxCommandEvent& WXUNUSED(event)) {
         g_gui.CreateLoadBar("Removing duplicates of selected items...");
         uint32_t removed = editor->map.cleanDuplicateItems(ranges, flags);
         g_gui.DestroyLoadBar();
+        editor->minimap_cache.clear();
 
         std::ostringstream ss;
         ss << "Remove Duplicates completed:\n" << removed << " duplicates of " 
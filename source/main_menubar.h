@@ -34,6 +34,8 @@ namespace MenuBar {
 		IMPORT_MONSTERS,
 		IMPORT_MINIMAP,
 		EXPORT_MINIMAP,
+		EXPORT_REGION_IMAGE,
+		EXPORT_WEB_MAP,
 		EXPORT_TILESETS,
 		RELOAD_DATA,
 		RECENT_FILES,
@@ -120,7 +122,9 @@ namespace MenuBar {
 		SHOW_TOWNS,
 		ALWAYS_SHOW_ZONES,
 		EXT_HOUSE_SHADER,
+		SHOW_FRAME_PROFILER,
 		WIN_MINIMAP,
+		WIN_PROFILER,
 		NEW_PALETTE,
 		TAKE_SCREENSHOT,
 		LIVE_START,
@@ -203,6 +207,8 @@ public:
 	void OnImportMonsterData(wxCommandEvent& event);
 	void OnImportMinimap(wxCommandEvent& event);
 	void OnExportMinimap(wxCommandEvent& event);
+	void OnExportRegionImage(wxCommandEvent& event);
+	void OnExportWebMap(wxCommandEvent& event);
 	void OnExportTilesets(wxCommandEvent& event);
 	void OnReloadDataFiles(wxCommandEvent& event);
 
@@ -271,6 +277,7 @@ public:
 
 	// Window Menu
 	void OnMinimapWindow(wxCommandEvent& event);
+	void OnProfilerWindow(wxCommandEvent& event);
 	void OnNewPalette(wxCommandEvent& event);
 	void OnTakeScreenshot(wxCommandEvent& event);
 	void OnSelectTerrainPalette(wxCommandEvent& event);
@@ -487,151 +487,6 @@ SpawnList Map::getSpawnList(Tile* where) {
 	return list;
 }
 
-bool Map::exportMinimap(FileName filename, int floor, bool displaydialog) {
-	uint8_t* pic = nullptr;
-
-	try {
-		// Find the actual bounds of used tiles
-		int min_x = 0x10000, min_y = 0x10000;
-		int max_x = 0x00000, max_y = 0x00000;
-		bool found_tiles = false;
-
-		for (MapIterator mit = begin(); mit != end(); ++mit) {
-			if ((*mit)->get() == nullptr || (*mit)->empty() || (*mit)->getZ() != floor) {
-				continue;
-			}
-
-			found_tiles = true;
-			Position pos = (*mit)->getPosition();
-
-			min_x = std::min(min_x, pos.x);
-			min_y = std::min(min_y, pos.y);
-			max_x = std::max(max_x, pos.x);
-			max_y = std::max(max_y, pos.y);
-		}
-
-		if (!found_tiles) {
-			return true;
-		}
-
-		// Add padding of 10 tiles
-		min_x = std::max(0, min_x - 10);
-		min_y = std::max(0, min_y - 10);
-		max_x = std::min(65535, max_x + 10);
-		max_y = std::min(65535, max_y + 10);
-
-		// Calculate dimensions
-		int minimap_width = max_x - min_x + 1;
-		int minimap_height = max_y - min_y + 1;
-
-		// Allocate memory for the bitmap
-		pic = newd uint8_t[minimap_width * minimap_height];
-		memset(pic, 0, minimap_width * minimap_height);
-
-		// Fill the bitmap
-		for (MapIterator mit = begin(); mit != end(); ++mit) {
-			Tile* tile = (*mit)->get();
-			if (!tile || tile->empty() || tile->getZ() != floor) {
-				continue;
-			}
-
-			uint32_t pixelpos = (tile->getY() - min_y) * minimap_width + (tile->getX() - min_x);
-			uint8_t& pixel = pic[pixelpos];
-
-			// Get color from items
-			for (ItemVector::const_reverse_iterator item_iter = tile->items.rbegin(); 
-				 item_iter != tile->items.rend(); ++item_iter) {
-				if ((*item_iter)->getMiniMapColor()) {
-					pixel = (*item_iter)->getMiniMapColor();
-					break;
-				}
-			}
-
-			// If no item color, check ground
-			if (pixel == 0 && tile->hasGround()) {
-				pixel = tile->ground->getMiniMapColor();
-			}
-		}
-
-		// Write to file
-		FileWriteHandle fh(nstr(filename.GetFullPath()));
-		if (!fh.isOpen()) {
-			delete[] pic;
-			return false;
-		}
-
-		// Store the magic number
-		fh.addRAW("BM");
-
-		// Store the file size
-		// We need to predict how large it will be
-		uint32_t file_size = 14 // header
-			+ 40 // image data header
-			+ 256 * 4 // color palette
-			+ ((minimap_width + 3) / 4 * 4) * height; // pixels
-		fh.addU32(file_size);
-
-		// Two values reserved, must always be 0.
-		fh.addU16(0);
-		fh.addU16(0);
-
-		// Bitmapdata offset
-		fh.addU32(14 + 40 + 256 * 4);
-
-		// Header size
-		fh.addU32(40);
-
-		// Header width/height
-		fh.addU32(minimap_width);
-		fh.addU32(minimap_height);
-
-		// Color planes
-		fh.addU16(1);
-
-		// bits per pixel, OT map format is 8
-		fh.addU16(8);
-
-		// compression type, 0 is no compression
-		fh.addU32(0);
-
-		// image size, 0 is valid if we use no compression
-		fh.addU32(0);
-
-		// horizontal/vertical resolution in pixels / meter
-		fh.addU32(4000);
-		fh.addU32(4000);
-
-		// Number of colors
-		fh.addU32(256);
-		// Important colors, 0 is all
-		fh.addU32(0);
-
-		// Write the color palette
-		for (int i = 0; i < 256; ++i) {
-			fh.addU32(uint32_t(minimap_color[i]));
-		}
-
-		// Bitmap width must be divisible by four, calculate how much padding we need
-		int padding = ((minimap_width & 3) != 0 ? 4 - (minimap_width & 3) : 0);
-		// Bitmap rows are saved in reverse order
-		for (int y = minimap_height - 1; y >= 0; --y) {
-			fh.addRAW(pic + y * minimap_width, minimap_width);
-			for (int i = 0; i < padding; ++i) {
-				fh.addU8(0);
-			}
-			if (y % 100 == 0 && displaydialog) {
-				g_gui.SetLoadDone(90 + int((minimap_height - y) / double(minimap_height) * 10.0));
-			}
-		}
-
-		delete[] pic;
-		return true;
-	} catch (...) {
-		delete[] pic;
-		throw;
-	}
-}
-
 uint32_t Map::cleanDuplicateItems(const std::vector<std::pair<uint16_t, uint16_t>>& ranges, const PropertyFlags& flags) {
 	uint32_t duplicates_removed = 0;
 	uint32_t tiles_affected = 0;
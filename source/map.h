@@ -86,7 +86,6 @@ public:
 	void convertHouseTiles(uint32_t fromId, uint32_t toId);
 
 	// Save a bmp image of the minimap
-	bool exportMinimap(FileName filename, int floor = GROUND_LAYER, bool showdialog = false);
 	//
 	bool convert(MapVersion to, bool showdialog = false);
 	bool convert(const ConversionMap& cm, bool showdialog = false);
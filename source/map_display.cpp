@@ -39,6 +39,8 @@
 #include "palette_window.h"
 #include "map_display.h"
 #include "map_drawer.h"
+#include "frame_profiler.h"
+#include "png_writer.h"
 #include "application.h"
 #include "live_server.h"
 #include "browse_tile_window.h"
@@ -117,7 +119,6 @@ EVT_MENU(MAP_POPUP_MENU_SELECTION_TO_DOODAD, MapCanvas::OnSelectionToDoodad)
 
 END_EVENT_TABLE()
 
-bool MapCanvas::processed[] = { 0 };
 
 MapCanvas::MapCanvas(MapWindow* parent, Editor& editor, int* attriblist) :
 	wxGLCanvas(parent, wxID_ANY, nullptr, wxDefaultPosition, wxDefaultSize, wxWANTS_CHARS),
@@ -133,6 +134,9 @@ MapCanvas::MapCanvas(MapWindow* parent, Editor& editor, int* attriblist) :
 	dragging_draw(false),
 	replace_dragging(false),
 
+	map_refresh(false),
+	overlay_refresh(false),
+
 	screenshot_buffer(nullptr),
 
 	drag_start_x(-1),
@@ -167,6 +171,12 @@ MapCanvas::~MapCanvas() {
 }
 
 void MapCanvas::Refresh() {
+	map_refresh = true;
+	RefreshOverlay();
+}
+
+void MapCanvas::RefreshOverlay() {
+	overlay_refresh = true;
 	if (refresh_watch.Time() > g_settings.getInteger(Config::HARD_REFRESH_RATE)) {
 		refresh_watch.Start();
 		wxGLCanvas::Update();
@@ -196,6 +206,10 @@ void MapCanvas::SetZoom(double value) {
 	}
 }
 
+bool MapCanvas::IsAnimationPending() const {
+	return drawer->HasAnimationChanged();
+}
+
 void MapCanvas::GetViewBox(int* view_scroll_x, int* view_scroll_y, int* screensize_x, int* screensize_y) const {
 	static_cast<MapWindow*>(GetParent())->GetViewSize(screensize_x, screensize_y);
 	static_cast<MapWindow*>(GetParent())->GetViewStart(view_scroll_x, view_scroll_y);
@@ -204,7 +218,17 @@ void MapCanvas::GetViewBox(int* view_scroll_x, int* view_scroll_y, int* screensi
 void MapCanvas::OnPaint(wxPaintEvent& event) {
 	SetCurrent(*g_gui.GetGLContext(this));
 
+	bool sprites_waiting = false;
 	if (g_gui.IsRenderingEnabled()) {
+		g_profiler.setEnabled(!screenshot_buffer && (g_settings.getBoolean(Config::SHOW_FRAME_PROFILER) || g_gui.IsProfilerWindowVisible()));
+		g_profiler.beginFrame();
+
+		// Screenshots can't contain placeholders
+		g_gui.gfx.setSynchronousLoading(screenshot_buffer != nullptr);
+		g_profiler.beginStage(FrameProfiler::STAGE_SPRITE_UPLOAD);
+		sprites_waiting = g_gui.gfx.uploadDecodedSprites();
+		g_profiler.endStage(FrameProfiler::STAGE_SPRITE_UPLOAD);
+
 		DrawingOptions& options = drawer->getOptions();
 		if (screenshot_buffer) {
 			options.SetIngame();
@@ -235,25 +259,33 @@ void MapCanvas::OnPaint(wxPaintEvent& event) {
 			options.show_preview = g_settings.getBoolean(Config::SHOW_PREVIEW);
 			options.show_hooks = g_settings.getBoolean(Config::SHOW_WALL_HOOKS);
 			options.hide_items_when_zoomed = g_settings.getBoolean(Config::HIDE_ITEMS_WHEN_ZOOMED);
+			options.lod_zoom_threshold = g_settings.getInteger(Config::LOD_ZOOM_THRESHOLD);
 			options.show_towns = g_settings.getBoolean(Config::SHOW_TOWNS);
 			options.always_show_zones = g_settings.getBoolean(Config::ALWAYS_SHOW_ZONES);
 			options.extended_house_shader = g_settings.getBoolean(Config::EXT_HOUSE_SHADER);
 
 			options.experimental_fog = g_settings.getBoolean(Config::EXPERIMENTAL_FOG);
+			options.show_profiler = g_settings.getBoolean(Config::SHOW_FRAME_PROFILER);
 		}
 
 		options.dragging = boundbox_selection;
 
-		if (options.show_preview) {
+		// Only reuse the map layer if nothing but the overlays asked for this paint
+		bool reuse_map_layer = overlay_refresh && !map_refresh && !screenshot_buffer;
+
+		g_profiler.beginStage(FrameProfiler::STAGE_SETUP);
+		drawer->SetupVars();
+		drawer->SetupGL();
+		g_profiler.endStage(FrameProfiler::STAGE_SETUP);
+		drawer->Draw(reuse_map_layer);
+
+		// Keep ticking only while animated sprites are in view
+		if (options.show_preview && drawer->HasAnimations()) {
 			animation_timer->Start();
 		} else {
 			animation_timer->Stop();
 		}
 
-		drawer->SetupVars();
-		drawer->SetupGL();
-		drawer->Draw();
-
 		if (screenshot_buffer) {
 			drawer->TakeScreenshot(screenshot_buffer);
 		}
@@ -261,11 +293,20 @@ void MapCanvas::OnPaint(wxPaintEvent& event) {
 		drawer->Release();
 	}
 
+	map_refresh = false;
+	overlay_refresh = false;
+
 	// Clean unused textures
 	g_gui.gfx.garbageCollection();
 
 	// Swap buffer
 	SwapBuffers();
+	g_profiler.endFrame();
+
+	// Upload the rest of the decoded sprites next frame
+	if (sprites_waiting) {
+		Refresh();
+	}
 
 	// Send newd node requests
 	editor.SendNodeRequests();
@@ -347,6 +388,102 @@ void MapCanvas::TakeScreenshot(wxFileName path, wxString format) {
 	screenshot_buffer = nullptr;
 }
 
+void MapCanvas::ExportRegion(const wxString& filename, const Position& from, const Position& to, double zoom) {
+	// Rows of image kept in memory at once
+	const size_t MaxStripBytes = 64 * 1024 * 1024;
+
+	const int floor = from.z;
+	const int tile_pixels = std::max<int>(1, int(TileSize / zoom));
+	const int image_width = (to.x - from.x + 1) * tile_pixels;
+	const int image_height = (to.y - from.y + 1) * tile_pixels;
+
+	// The map is drawn into the back buffer one window sized piece at a time and never swapped,
+	// pieces are whole tiles so every piece starts on an exact map pixel
+	int view_x, view_y, chunk_width, chunk_height;
+	GetViewBox(&view_x, &view_y, &chunk_width, &chunk_height);
+	chunk_width = std::max(tile_pixels, std::min(chunk_width, image_width) / tile_pixels * tile_pixels);
+	chunk_height = std::min({ chunk_height, image_height, int(MaxStripBytes / (size_t(image_width) * 3)) });
+	chunk_height = std::max(tile_pixels, chunk_height / tile_pixels * tile_pixels);
+
+	// Same offset as ScreenToMap applies for the floor, underground floors aren't shifted
+	const int offset = floor <= GROUND_LAYER ? GROUND_LAYER - floor : 0;
+	const int scroll_x = (from.x - offset) * TileSize;
+	const int scroll_y = (from.y - offset) * TileSize;
+
+	PNGWriter png;
+	if (!png.open(nstr(filename), image_width, image_height)) {
+		g_gui.PopupDialog("File error", wxstr(png.getError()), wxOK);
+		return;
+	}
+
+	std::vector<uint8_t> strip;
+	std::vector<uint8_t> chunk;
+	try {
+		strip.resize(size_t(image_width) * chunk_height * 3);
+		chunk.resize(size_t(chunk_width) * chunk_height * 3);
+	} catch (std::bad_alloc&) {
+		g_gui.PopupDialog("Error", "There is not enough memory available to complete the operation.", wxOK);
+		return;
+	}
+
+	DrawingOptions& options = drawer->getOptions();
+	const DrawingOptions view_options = options;
+
+	wxGenericProgressDialog progress("Exporting image", "Rendering the map...", image_height, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME | wxPD_AUTO_HIDE);
+
+	bool cancelled = false;
+	bool written = true;
+	for (int row = 0; row < image_height && written && !cancelled; row += chunk_height) {
+		const int height = std::min(chunk_height, image_height - row);
+		for (int column = 0; column < image_width; column += chunk_width) {
+			const int width = std::min(chunk_width, image_width - column);
+
+			// The views may have been painted while the progress dialog handled its events
+			SetCurrent(*g_gui.GetGLContext(this));
+			options.SetIngame();
+			g_gui.gfx.setSynchronousLoading(true);
+
+			drawer->SetupRegion(scroll_x + int(column * zoom), scroll_y + int(row * zoom), width, height, floor, zoom);
+			drawer->SetupGL();
+			drawer->DrawRegion();
+			drawer->TakeScreenshot(chunk.data());
+			drawer->Release();
+
+			for (int y = 0; y < height; ++y) {
+				memcpy(&strip[(size_t(y) * image_width + column) * 3], &chunk[size_t(y) * width * 3], size_t(width) * 3);
+			}
+		}
+
+		for (int y = 0; y < height && written; ++y) {
+			written = png.writeRow(&strip[size_t(y) * image_width * 3]);
+		}
+
+		// Drop the sprites of the pieces already done when over the memory budget
+		g_gui.gfx.garbageCollection();
+
+		cancelled = !progress.Update(row + height, wxString::Format("Rendered %d of %d rows", row + height, image_height));
+	}
+
+	options = view_options;
+	g_gui.gfx.setSynchronousLoading(false);
+
+	if (written && !cancelled) {
+		written = png.close();
+	}
+
+	if (cancelled || !written) {
+		png.close();
+		wxRemoveFile(filename);
+		if (!written) {
+			g_gui.PopupDialog("File error", wxstr(png.getError()), wxOK);
+		}
+	} else {
+		g_gui.SetStatusText("Exported " + wxString::Format("%dx%d", image_width, image_height) + " image to " + filename);
+	}
+
+	Refresh();
+}
+
 void MapCanvas::ScreenToMap(int screen_x, int screen_y, int* map_x, int* map_y) {
 	int start_x, start_y;
 	static_cast<MapWindow*>(GetParent())->GetViewStart(&start_x, &start_y);
@@ -486,7 +623,7 @@ void MapCanvas::OnMouseMove(wxMouseEvent& event) {
 			ss << "Dragging " << -move_x << "," << -move_y << "," << -move_z;
 			g_gui.SetStatusText(ss);
 
-			Refresh();
+			RefreshOverlay();
 		} else if (boundbox_selection) {
 			if (map_update) {
 				wxString ss;
@@ -497,7 +634,7 @@ void MapCanvas::OnMouseMove(wxMouseEvent& event) {
 				g_gui.SetStatusText(ss);
 			}
 
-			Refresh();
+			RefreshOverlay();
 		}
 	} else { // Drawing mode
 		Brush* brush = g_gui.GetCurrentBrush();
@@ -579,7 +716,7 @@ void MapCanvas::OnMouseMove(wxMouseEvent& event) {
 		} else if (dragging_draw) {
 			g_gui.RefreshView();
 		} else if (map_update && brush) {
-			Refresh();
+			RefreshOverlay();
 		}
 	}
 }
@@ -973,8 +1110,7 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 						last_click_map_y = tmp;
 					}
 
-					int numtiles = 0;
-					int threadcount = std::max(g_settings.getInteger(Config::WORKER_THREADS), 1);
+					int threadcount = g_settings.getWorkerThreads();
 
 					int start_x = 0, start_y = 0, start_z = 0;
 					int end_x = 0, end_y = 0, end_z = 0;
@@ -1003,8 +1139,6 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 								end_x -= (floor < GROUND_LAYER ? GROUND_LAYER - floor : 0);
 								end_y -= (floor < GROUND_LAYER ? GROUND_LAYER - floor : 0);
 							}
-
-							numtiles = (start_z - end_z) * (end_x - start_x) * (end_y - start_y);
 							break;
 						}
 						case SELECT_VISIBLE_FLOORS: {
@@ -1030,36 +1164,23 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 						}
 					}
 
+					const int width = end_x - start_x + 1;
+					const int64_t numtiles = int64_t(width) * (end_y - start_y + 1) * (start_z - end_z + 1);
 					if (numtiles < 500) {
 						// No point in threading for such a small set.
 						threadcount = 1;
 					}
-					// Subdivide the selection area
-					// We know it's a square, just split it into several areas
-					int width = end_x - start_x;
-					if (width < threadcount) {
-						threadcount = min(1, width);
-					}
-					// Let's divide!
-					int remainder = width;
-					int cleared = 0;
+					threadcount = std::max(1, std::min(threadcount, (width + 3) / 4));
+
+					// Split the area into stripes of whole leaves, so no two threads
+					// look at the same leaf
+					const int stripe = ((width + threadcount - 1) / threadcount + 3) & ~3;
 					std::vector<SelectionThread*> threads;
-					if (width == 0) {
-						threads.push_back(newd SelectionThread(editor, Position(start_x, start_y, start_z), Position(start_x, end_y, end_z)));
-					} else {
-						for (int i = 0; i < threadcount; ++i) {
-							int chunksize = width / threadcount;
-							// The last threads takes all the remainder
-							if (i == threadcount - 1) {
-								chunksize = remainder;
-							}
-							threads.push_back(newd SelectionThread(editor, Position(start_x + cleared, start_y, start_z), Position(start_x + cleared + chunksize, end_y, end_z)));
-							cleared += chunksize;
-							remainder -= chunksize;
-						}
+					for (int x = start_x; x <= end_x;) {
+						const int stripe_end = std::min(end_x, ((x + stripe) & ~3) - 1);
+						threads.push_back(newd SelectionThread(editor, Position(x, start_y, start_z), Position(stripe_end, end_y, end_z)));
+						x = stripe_end + 1;
 					}
-					ASSERT(cleared == width);
-					ASSERT(remainder == 0);
 
 					editor.selection.start(); // Start a selection session
 					for (std::vector<SelectionThread*>::iterator iter = threads.begin(); iter != threads.end(); ++iter) {
@@ -2316,24 +2437,12 @@ void MapCanvas::ChangeFloor(int new_floor) {
 	ASSERT(new_floor >= 0 || new_floor < MAP_LAYERS);
 	int old_floor = floor;
 	floor = new_floor;
-	
-	// Force complete minimap refresh when crossing between underground and ground level
-	bool crossing_ground_level = (old_floor > GROUND_LAYER && new_floor <= GROUND_LAYER) || 
-							   (old_floor <= GROUND_LAYER && new_floor > GROUND_LAYER);
-	
+
+	// The minimap keeps every floor, so it only has to be drawn again
 	if (old_floor != new_floor) {
 		UpdatePositionStatus();
 		g_gui.root->UpdateFloorMenu();
-		
-		if (crossing_ground_level) {
-			// Force complete refresh of minimap when crossing ground level boundary
-			if (g_gui.minimap) {  // Use direct access since it's public
-				g_gui.minimap->ClearCache();
-			}
-			g_gui.UpdateMinimap(true);
-		} else {
-			g_gui.UpdateMinimap(true);
-		}
+		g_gui.UpdateMinimap(true);
 	}
 	Refresh();
 }
@@ -2657,8 +2766,28 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 			}
 		}
 
-		std::fill(std::begin(processed), std::end(processed), false);
-		floodFill(&editor.map, position, BLOCK_SIZE / 2, BLOCK_SIZE / 2, oldBrush, tilestodraw);
+		FloodFill fill(floor, [&](int x, int y) {
+			Tile* tile = editor.map.getTile(x, y, floor);
+			if (!oldBrush) {
+				return !tile || !tile->ground;
+			}
+			GroundBrush* groundBrush = tile ? tile->getGroundBrush() : nullptr;
+			return groundBrush && groundBrush->getID() == oldBrush->getID();
+		});
+		// Only the tiles within the window around the cursor are filled
+		const int radius = BLOCK_SIZE / 2 - 1;
+		fill.setBounds(
+			std::max(1, position.x - radius), std::max(1, position.y - radius),
+			std::min(editor.map.getWidth() - 1, position.x + radius), std::min(editor.map.getHeight() - 1, position.y + radius)
+		);
+
+		FloodFill::Result result = runFill(fill, position, [&](const PositionVector& positions) {
+			tilestodraw->insert(tilestodraw->end(), positions.begin(), positions.end());
+			return true;
+		});
+		if (result != FloodFill::FILL_DONE) {
+			tilestodraw->clear();
+		}
 
 	} else {
 		for (int y = -g_gui.GetBrushSize() - 1; y <= g_gui.GetBrushSize() + 1; y++) {
@@ -2692,57 +2821,35 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 	}
 }
 
-bool MapCanvas::floodFill(Map* map, const Position& center, int x, int y, GroundBrush* brush, PositionVector* positions) {
-	countMaxFills++;
-	if (countMaxFills > (BLOCK_SIZE * 4 * 4)) {
-		countMaxFills = 0;
-		return true;
-	}
+FloodFill::Result MapCanvas::runFill(FloodFill& fill, const Position& start, const FloodFill::Receiver& receiver) {
+	const int64_t max_area = std::max(1, g_settings.getInteger(Config::FILL_MAX_AREA));
+	fill.setMaxArea(max_area);
 
-	if (x <= 0 || y <= 0 || x >= BLOCK_SIZE || y >= BLOCK_SIZE) {
-		return false;
-	}
-
-	processed[getFillIndex(x, y)] = true;
-
-	int px = (center.x + x) - (BLOCK_SIZE / 2);
-	int py = (center.y + y) - (BLOCK_SIZE / 2);
-	if (px <= 0 || py <= 0 || px >= map->getWidth() || py >= map->getHeight()) {
-		return false;
-	}
-
-	Tile* tile = map->getTile(px, py, center.z);
-	if ((tile && tile->ground && !brush) || (!tile && brush)) {
-		return false;
-	}
-
-	if (tile && brush) {
-		GroundBrush* groundBrush = tile->getGroundBrush();
-		if (!groundBrush || groundBrush->getID() != brush->getID()) {
+	// Small areas are done before a load bar would show up
+	bool loadbar = false;
+	FloodFill::Result result = fill.run(start, FillChunkSize, [&](const PositionVector& positions) {
+		if (!receiver(positions)) {
 			return false;
 		}
+		if (!loadbar) {
+			if (positions.size() < FillChunkSize) {
+				return true;
+			}
+			g_gui.CreateLoadBar("Filling area...", true);
+			loadbar = true;
+		}
+		return g_gui.SetLoadDone(int32_t(fill.getArea() * 100 / max_area), wxString::Format("Filling area... %lld tiles", (long long)fill.getArea()));
+	});
+	if (loadbar) {
+		g_gui.DestroyLoadBar();
 	}
 
-	positions->push_back(Position(px, py, center.z));
-
-	bool deny = false;
-	if (!processed[getFillIndex(x - 1, y)]) {
-		deny = floodFill(map, center, x - 1, y, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x, y - 1)]) {
-		deny = floodFill(map, center, x, y - 1, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x + 1, y)]) {
-		deny = floodFill(map, center, x + 1, y, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x, y + 1)]) {
-		deny = floodFill(map, center, x, y + 1, brush, positions);
+	if (result == FloodFill::FILL_TOO_LARGE) {
+		g_gui.PopupDialog("Error", wxString::Format("Cannot fill - the area is larger than %lld tiles.", (long long)max_area), wxOK);
+	} else if (result == FloodFill::FILL_NOT_ENCLOSED) {
+		g_gui.PopupDialog("Error", "Cannot fill - area is not enclosed.", wxOK);
 	}
-
-	return deny;
+	return result;
 }
 
 // ============================================================================
@@ -2760,7 +2867,7 @@ AnimationTimer::~AnimationTimer() {
 };
 
 void AnimationTimer::Notify() {
-	if (map_canvas->GetZoom() <= 2.0) {
+	if (map_canvas->GetZoom() <= 2.0 && map_canvas->IsAnimationPending()) {
 		map_canvas->Refresh();
 	}
 };
@@ -2957,77 +3064,36 @@ void MapCanvas::OnFill(wxCommandEvent& WXUNUSED(event)) {
     } else {
         // Normal fill with area validation
         OutputDebugStringA("NORMAL FILL INITIATED! VALIDATING AREA...\n");
-        
-        std::queue<Position> to_check;
-        std::set<Position> checked;
-        to_check.push(start);
-        bool escape_found = false;
-
-        while (!to_check.empty() && !escape_found) {
-            Position pos = to_check.front();
-            to_check.pop();
-
-            if (checked.count(pos) > 0) continue;
-            checked.insert(pos);
-
-            // Check map boundaries
-            if (pos.x <= 0 || pos.y <= 0 || 
-                pos.x >= editor.map.getWidth() - 1 || 
-                pos.y >= editor.map.getHeight() - 1) {
-                escape_found = true;
-                break;
-            }
-
-            Tile* tile = editor.map.getTile(pos);
-            bool is_empty = (!tile || 
-                           (!tile->spawn || !g_settings.getInteger(Config::SHOW_SPAWNS)) && 
-                           (!tile->creature || !g_settings.getInteger(Config::SHOW_CREATURES)) && 
-                           !tile->getTopItem());
 
-            if (!is_empty) continue;
+        Brush* brush = g_gui.GetCurrentBrush();
+        const bool show_spawns = g_settings.getBoolean(Config::SHOW_SPAWNS);
+        const bool show_creatures = g_settings.getBoolean(Config::SHOW_CREATURES);
 
-            // Check adjacent tiles (4-directional)
-            Position adjacent[4] = {
-                Position(pos.x + 1, pos.y, floor),
-                Position(pos.x - 1, pos.y, floor),
-                Position(pos.x, pos.y + 1, floor),
-                Position(pos.x, pos.y - 1, floor)
-            };
+        FloodFill fill(floor, [&](int x, int y) {
+            Tile* tile = editor.map.getTile(x, y, floor);
+            return !tile || ((!tile->spawn || !show_spawns) && (!tile->creature || !show_creatures) && !tile->getTopItem());
+        });
+        fill.setBounds(0, 0, editor.map.getWidth() - 1, editor.map.getHeight() - 1);
+        fill.setEnclosed(true);
 
-            for (const Position& next : adjacent) {
-                if (checked.count(next) > 0) continue;
-                
-                Tile* next_tile = editor.map.getTile(next);
-                bool next_is_empty = (!next_tile || 
-                                    (!next_tile->spawn || !g_settings.getInteger(Config::SHOW_SPAWNS)) && 
-                                    (!next_tile->creature || !g_settings.getInteger(Config::SHOW_CREATURES)) && 
-                                    !next_tile->getTopItem());
-                
-                if (next_is_empty) {
-                    to_check.push(next);
-                }
+        // Tiles are drawn a chunk at a time while the area is searched, the
+        // action is only added if the whole area could be filled
+        Action* action = editor.actionQueue->createAction(ACTION_DRAW);
+        FloodFill::Result result = runFill(fill, start, [&](const PositionVector& positions) {
+            for (const Position& pos : positions) {
+                Tile* tile = editor.map.getTile(pos);
+                Tile* new_tile = tile ? tile->deepCopy(editor.map) : editor.map.allocator(editor.map.createTileL(pos));
+                brush->draw(&editor.map, new_tile, nullptr);
+                action->addChange(newd Change(new_tile));
             }
-        }
+            return true;
+        });
 
-        if (escape_found) {
-            OutputDebugStringA("AREA NOT ENCLOSED! THE VOID LEAKS!\n");
-            g_gui.PopupDialog("Error", "Cannot fill - area is not enclosed.", wxOK);
+        if (result != FloodFill::FILL_DONE) {
+            delete action;
             return;
         }
 
-        OutputDebugStringA(wxString::Format("FOUND %d TILES TO FILL NORMALLY!\n", checked.size()).c_str());
-        
-        Action* action = editor.actionQueue->createAction(ACTION_DRAW);
-        for (const Position& pos : checked) {
-            Tile* tile = editor.map.getTile(pos);
-            if (!tile) {
-                tile = editor.map.createTile(pos.x, pos.y, pos.z);
-            }
-            Tile* new_tile = tile->deepCopy(editor.map);
-            g_gui.GetCurrentBrush()->draw(&editor.map, new_tile, nullptr);
-            action->addChange(newd Change(new_tile));
-        }
-        
         editor.addAction(action);
         g_gui.RefreshView();
         OutputDebugStringA("NORMAL FILL COMPLETE! THE VOID HAS BEEN FILLED!\n");
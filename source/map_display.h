@@ -21,6 +21,7 @@
 #include "action.h"
 #include "tile.h"
 #include "creature.h"
+#include "flood_fill.h"
 
 class Item;
 class Creature;
@@ -96,6 +97,8 @@ public:
 	void OnFill(wxCommandEvent& event);
 
 	void Refresh();
+	// Redraws only what follows the cursor, the map itself is drawn from the last frame
+	void RefreshOverlay();
 
 	void ScreenToMap(int screen_x, int screen_y, int* map_x, int* map_y);
 	void GetScreenCenter(int* map_x, int* map_y);
@@ -121,6 +124,8 @@ public:
 	Position GetCursorPosition() const;
 
 	void TakeScreenshot(wxFileName path, wxString format);
+	// Renders the area at the given zoom into a PNG, piece by piece
+	void ExportRegion(const wxString& filename, const Position& from, const Position& to, double zoom);
 
 	void MouseToMap(int* map_x, int* map_y) {
 		ScreenToMap(cursor_x, cursor_y, map_x, map_y);
@@ -128,23 +133,22 @@ public:
 
 protected:
 	void getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, PositionVector* tilestodraw, PositionVector* tilestoborder, bool fill = false);
-	bool floodFill(Map* map, const Position& center, int x, int y, GroundBrush* brush, PositionVector* positions);
+	// Runs the fill with the area limit from the settings, showing a load bar
+	// for large areas and an error if the area could not be filled
+	FloodFill::Result runFill(FloodFill& fill, const Position& start, const FloodFill::Receiver& receiver);
 
 private:
 	enum {
+		// Width and height of the window around the cursor Ctrl+D fills, also scales the border fill batches
 		BLOCK_SIZE = 100
 	};
 
-	inline int getFillIndex(int x, int y) const {
-		return x + BLOCK_SIZE * y;
-	}
-
-	static bool processed[BLOCK_SIZE * BLOCK_SIZE];
+	// Positions handed to the draw code at once while filling
+	static const size_t FillChunkSize = 4096;
 
 	Editor& editor;
 	MapDrawer* drawer;
 	int keyCode;
-	int countMaxFills = 0;
 
 	// View related
 	int floor;
@@ -156,10 +160,15 @@ private:
 	bool boundbox_selection;
 	bool screendragging;
 	bool isPasting() const;
+	bool IsAnimationPending() const;
 	bool drawing;
 	bool dragging_draw;
 	bool replace_dragging;
 
+	// Refreshes requested since the last paint
+	bool map_refresh;
+	bool overlay_refresh;
+
 	uint8_t* screenshot_buffer;
 
 	int drag_start_x;
@@ -17,12 +17,6 @@
 
 #include "main.h"
 
-#ifdef __APPLE__
-	#include <GLUT/glut.h>
-#else
-	#include <GL/glut.h>
-#endif
-
 #include "editor.h"
 #include "gui.h"
 #include "sprites.h"
@@ -43,6 +37,9 @@
 #include "table_brush.h"
 #include "waypoint_brush.h"
 #include "light_drawer.h"
+#include "lod_drawer.h"
+#include "text_renderer.h"
+#include "frame_profiler.h"
 
 DrawingOptions::DrawingOptions() {
 	SetDefault();
@@ -78,6 +75,8 @@ void DrawingOptions::SetDefault() {
 	show_preview = false;
 	show_hooks = false;
 	hide_items_when_zoomed = true;
+	lod_zoom_threshold = 0;
+	show_profiler = false;
 }
 
 void DrawingOptions::SetIngame() {
@@ -110,6 +109,8 @@ void DrawingOptions::SetIngame() {
 	show_preview = false;
 	show_hooks = false;
 	hide_items_when_zoomed = false;
+	lod_zoom_threshold = 0;
+	show_profiler = false;
 }
 
 bool DrawingOptions::isDrawLight() const noexcept {
@@ -117,12 +118,23 @@ bool DrawingOptions::isDrawLight() const noexcept {
 }
 
 MapDrawer::MapDrawer(MapCanvas* canvas) :
-	canvas(canvas), editor(canvas->editor) {
+	canvas(canvas), editor(canvas->editor),
+	occlusion_x(0), occlusion_y(0),
+	occlusion_width(0), occlusion_height(0),
+	prefetch_start_x(0), prefetch_start_y(0),
+	prefetch_end_x(0), prefetch_end_y(0),
+	prefetch_floor(-1) {
 	light_drawer = std::make_shared<LightDrawer>();
+	lod_drawer = std::make_shared<LodDrawer>();
+	text_renderer = std::make_shared<TextRenderer>();
 }
 
 MapDrawer::~MapDrawer() {
 	Release();
+	ClearTooltips();
+	if (map_layer.texture != 0) {
+		glDeleteTextures(1, &map_layer.texture);
+	}
 }
 
 void MapDrawer::SetupVars() {
@@ -132,9 +144,27 @@ void MapDrawer::SetupVars() {
 	dragging = canvas->dragging;
 	dragging_draw = canvas->dragging_draw;
 
-	zoom = (float)canvas->GetZoom();
+	SetupView((float)canvas->GetZoom(), canvas->GetFloor());
+}
+
+void MapDrawer::SetupRegion(int scroll_x, int scroll_y, int width, int height, int floor, float zoom) {
+	mouse_map_x = -1;
+	mouse_map_y = -1;
+	view_scroll_x = scroll_x;
+	view_scroll_y = scroll_y;
+	screensize_x = width;
+	screensize_y = height;
+
+	dragging = false;
+	dragging_draw = false;
+
+	SetupView(zoom, floor);
+}
+
+void MapDrawer::SetupView(float zoom, int floor) {
+	this->zoom = zoom;
 	tile_size = int(TileSize / zoom); // after zoom
-	floor = canvas->GetFloor();
+	this->floor = floor;
 
 	if (options.show_all_floors) {
 		if (floor <= GROUND_LAYER) {
@@ -181,11 +211,6 @@ void MapDrawer::SetupGL() {
 }
 
 void MapDrawer::Release() {
-	for (std::vector<MapTooltip*>::const_iterator it = tooltips.begin(); it != tooltips.end(); ++it) {
-		delete *it;
-	}
-	tooltips.clear();
-
 	if (light_drawer) {
 		light_drawer->clear();
 	}
@@ -197,11 +222,19 @@ void MapDrawer::Release() {
 	glPopMatrix();
 }
 
-void MapDrawer::Draw() {
-	DrawBackground();
-	DrawMap();
-	if (options.isDrawLight()) {
-		DrawLight();
+void MapDrawer::Draw(bool reuse_map_layer) {
+	if (reuse_map_layer && CanReuseMapLayer()) {
+		DrawMapLayer();
+	} else {
+		// Tooltips are collected while drawing the map and kept with the layer
+		ClearTooltips();
+		DrawBackground();
+		DrawMap();
+		PrefetchSprites();
+		if (options.isDrawLight()) {
+			DrawLight();
+		}
+		StoreMapLayer();
 	}
 	DrawDraggingShadow();
 	DrawHigherFloors();
@@ -219,9 +252,129 @@ void MapDrawer::Draw() {
 	if (options.show_tooltips) {
 		DrawTooltips();
 	}
+	if (options.show_profiler) {
+		DrawProfiler();
+	}
+	text_renderer->finishFrame();
+}
+
+void MapDrawer::DrawRegion() {
+	ClearTooltips();
+	DrawBackground();
+	DrawMap();
+	if (options.isDrawLight()) {
+		DrawLight();
+	}
+}
+
+void MapDrawer::ClearTooltips() {
+	for (std::vector<MapTooltip*>::const_iterator it = tooltips.begin(); it != tooltips.end(); ++it) {
+		delete *it;
+	}
+	tooltips.clear();
+}
+
+bool MapDrawer::CanReuseMapLayer() const {
+	if (!map_layer.valid) {
+		return false;
+	}
+
+	// Animations and the paste / doodad preview change without the map changing
+	if (!animators.empty() || map_layer.preview != options.show_preview || g_gui.secondary_map != nullptr) {
+		return false;
+	}
+
+	return map_layer.scroll_x == view_scroll_x && map_layer.scroll_y == view_scroll_y
+		&& map_layer.width == screensize_x && map_layer.height == screensize_y
+		&& map_layer.floor == floor && map_layer.zoom == zoom
+		&& map_layer.revision == editor.map.getRevision()
+		&& map_layer.brush == g_gui.GetCurrentBrush();
+}
+
+void MapDrawer::StoreMapLayer() {
+	map_layer.valid = false;
+	if (screensize_x <= 0 || screensize_y <= 0) {
+		return;
+	}
+
+	if (map_layer.texture == 0) {
+		map_layer.texture = g_gui.gfx.getFreeTextureID();
+	}
+
+	glBindTexture(GL_TEXTURE_2D, map_layer.texture);
+	if (map_layer.texture_width < screensize_x || map_layer.texture_height < screensize_y) {
+		// Power of two sizes, so it also works without non power of two texture support
+		int width = 1, height = 1;
+		while (width < screensize_x) {
+			width <<= 1;
+		}
+		while (height < screensize_y) {
+			height <<= 1;
+		}
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		map_layer.texture_width = width;
+		map_layer.texture_height = height;
+	}
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, screensize_x, screensize_y);
+
+	map_layer.valid = true;
+	map_layer.scroll_x = view_scroll_x;
+	map_layer.scroll_y = view_scroll_y;
+	map_layer.width = screensize_x;
+	map_layer.height = screensize_y;
+	map_layer.floor = floor;
+	map_layer.zoom = zoom;
+	map_layer.revision = editor.map.getRevision();
+	map_layer.brush = g_gui.GetCurrentBrush();
+	map_layer.preview = options.show_preview;
+	map_layer.start_x = start_x;
+	map_layer.start_y = start_y;
+	map_layer.end_x = end_x;
+	map_layer.end_y = end_y;
+}
+
+void MapDrawer::DrawMapLayer() {
+	start_x = map_layer.start_x;
+	start_y = map_layer.start_y;
+	end_x = map_layer.end_x;
+	end_y = map_layer.end_y;
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glLoadIdentity();
+
+	const float width = screensize_x * zoom;
+	const float height = screensize_y * zoom;
+	const float u = float(screensize_x) / map_layer.texture_width;
+	const float v = float(screensize_y) / map_layer.texture_height;
+
+	// The copy is upside down, rows start at the bottom of the screen
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, map_layer.texture);
+	glColor4ub(255, 255, 255, 255);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.f, v);
+	glVertex2f(0.f, 0.f);
+	glTexCoord2f(u, v);
+	glVertex2f(width, 0.f);
+	glTexCoord2f(u, 0.f);
+	glVertex2f(width, height);
+	glTexCoord2f(0.f, 0.f);
+	glVertex2f(0.f, height);
+	glEnd();
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_BLEND);
 }
 
 void MapDrawer::DrawBackground() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_BACKGROUND);
+
 	// Black Background
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
@@ -244,6 +397,9 @@ inline int getFloorAdjustment(int floor) {
 }
 
 void MapDrawer::DrawMap() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_MAP);
+	animators.clear();
+
 	int center_x = start_x + int(screensize_x * zoom / 64);
 	int center_y = start_y + int(screensize_y * zoom / 64);
 	int offset_y = 2;
@@ -273,6 +429,15 @@ void MapDrawer::DrawMap() {
 		glEnable(GL_TEXTURE_2D);
 	}
 
+	// Far zoomed out, draw the cached block textures instead of every sprite
+	bool lod = !only_colors && !live_client && !options.show_only_modified && options.lod_zoom_threshold > 0 && zoom > options.lod_zoom_threshold;
+
+	// Skip tiles of lower floors that are hidden below the full ground of a higher floor
+	bool occlusion = !lod && !only_colors && !options.show_only_modified && start_z != end_z;
+	if (occlusion) {
+		BuildOcclusionMask();
+	}
+
 	for (int map_z = start_z; map_z >= superend_z; map_z--) {
 		if (map_z == end_z && start_z != end_z && options.show_shade) {
 			// Draw shade
@@ -293,7 +458,15 @@ void MapDrawer::DrawMap() {
 			}
 		}
 
-		if (map_z >= end_z) {
+		if (map_z >= end_z && lod) {
+			int offset;
+			if (map_z <= GROUND_LAYER) {
+				offset = (GROUND_LAYER - map_z) * TileSize;
+			} else {
+				offset = TileSize * (floor - map_z);
+			}
+			lod_drawer->draw(editor.map, map_z, offset, view_scroll_x, view_scroll_y, int(screensize_x * zoom), int(screensize_y * zoom));
+		} else if (map_z >= end_z) {
 			int nd_start_x = start_x & ~3;
 			int nd_start_y = start_y & ~3;
 			int nd_end_x = (end_x & ~3) + 4;
@@ -315,7 +488,9 @@ void MapDrawer::DrawMap() {
 						for (int map_x = 0; map_x < 4; ++map_x) {
 							for (int map_y = 0; map_y < 4; ++map_y) {
 								TileLocation* location = nd->getTile(map_x, map_y, map_z);
-								DrawTile(location);
+								if (!occlusion || map_z == end_z || !location || !IsOccluded(location->getX(), location->getY(), map_z)) {
+									DrawTile(location);
+								}
 								// draw light, but only if not zoomed too far
 								if (location && options.isDrawLight() && zoom <= 10.0) {
 									AddLight(location);
@@ -436,11 +611,147 @@ void MapDrawer::DrawMap() {
 		++end_y;
 	}
 
+	if (lod) {
+		lod_drawer->finishFrame();
+	}
+
 	if (!only_colors) {
 		glEnable(GL_TEXTURE_2D);
 	}
 }
 
+void MapDrawer::PrefetchSprites() {
+	// Further out the view is too large (or drawn from the LOD cache)
+	if (zoom > 4.0 || options.show_as_minimap || options.show_only_colors) {
+		return;
+	}
+
+	// Queue the sprites around the view in the background, so they are ready once they are scrolled in
+	const int margin = 8;
+	int from_x = std::max(view_scroll_x / TileSize - margin, 0);
+	int from_y = std::max(view_scroll_y / TileSize - margin, 0);
+	int to_x = (view_scroll_x + int(screensize_x * zoom)) / TileSize + margin;
+	int to_y = (view_scroll_y + int(screensize_y * zoom)) / TileSize + margin;
+
+	if (from_x == prefetch_start_x && from_y == prefetch_start_y && to_x == prefetch_end_x && to_y == prefetch_end_y && floor == prefetch_floor) {
+		return;
+	}
+	prefetch_start_x = from_x;
+	prefetch_start_y = from_y;
+	prefetch_end_x = to_x;
+	prefetch_end_y = to_y;
+	prefetch_floor = floor;
+
+	for (int map_z = end_z; map_z <= start_z; ++map_z) {
+		int shift;
+		if (map_z <= GROUND_LAYER) {
+			shift = GROUND_LAYER - map_z;
+		} else {
+			shift = floor - map_z;
+		}
+
+		for (int map_x = from_x + shift; map_x <= to_x + shift; ++map_x) {
+			for (int map_y = from_y + shift; map_y <= to_y + shift; ++map_y) {
+				const Tile* tile = editor.map.getTile(map_x, map_y, map_z);
+				if (!tile) {
+					continue;
+				}
+
+				if (tile->ground) {
+					GameSprite* sprite = g_items[tile->ground->getID()].sprite;
+					if (sprite) {
+						sprite->prefetch();
+					}
+				}
+				for (const Item* item : tile->items) {
+					GameSprite* sprite = g_items[item->getID()].sprite;
+					if (sprite) {
+						sprite->prefetch();
+					}
+				}
+			}
+		}
+	}
+}
+
+void MapDrawer::BuildOcclusionMask() {
+	// A tile at (x, y, z) is drawn over the same screen cell as (x - 1, y - 1, z - 1),
+	// so cells are indexed in the coordinate space of the current floor.
+	int span = start_z - end_z;
+	occlusion_x = start_x - span - 8;
+	occlusion_y = start_y - span - 8;
+	occlusion_width = end_x - start_x + span * 2 + 24;
+	occlusion_height = end_y - start_y + span * 2 + 24;
+	occlusion_mask.assign(occlusion_width * occlusion_height, MAP_LAYERS);
+
+	bool live_client = editor.IsLiveClient();
+
+	// Top-down, so the first floor to cover a cell is the one that hides it
+	for (int map_z = end_z; map_z < start_z; ++map_z) {
+		int grow = start_z - map_z;
+		int shift = map_z - floor;
+
+		int nd_start_x = (start_x - grow) & ~3;
+		int nd_start_y = (start_y - grow) & ~3;
+		int nd_end_x = ((end_x + grow) & ~3) + 4;
+		int nd_end_y = ((end_y + grow) & ~3) + 4;
+
+		for (int nd_map_x = nd_start_x; nd_map_x <= nd_end_x; nd_map_x += 4) {
+			for (int nd_map_y = nd_start_y; nd_map_y <= nd_end_y; nd_map_y += 4) {
+				QTreeNode* nd = editor.map.getLeaf(nd_map_x, nd_map_y);
+				if (!nd || live_client && !nd->isVisible(map_z > GROUND_LAYER)) {
+					continue;
+				}
+
+				Floor* nd_floor = nd->getFloor(map_z);
+				if (!nd_floor) {
+					continue;
+				}
+
+				for (TileLocation& location : nd_floor->locs) {
+					Tile* tile = location.get();
+					if (!tile || !tile->ground || !tile->ground->isFullGround()) {
+						continue;
+					}
+
+					int cell_x = location.getX() + shift - occlusion_x;
+					int cell_y = location.getY() + shift - occlusion_y;
+					if (cell_x < 0 || cell_y < 0 || cell_x >= occlusion_width || cell_y >= occlusion_height) {
+						continue;
+					}
+
+					uint8_t& top = occlusion_mask[cell_y * occlusion_width + cell_x];
+					if (top == MAP_LAYERS) {
+						top = map_z;
+					}
+				}
+			}
+		}
+	}
+}
+
+bool MapDrawer::IsOccluded(int map_x, int map_y, int map_z) const {
+	int cell_x = map_x + (map_z - floor) - occlusion_x;
+	int cell_y = map_y + (map_z - floor) - occlusion_y;
+	if (cell_x < 2 || cell_y < 2 || cell_x >= occlusion_width || cell_y >= occlusion_height) {
+		return false;
+	}
+
+	// Large sprites reach one cell up and left of the tile, displacement and elevation
+	// can push them into the next one, so the diagonal cell and its neighbours must be
+	// covered too. Sprites wider than two cells or on very high stacks can still reach
+	// past these and be hidden where they should show.
+	for (int y = cell_y - 2; y <= cell_y; ++y) {
+		const uint8_t* row = &occlusion_mask[y * occlusion_width];
+		for (int x = cell_x - 2; x <= cell_x; ++x) {
+			if (row[x] >= map_z) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 void MapDrawer::DrawIngameBox() {
 	int center_x = start_x + int(screensize_x * zoom / 64);
 	int center_y = start_y + int(screensize_y * zoom / 64);
@@ -580,6 +891,8 @@ void MapDrawer::DrawDraggingShadow() {
 }
 
 void MapDrawer::DrawHigherFloors() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_HIGHER_FLOORS);
+
 	glEnable(GL_TEXTURE_2D);
 
 	// Draw "transparent higher floor"
@@ -714,6 +1027,8 @@ void MapDrawer::DrawLiveCursors() {
 }
 
 void MapDrawer::DrawBrush() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_BRUSH);
+
 	if (!g_gui.IsDrawingMode()) {
 		return;
 	}
@@ -1056,6 +1371,8 @@ void MapDrawer::BlitItem(int& draw_x, int& draw_y, const Tile* tile, Item* item,
 }
 
 void MapDrawer::BlitItem(int& draw_x, int& draw_y, const Position& pos, Item* item, bool ephemeral, int red, int green, int blue, int alpha, const Tile* tile) {
+	g_profiler.count(FrameProfiler::COUNTER_ITEMS);
+
 	ItemType& it = g_items[item->getID()];
 
 	// Locked door indicator
@@ -1125,41 +1442,8 @@ void MapDrawer::BlitItem(int& draw_x, int& draw_y, const Position& pos, Item* it
 	draw_x -= spr->getDrawHeight();
 	draw_y -= spr->getDrawHeight();
 
-	int subtype = -1;
-
-	int pattern_x = pos.x % spr->pattern_x;
-	int pattern_y = pos.y % spr->pattern_y;
-	int pattern_z = pos.z % spr->pattern_z;
-
-	if (it.isSplash() || it.isFluidContainer()) {
-		subtype = item->getSubtype();
-	} else if (it.isHangable) {
-		if (tile && tile->hasProperty(HOOK_SOUTH)) {
-			pattern_x = 1;
-		} else if (tile && tile->hasProperty(HOOK_EAST)) {
-			pattern_x = 2;
-		} else {
-			pattern_x = 0;
-		}
-	} else if (it.stackable) {
-		if (item->getSubtype() <= 1) {
-			subtype = 0;
-		} else if (item->getSubtype() <= 2) {
-			subtype = 1;
-		} else if (item->getSubtype() <= 3) {
-			subtype = 2;
-		} else if (item->getSubtype() <= 4) {
-			subtype = 3;
-		} else if (item->getSubtype() < 10) {
-			subtype = 4;
-		} else if (item->getSubtype() < 25) {
-			subtype = 5;
-		} else if (item->getSubtype() < 50) {
-			subtype = 6;
-		} else {
-			subtype = 7;
-		}
-	}
+	int subtype, pattern_x, pattern_y, pattern_z;
+	item->getSpritePattern(spr, pos, tile, subtype, pattern_x, pattern_y, pattern_z);
 
 	if (!ephemeral && options.transparent_items && (!it.isGroundTile() || spr->width > 1 || spr->height > 1) && !it.isSplash() && (!it.isBorder || spr->width > 1 || spr->height > 1)) {
 		alpha /= 2;
@@ -1355,6 +1639,7 @@ void MapDrawer::BlitSquare(int sx, int sy, int red, int green, int blue, int alp
 	}
 
 	glBindTexture(GL_TEXTURE_2D, texnum);
+	g_profiler.count(FrameProfiler::COUNTER_TEXTURE_BINDS);
 	glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 	glBegin(GL_QUADS);
 	glTexCoord2f(0.f, 0.f);
@@ -1482,11 +1767,16 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		return;
 	}
 
+	g_profiler.count(FrameProfiler::COUNTER_TILES);
+
 	int map_x = location->getX();
 	int map_y = location->getY();
 	int map_z = location->getZ();
 
-	Waypoint* waypoint = canvas->editor.map.waypoints.getWaypoint(location);
+	Waypoint* waypoint = nullptr;
+	if (canvas->editor.map.waypoints.getWaypointCount() > 0) {
+		waypoint = canvas->editor.map.waypoints.getWaypoint(location);
+	}
 	if (options.show_tooltips && location->getWaypointCount() > 0) {
 		if (waypoint) {
 			WriteTooltip(waypoint, tooltip);
@@ -1573,7 +1863,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 	} else {
 		if (tile->ground) {
 			if (options.show_preview && zoom <= 2.0) {
-				tile->ground->animate();
+				AnimateItem(tile->ground);
 			}
 
 			BlitItem(draw_x, draw_y, tile, tile->ground, false, r, g, b);
@@ -1598,7 +1888,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 
 				// item animation
 				if (options.show_preview && zoom <= 2.0) {
-					(*it)->animate();
+					AnimateItem(*it);
 				}
 
 				// item sprite
@@ -1740,36 +2030,19 @@ void MapDrawer::DrawHookIndicator(int x, int y, const ItemType& type) {
 }
 
 void MapDrawer::DrawTooltips() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_TOOLTIPS);
+
+	const float view_width = screensize_x * zoom;
+	const float view_height = screensize_y * zoom;
+
 	for (std::vector<MapTooltip*>::const_iterator it = tooltips.begin(); it != tooltips.end(); ++it) {
 		MapTooltip* tooltip = (*it);
-		const char* text = tooltip->text.c_str();
-		float line_width = 0.0f;
-		float width = 2.0f;
-		float height = 14.0f;
-		int char_count = 0;
-		int line_char_count = 0;
-
-		for (const char* c = text; *c != '\0'; c++) {
-			if (*c == '\n' || (line_char_count >= MapTooltip::MAX_CHARS_PER_LINE && *c == ' ')) {
-				height += 14.0f;
-				line_width = 0.0f;
-				line_char_count = 0;
-			} else {
-				line_width += glutBitmapWidth(GLUT_BITMAP_HELVETICA_12, *c);
-			}
-			width = std::max<float>(width, line_width);
-			char_count++;
-			line_char_count++;
-
-			if (tooltip->ellipsis && char_count > (MapTooltip::MAX_CHARS + 3)) {
-				break;
-			}
-		}
+		const TextRenderer::Layout& layout = text_renderer->getLayout(tooltip->text, MapTooltip::MAX_CHARS_PER_LINE, MapTooltip::MAX_CHARS);
 
 		float scale = zoom < 1.0f ? zoom : 1.0f;
 
-		width = (width + 8.0f) * scale;
-		height = (height + 4.0f) * scale;
+		float width = (std::max(layout.width, 2.0f) + 8.0f) * scale;
+		float height = (layout.height + 4.0f) * scale;
 
 		float x = tooltip->x + (TileSize / 2.0f);
 		float y = tooltip->y;
@@ -1780,6 +2053,10 @@ void MapDrawer::DrawTooltips() {
 		float starty = y - (height + space);
 		float endy = y - space;
 
+		if (endx < 0 || startx > view_width || y < 0 || starty > view_height) {
+			continue;
+		}
+
 		// 7----0----1
 		// |         |
 		// 6--5  3--2
@@ -1798,6 +2075,7 @@ void MapDrawer::DrawTooltips() {
 		};
 
 		// background
+		glDisable(GL_TEXTURE_2D);
 		glColor4ub(tooltip->r, tooltip->g, tooltip->b, 255);
 		glBegin(GL_POLYGON);
 		for (int i = 0; i < 8; ++i) {
@@ -1816,40 +2094,110 @@ void MapDrawer::DrawTooltips() {
 		glEnd();
 
 		// text
+		glEnable(GL_TEXTURE_2D);
 		if (zoom <= 1.0) {
-			startx += (3.0f * scale);
-			starty += (14.0f * scale);
 			glColor4ub(0, 0, 0, 255);
-			glRasterPos2f(startx, starty);
-			char_count = 0;
-			line_char_count = 0;
-			for (const char* c = text; *c != '\0'; c++) {
-				if (*c == '\n' || (line_char_count >= MapTooltip::MAX_CHARS_PER_LINE && *c == ' ')) {
-					starty += (14.0f * scale);
-					glRasterPos2f(startx, starty);
-					line_char_count = 0;
-				}
-				char_count++;
-				line_char_count++;
-
-				if (tooltip->ellipsis && char_count >= MapTooltip::MAX_CHARS) {
-					glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, '.');
-					if (char_count >= (MapTooltip::MAX_CHARS + 2)) {
-						break;
-					}
-				} else if (!iscntrl(*c)) {
-					glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
-				}
-			}
+			text_renderer->draw(layout, startx + (4.0f * scale), starty + (2.0f * scale), scale);
 		}
 	}
 }
 
 void MapDrawer::DrawLight() {
+	FrameProfiler::ScopedStage profile(g_profiler, FrameProfiler::STAGE_LIGHT);
+
 	// draw in-game light
 	light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y, options.experimental_fog);
 }
 
+void MapDrawer::AnimateItem(Item* item) {
+	GameSprite* sprite = g_items[item->getID()].sprite;
+	if (!sprite || !sprite->animator) {
+		return;
+	}
+
+	item->animate();
+	animators[sprite->animator] = item->getFrame();
+}
+
+bool MapDrawer::HasAnimationChanged() const {
+	for (const auto& animator : animators) {
+		if (animator.first->getFrame() != animator.second) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void MapDrawer::DrawProfiler() {
+	const std::deque<FrameProfiler::Frame>& history = g_profiler.getHistory();
+	const FrameProfiler::Frame last = history.empty() ? FrameProfiler::Frame() : history.back();
+	const FrameProfiler::Frame average = g_profiler.getAverage();
+	const GraphicManager::TextureStats textures = g_gui.gfx.getTextureStats();
+
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(2);
+	text << "frame: " << last.total << " ms (avg " << average.total << ")\n";
+	for (int i = 0; i < FrameProfiler::STAGE_COUNT; ++i) {
+		text << FrameProfiler::getStageName(static_cast<FrameProfiler::Stage>(i)) << ": " << last.stages[i] << " ms\n";
+	}
+	for (int i = 0; i < FrameProfiler::COUNTER_COUNT; ++i) {
+		text << FrameProfiler::getCounterName(static_cast<FrameProfiler::Counter>(i)) << ": " << last.counters[i] << "\n";
+	}
+	text << "resident textures: " << textures.resident << " (" << std::setprecision(1) << textures.resident_bytes / (1024.0 * 1024.0) << " MB)";
+
+	const TextRenderer::Layout& layout = text_renderer->getLayout(text.str(), 1024, 4096);
+
+	// Sizes are in screen pixels, whatever the zoom
+	const float scale = zoom;
+	const float histogram_height = 60.0f;
+	const float x = 8.0f * scale;
+	const float y = 8.0f * scale;
+	const float width = (std::max<float>(layout.width, FrameProfiler::HistorySize) + 8.0f) * scale;
+	const float height = (layout.height + histogram_height + 12.0f) * scale;
+
+	glDisable(GL_TEXTURE_2D);
+	glColor4ub(0, 0, 0, 160);
+	glBegin(GL_QUADS);
+	glVertex2f(x, y);
+	glVertex2f(x + width, y);
+	glVertex2f(x + width, y + height);
+	glVertex2f(x, y + height);
+	glEnd();
+
+	// Stacked stage times of the recent frames, newest on the right, the line marks 60 fps
+	const float pixels_per_ms = histogram_height / 33.3f;
+	const float base = y + height - 4.0f * scale;
+	const float ceiling = base - histogram_height * scale;
+	float bar_x = x + 4.0f * scale + (FrameProfiler::HistorySize - history.size()) * scale;
+	glBegin(GL_QUADS);
+	for (const FrameProfiler::Frame& frame : history) {
+		float bottom = base;
+		for (int i = 0; i < FrameProfiler::STAGE_COUNT && bottom > ceiling; ++i) {
+			const float top = std::max(ceiling, bottom - frame.stages[i] * pixels_per_ms * scale);
+			const uint32_t color = FrameProfiler::getStageColor(static_cast<FrameProfiler::Stage>(i));
+			glColor4ub((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+			glVertex2f(bar_x, top);
+			glVertex2f(bar_x + scale, top);
+			glVertex2f(bar_x + scale, bottom);
+			glVertex2f(bar_x, bottom);
+			bottom = top;
+		}
+		bar_x += scale;
+	}
+	glEnd();
+
+	const float target = base - 16.7f * pixels_per_ms * scale;
+	glColor4ub(255, 255, 255, 128);
+	glBegin(GL_LINES);
+	glVertex2f(x + 4.0f * scale, target);
+	glVertex2f(x + width - 4.0f * scale, target);
+	glEnd();
+
+	glEnable(GL_TEXTURE_2D);
+	glColor4ub(255, 255, 255, 255);
+	text_renderer->draw(layout, x + 4.0f * scale, y + 4.0f * scale, scale);
+}
+
 void MapDrawer::MakeTooltip(int screenx, int screeny, const std::string& text, uint8_t r, uint8_t g, uint8_t b) {
 	if (text.empty()) {
 		return;
@@ -1909,13 +2257,14 @@ void MapDrawer::TakeScreenshot(uint8_t* screenshot_buffer) {
 	glPixelStorei(GL_PACK_ALIGNMENT, 1); // 1 byte alignment
 
 	for (int i = 0; i < screensize_y; ++i) {
-		glReadPixels(0, screensize_y - i, screensize_x, 1, GL_RGB, GL_UNSIGNED_BYTE, (GLubyte*)(screenshot_buffer) + 3 * screensize_x * i);
+		glReadPixels(0, screensize_y - 1 - i, screensize_x, 1, GL_RGB, GL_UNSIGNED_BYTE, (GLubyte*)(screenshot_buffer) + 3 * screensize_x * i);
 	}
 }
 
 void MapDrawer::glBlitTexture(int sx, int sy, int texture_number, int red, int green, int blue, int alpha) {
 	if (texture_number != 0) {
 		glBindTexture(GL_TEXTURE_2D, texture_number);
+		g_profiler.count(FrameProfiler::COUNTER_TEXTURE_BINDS);
 		glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 		glBegin(GL_QUADS);
 		glTexCoord2f(0.f, 0.f);
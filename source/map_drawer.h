@@ -19,6 +19,7 @@
 #define RME_MAP_DRAWER_H_
 
 class GameSprite;
+class Animator;
 
 struct MapTooltip {
 	enum TextLength {
@@ -27,9 +28,7 @@ struct MapTooltip {
 	};
 
 	MapTooltip(int x, int y, std::string text, uint8_t r, uint8_t g, uint8_t b) :
-		x(x), y(y), text(text), r(r), g(g), b(b) {
-		ellipsis = (text.length() - 3) > MAX_CHARS;
-	}
+		x(x), y(y), text(text), r(r), g(g), b(b) { }
 
 	void checkLineEnding() {
 		if (text.at(text.size() - 1) == '\n') {
@@ -40,7 +39,6 @@ struct MapTooltip {
 	int x, y;
 	std::string text;
 	uint8_t r, g, b;
-	bool ellipsis;
 };
 
 // Storage during drawing, for option caching
@@ -85,16 +83,23 @@ struct DrawingOptions {
 	bool extended_house_shader;
 
 	bool experimental_fog;
+
+	int lod_zoom_threshold;
+	bool show_profiler;
 };
 
 class MapCanvas;
 class LightDrawer;
+class LodDrawer;
+class TextRenderer;
 
 class MapDrawer {
 	MapCanvas* canvas;
 	Editor& editor;
 	DrawingOptions options;
 	std::shared_ptr<LightDrawer> light_drawer;
+	std::shared_ptr<LodDrawer> lod_drawer;
+	std::shared_ptr<TextRenderer> text_renderer;
 
 	float zoom;
 
@@ -108,6 +113,42 @@ class MapDrawer {
 	int tile_size;
 	int floor;
 
+	// Topmost floor with full ground covering each screen cell, rebuilt every frame
+	std::vector<uint8_t> occlusion_mask;
+	int occlusion_x, occlusion_y;
+	int occlusion_width, occlusion_height;
+
+	// Area whose sprites were last queued for loading
+	int prefetch_start_x, prefetch_start_y;
+	int prefetch_end_x, prefetch_end_y;
+	int prefetch_floor;
+
+	// Animators of the sprites in the last drawn map and the frame they were drawn with,
+	// the view only has to repaint for animations while one of them moves on
+	std::unordered_map<Animator*, int> animators;
+
+	// Background, map and light of the last full frame, copied from the back buffer
+	// so frames where only the overlays changed don't draw the map again
+	struct MapLayer {
+		GLuint texture = 0;
+		int texture_width = 0;
+		int texture_height = 0;
+		bool valid = false;
+
+		// View it was drawn for
+		int scroll_x = 0, scroll_y = 0;
+		int width = 0, height = 0;
+		int floor = 0;
+		float zoom = 0.f;
+		uint64_t revision = 0;
+		Brush* brush = nullptr;
+		bool preview = false;
+
+		// Tile range after drawing the map, the overlays are drawn over it
+		int start_x = 0, start_y = 0;
+		int end_x = 0, end_y = 0;
+	} map_layer;
+
 protected:
 	std::vector<MapTooltip*> tooltips;
 	std::ostringstream tooltip;
@@ -120,10 +161,14 @@ public:
 	bool dragging_draw;
 
 	void SetupVars();
+	// Draws the given map area instead of the canvas view, scroll in map pixels and size in screen pixels
+	void SetupRegion(int scroll_x, int scroll_y, int width, int height, int floor, float zoom);
 	void SetupGL();
 	void Release();
 
-	void Draw();
+	void Draw(bool reuse_map_layer = false);
+	// Only the map, without the cursor, brush and other overlays
+	void DrawRegion();
 	void DrawBackground();
 	void DrawMap();
 	void DrawDraggingShadow();
@@ -135,6 +180,7 @@ public:
 	void DrawGrid();
 	void DrawTooltips();
 	void DrawLight();
+	void DrawProfiler();
 
 	void TakeScreenshot(uint8_t* screenshot_buffer);
 
@@ -142,6 +188,11 @@ public:
 		return options;
 	}
 
+	bool HasAnimations() const noexcept {
+		return !animators.empty();
+	}
+	bool HasAnimationChanged() const;
+
 protected:
 	void BlitItem(int& screenx, int& screeny, const Tile* tile, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void BlitItem(int& screenx, int& screeny, const Position& pos, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255, const Tile* tile = nullptr);
@@ -151,13 +202,22 @@ protected:
 	void BlitCreature(int screenx, int screeny, const Outfit& outfit, Direction dir, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void BlitSquare(int sx, int sy, int red, int green, int blue, int alpha, int size = 0);
 	void DrawRawBrush(int screenx, int screeny, ItemType* itemType, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha);
+	void SetupView(float zoom, int floor);
 	void DrawTile(TileLocation* tile);
+	void AnimateItem(Item* item);
+	void BuildOcclusionMask();
+	bool IsOccluded(int map_x, int map_y, int map_z) const;
 	void DrawBrushIndicator(int x, int y, Brush* brush, uint8_t r, uint8_t g, uint8_t b);
 	void DrawHookIndicator(int x, int y, const ItemType& type);
 	void WriteTooltip(Item* item, std::ostringstream& stream, bool isHouseTile = false);
 	void WriteTooltip(Waypoint* item, std::ostringstream& stream);
 	void MakeTooltip(int screenx, int screeny, const std::string& text, uint8_t r = 255, uint8_t g = 255, uint8_t b = 255);
 	void AddLight(TileLocation* location);
+	void PrefetchSprites();
+	void ClearTooltips();
+	bool CanReuseMapLayer() const;
+	void StoreMapLayer();
+	void DrawMapLayer();
 
 	enum BrushColor {
 		COLOR_BRUSH,
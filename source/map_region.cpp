@@ -68,6 +68,7 @@ Floor::Floor(int sx, int sy, int z) {
 QTreeNode::QTreeNode(BaseMap& map) :
 	map(map),
 	visible(0),
+	revision(0),
 	isLeaf(false) {
 	// Doesn't matter if we're leaf or node
 	for (int i = 0; i < MAP_LAYERS; ++i) {
@@ -107,6 +108,33 @@ QTreeNode* QTreeNode::getLeaf(int x, int y) {
 	return nullptr;
 }
 
+QTreeNode* QTreeNode::getNode(int x, int y, int depth) {
+	QTreeNode* node = this;
+	uint32_t cx = x, cy = y;
+	while (node && depth > 0 && !node->isLeaf) {
+		uint32_t index = ((cx & 0xC000) >> 14) | ((cy & 0xC000) >> 12);
+		node = node->child[index];
+		cx <<= 2;
+		cy <<= 2;
+		--depth;
+	}
+	return node;
+}
+
+uint64_t QTreeNode::getRevision() const {
+	if (isLeaf) {
+		return revision;
+	}
+
+	uint64_t sum = 0;
+	for (int i = 0; i < MAP_LAYERS; ++i) {
+		if (child[i]) {
+			sum += child[i]->getRevision();
+		}
+	}
+	return sum;
+}
+
 QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 	QTreeNode* node = this;
 	uint32_t cx = x, cy = y;
@@ -236,6 +264,9 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
 
+	++revision;
+	++map.revision;
+
 	if (newtile && !oldtile) {
 		++map.tilecount;
 	} else if (oldtile && !newtile) {
@@ -245,6 +276,29 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	return oldtile;
 }
 
+void QTreeNode::swapTiles(int x, int y, int z, uint16_t mask, Tile** tiles) {
+	ASSERT(isLeaf);
+	Floor* f = createFloor(x, y, z);
+
+	for (int i = 0; i < 16; ++i) {
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+
+		Tile* oldtile = f->locs[i].tile;
+		f->locs[i].tile = tiles[i];
+		if (tiles[i] && !oldtile) {
+			++map.tilecount;
+		} else if (oldtile && !tiles[i]) {
+			--map.tilecount;
+		}
+		tiles[i] = oldtile;
+	}
+
+	++revision;
+	++map.revision;
+}
+
 void QTreeNode::clearTile(int x, int y, int z) {
 	ASSERT(isLeaf);
 	Floor* f = createFloor(x, y, z);
@@ -255,4 +309,7 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
 	delete tmp->tile;
 	tmp->tile = map.allocator(tmp);
+
+	++revision;
+	++map.revision;
 }
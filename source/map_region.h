@@ -127,11 +127,17 @@ public:
 
 	QTreeNode* getLeaf(int x, int y); // Might return nullptr
 	QTreeNode* getLeafForce(int x, int y); // Will never return nullptr, it will create the node if it's not there
+	QTreeNode* getNode(int x, int y, int depth); // Node "depth" levels down (or the leaf above it), might return nullptr
+
+	// Increased every time a tile of this leaf is replaced, inner nodes return the sum of their leaves
+	uint64_t getRevision() const;
 
 	// Coordinates are NOT relative
 	TileLocation* createTile(int x, int y, int z);
 	TileLocation* getTile(int x, int y, int z);
 	Tile* setTile(int x, int y, int z, Tile* tile);
+	// Swaps the tiles of the floor at the offsets in mask with tiles[offset]
+	void swapTiles(int x, int y, int z, uint16_t mask, Tile** tiles);
 	void clearTile(int x, int y, int z);
 
 	Floor* createFloor(int x, int y, int z);
@@ -155,6 +161,7 @@ public:
 protected:
 	BaseMap& map;
 	uint32_t visible;
+	uint32_t revision;
 
 	bool isLeaf;
 	union {
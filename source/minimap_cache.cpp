@@ -0,0 +1,365 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "minimap_cache.h"
+
+#include "map.h"
+#include "map_region.h"
+#include "tile.h"
+#include "graphics.h"
+#include "filehandle.h"
+
+#include <zlib.h>
+#include <wx/stopwatch.h>
+#include <set>
+
+namespace {
+	const uint32_t CacheVersion = 1;
+
+	// The most common of four colors, black only if all are black, so thin
+	// walls and paths stay visible when zoomed out
+	uint8_t pickColor(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+		const uint8_t colors[4] = { a, b, c, d };
+		uint8_t best = 0;
+		int best_count = 0;
+		for (int i = 0; i < 4; ++i) {
+			if (colors[i] == 0) {
+				continue;
+			}
+			int count = 0;
+			for (int j = 0; j < 4; ++j) {
+				count += colors[j] == colors[i];
+			}
+			if (count > best_count) {
+				best = colors[i];
+				best_count = count;
+			}
+		}
+		return best;
+	}
+}
+
+MinimapCache::MinimapCache(Map& map) :
+	map(map),
+	frame(0),
+	bitmaps(0),
+	queued(false) {
+	////
+}
+
+MinimapCache::~MinimapCache() {
+	////
+}
+
+const wxBitmap* MinimapCache::getBitmap(int block_x, int block_y, int floor, int zoom) {
+	Block& block = getBlock(block_x, block_y, floor, zoom);
+	if (block.colors.empty()) {
+		return nullptr;
+	}
+
+	if (!block.bitmap.IsOk()) {
+		wxImage image(BlockSize, BlockSize, false);
+		uint8_t* pixels = image.GetData();
+		for (int i = 0; i < BlockSize * BlockSize; ++i) {
+			const RGBQuad& color = minimap_color[block.colors[i]];
+			pixels[i * 3 + 0] = color.red;
+			pixels[i * 3 + 1] = color.green;
+			pixels[i * 3 + 2] = color.blue;
+		}
+		block.bitmap = wxBitmap(image);
+		++bitmaps;
+	}
+	block.lastframe = frame;
+	return &block.bitmap;
+}
+
+void MinimapCache::finishFrame() {
+	if (bitmaps > MaxBitmaps) {
+		for (auto& it : blocks) {
+			Block& block = it.second;
+			if (block.bitmap.IsOk() && block.lastframe != frame) {
+				block.bitmap = wxBitmap();
+				--bitmaps;
+			}
+		}
+	}
+	++frame;
+}
+
+void MinimapCache::invalidate(const Position& position) {
+	if (position.x < 0 || position.y < 0 || position.z < 0 || position.z > MAP_MAX_LAYER) {
+		return;
+	}
+
+	for (int zoom = 0; zoom <= MaxZoom; ++zoom) {
+		auto it = blocks.find(makeKey(position.x / (BlockSize << zoom), position.y / (BlockSize << zoom), position.z, zoom));
+		// Zoomed out blocks are only built after the blocks they are made from
+		if (it == blocks.end() || !it->second.built) {
+			break;
+		}
+
+		Block& block = it->second;
+		block.built = false;
+		if (block.bitmap.IsOk()) {
+			block.bitmap = wxBitmap();
+			--bitmaps;
+		}
+		pending.push_back(it->first);
+	}
+}
+
+void MinimapCache::clear() {
+	blocks.clear();
+	pending.clear();
+	bitmaps = 0;
+	queued = false;
+}
+
+bool MinimapCache::buildSome(int max_time) {
+	if (!queued) {
+		queueBlocks();
+		queued = true;
+	}
+
+	wxStopWatch watch;
+	while (!pending.empty() && watch.Time() < max_time) {
+		const uint64_t key = pending.front();
+		pending.pop_front();
+		getBlock(int(key >> 32), int((key >> 8) & 0xFFFFFF), int((key >> 4) & 0xF), int(key & 0xF));
+	}
+	return !pending.empty();
+}
+
+MinimapCache::Block& MinimapCache::getBlock(int block_x, int block_y, int floor, int zoom) {
+	Block& block = blocks[makeKey(block_x, block_y, floor, zoom)];
+	if (!block.built) {
+		buildBlock(block, block_x, block_y, floor, zoom);
+	}
+	return block;
+}
+
+void MinimapCache::buildBlock(Block& block, int block_x, int block_y, int floor, int zoom) {
+	block.built = true;
+	block.colors.clear();
+	if (block.bitmap.IsOk()) {
+		block.bitmap = wxBitmap();
+		--bitmaps;
+	}
+
+	std::vector<uint8_t> colors(BlockSize * BlockSize, 0);
+	bool empty = true;
+
+	if (zoom == 0) {
+		const int start_x = block_x * BlockSize;
+		const int start_y = block_y * BlockSize;
+		if (!map.getNode(start_x, start_y, BlockDepth)) {
+			return;
+		}
+
+		// Blocks start on a leaf, so the tiles are read a leaf (4x4 tiles) at a time
+		for (int nd_y = 0; nd_y < BlockSize; nd_y += 4) {
+			for (int nd_x = 0; nd_x < BlockSize; nd_x += 4) {
+				QTreeNode* node = map.getLeaf(start_x + nd_x, start_y + nd_y);
+				if (!node) {
+					continue;
+				}
+
+				for (int y = 0; y < 4; ++y) {
+					for (int x = 0; x < 4; ++x) {
+						TileLocation* location = node->getTile(x, y, floor);
+						const Tile* tile = location ? location->get() : nullptr;
+						if (!tile) {
+							continue;
+						}
+
+						const uint8_t color = tile->getMiniMapColor();
+						if (color != 0 && color != 255) {
+							colors[(nd_y + y) * BlockSize + nd_x + x] = color;
+							empty = false;
+						}
+					}
+				}
+			}
+		}
+	} else {
+		// Each of the four blocks of the level above fills a quarter
+		const int half = BlockSize / 2;
+		for (int part = 0; part < 4; ++part) {
+			const Block& child = getBlock(block_x * 2 + (part & 1), block_y * 2 + (part >> 1), floor, zoom - 1);
+			if (child.colors.empty()) {
+				continue;
+			}
+			empty = false;
+
+			for (int y = 0; y < half; ++y) {
+				const uint8_t* top = &child.colors[y * 2 * BlockSize];
+				const uint8_t* bottom = top + BlockSize;
+				uint8_t* target = &colors[(y + (part >> 1) * half) * BlockSize + (part & 1) * half];
+				for (int x = 0; x < half; ++x) {
+					target[x] = pickColor(top[x * 2], top[x * 2 + 1], bottom[x * 2], bottom[x * 2 + 1]);
+				}
+			}
+		}
+	}
+
+	if (!empty) {
+		block.colors.swap(colors);
+	}
+}
+
+void MinimapCache::queueBlocks() {
+	pending.clear();
+
+	// The parts of the map that have tiles, ground floor first
+	std::vector<std::pair<int, int>> used;
+	const int blocks_x = (map.getWidth() + BlockSize - 1) / BlockSize;
+	const int blocks_y = (map.getHeight() + BlockSize - 1) / BlockSize;
+	for (int block_x = 0; block_x < blocks_x; ++block_x) {
+		for (int block_y = 0; block_y < blocks_y; ++block_y) {
+			if (map.getNode(block_x * BlockSize, block_y * BlockSize, BlockDepth)) {
+				used.emplace_back(block_x, block_y);
+			}
+		}
+	}
+
+	static const int floors[MAP_LAYERS] = { 7, 6, 5, 4, 3, 2, 1, 0, 8, 9, 10, 11, 12, 13, 14, 15 };
+	for (int zoom = 0; zoom <= MaxZoom; ++zoom) {
+		std::set<std::pair<int, int>> zoomed;
+		for (const auto& block : used) {
+			zoomed.emplace(block.first >> zoom, block.second >> zoom);
+		}
+		for (int floor : floors) {
+			for (const auto& block : zoomed) {
+				pending.push_back(makeKey(block.first, block.second, floor, zoom));
+			}
+		}
+	}
+}
+
+FileName MinimapCache::getCacheFileName(const FileName& mapfile) {
+	FileName filename(mapfile);
+	filename.SetFullName(mapfile.GetName() + "-minimap.cache");
+	return filename;
+}
+
+bool MinimapCache::load(const FileName& mapfile) {
+	const FileName filename = getCacheFileName(mapfile);
+	if (!filename.FileExists() || !mapfile.FileExists()) {
+		return false;
+	}
+
+	FileReadHandle fh(nstr(filename.GetFullPath()));
+	if (!fh.isOk()) {
+		return false;
+	}
+
+	// Only valid for the map file it was saved with
+	std::string magic;
+	uint32_t version, size_low, size_high, time_low, time_high, count;
+	if (!fh.getRAW(magic, 4) || magic != "RMMC" || !fh.getU32(version) || version != CacheVersion) {
+		return false;
+	}
+	const uint64_t map_size = mapfile.GetSize().GetValue();
+	const uint64_t map_time = uint64_t(mapfile.GetModificationTime().GetTicks());
+	if (!fh.getU32(size_low) || !fh.getU32(size_high) || !fh.getU32(time_low) || !fh.getU32(time_high)) {
+		return false;
+	}
+	if ((uint64_t(size_high) << 32 | size_low) != map_size || (uint64_t(time_high) << 32 | time_low) != map_time) {
+		return false;
+	}
+
+	if (!fh.getU32(count)) {
+		return false;
+	}
+
+	std::vector<uint8_t> compressed;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint8_t floor;
+		uint16_t block_x, block_y;
+		uint32_t compressed_size;
+		if (!fh.getU8(floor) || !fh.getU16(block_x) || !fh.getU16(block_y) || !fh.getU32(compressed_size) || floor > MAP_MAX_LAYER || compressed_size > compressBound(BlockSize * BlockSize)) {
+			clear();
+			return false;
+		}
+
+		compressed.resize(compressed_size);
+		std::vector<uint8_t> colors(BlockSize * BlockSize);
+		uLongf colors_size = colors.size();
+		if (!fh.getRAW(compressed.data(), compressed_size) || uncompress(colors.data(), &colors_size, compressed.data(), compressed_size) != Z_OK || colors_size != colors.size()) {
+			clear();
+			return false;
+		}
+
+		Block& block = blocks[makeKey(block_x, block_y, floor, 0)];
+		block.colors.swap(colors);
+		block.built = true;
+	}
+	return true;
+}
+
+bool MinimapCache::save(const FileName& mapfile) {
+	// Only the 1:1 blocks built so far, saving must not wait for the others.
+	// The ones missing in the file are built again after it is loaded.
+	std::vector<uint64_t> keys;
+	for (const auto& entry : blocks) {
+		const uint64_t key = entry.first;
+		if ((key & 0xF) == 0 && entry.second.built && !entry.second.colors.empty()) {
+			keys.push_back(key);
+		}
+	}
+
+	const FileName filename = getCacheFileName(mapfile);
+	FileWriteHandle fh(nstr(filename.GetFullPath()));
+	if (!fh.isOk()) {
+		return false;
+	}
+
+	const uint64_t map_size = mapfile.GetSize().GetValue();
+	const uint64_t map_time = uint64_t(mapfile.GetModificationTime().GetTicks());
+	fh.addRAW("RMMC");
+	fh.addU32(CacheVersion);
+	fh.addU32(uint32_t(map_size));
+	fh.addU32(uint32_t(map_size >> 32));
+	fh.addU32(uint32_t(map_time));
+	fh.addU32(uint32_t(map_time >> 32));
+	fh.addU32(uint32_t(keys.size()));
+
+	std::vector<uint8_t> compressed(compressBound(BlockSize * BlockSize));
+	for (uint64_t key : keys) {
+		const Block& block = blocks[key];
+		uLongf compressed_size = compressed.size();
+		if (compress2(compressed.data(), &compressed_size, block.colors.data(), block.colors.size(), Z_BEST_SPEED) != Z_OK) {
+			fh.close();
+			wxRemoveFile(filename.GetFullPath());
+			return false;
+		}
+
+		fh.addU8(uint8_t((key >> 4) & 0xF));
+		fh.addU16(uint16_t(key >> 32));
+		fh.addU16(uint16_t((key >> 8) & 0xFFFFFF));
+		fh.addU32(uint32_t(compressed_size));
+		fh.addRAW(compressed.data(), compressed_size);
+	}
+
+	if (!fh.isOk()) {
+		fh.close();
+		wxRemoveFile(filename.GetFullPath());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_CACHE_H_
+#define RME_MINIMAP_CACHE_H_
+
+#include "position.h"
+
+#include <deque>
+#include <unordered_map>
+
+class Map;
+
+// The minimap colors of every floor at 1:1 and at the zoom levels below it
+// (1:2, 1:4, ...), in blocks of 256x256 pixels. A zoomed out block is made
+// from the four blocks of the level above it. Blocks are built when they are
+// first drawn or in idle time, and built again after Actions change a tile on
+// them. The built 1:1 blocks can be saved next to the map file, so the minimap of a
+// map that is opened again does not have to be built from the tiles. Code that
+// changes the map without Actions has to clear the cache.
+class MinimapCache {
+public:
+	explicit MinimapCache(Map& map);
+	~MinimapCache();
+
+	MinimapCache(const MinimapCache&) = delete;
+	MinimapCache& operator=(const MinimapCache&) = delete;
+
+	// Bitmap of a block at a zoom level (0 for 1:1, 1 for 1:2 ...), where the block
+	// coordinates count blocks of that level. nullptr if there is nothing on it.
+	const wxBitmap* getBitmap(int block_x, int block_y, int floor, int zoom);
+	// Frees the bitmaps that were not drawn since the last call, once there are too many
+	void finishFrame();
+
+	// Marks the blocks of all zoom levels holding the position as out of date
+	void invalidate(const Position& position);
+	void clear();
+
+	// Builds missing and out of date blocks for about max_time milliseconds,
+	// returns true if there are still some left
+	bool buildSome(int max_time);
+
+	bool load(const FileName& mapfile);
+	bool save(const FileName& mapfile);
+
+	static const int BlockSize = 256;
+	static const int BlockDepth = 4; // Depth of the 256x256 tiles nodes in the map tree
+	static const int MaxZoom = 4;
+	static const int MaxBitmaps = 128;
+
+private:
+	struct Block {
+		std::vector<uint8_t> colors; // Palette indices, empty if there is nothing on the block
+		wxBitmap bitmap;
+		int lastframe = 0;
+		bool built = false;
+	};
+
+	Block& getBlock(int block_x, int block_y, int floor, int zoom);
+	void buildBlock(Block& block, int block_x, int block_y, int floor, int zoom);
+	void queueBlocks();
+
+	static FileName getCacheFileName(const FileName& mapfile);
+	static uint64_t makeKey(int block_x, int block_y, int floor, int zoom) {
+		return (uint64_t(block_x) << 32) | (uint64_t(block_y) << 8) | uint64_t(floor << 4) | uint64_t(zoom);
+	}
+
+	Map& map;
+	std::unordered_map<uint64_t, Block> blocks;
+	int frame;
+	int bitmaps;
+
+	// Blocks waiting to be built in idle time
+	std::deque<uint64_t> pending;
+	bool queued;
+};
+
+#endif
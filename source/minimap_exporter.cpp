@@ -0,0 +1,369 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "minimap_exporter.h"
+
+#include "map.h"
+#include "map_region.h"
+#include "tile.h"
+#include "graphics.h"
+#include "filehandle.h"
+#include "png_writer.h"
+
+#include <condition_variable>
+#include <thread>
+
+namespace {
+	// Depth of the 256x256 tiles nodes in the map tree
+	const int NodeDepth = 4;
+	const int NodeSize = 256;
+}
+
+MinimapExporter::MinimapExporter(Map& map, Format format) :
+	map(map),
+	format(format),
+	selection_only(false),
+	cancelled(false),
+	rows_done(0),
+	images_written(0) {
+	for (Area& area : areas) {
+		area = Area { 0, 0, 0, 0 };
+	}
+}
+
+MinimapExporter::~MinimapExporter() {
+	////
+}
+
+bool MinimapExporter::run(const FileName& directory, const std::string& name, int first_floor, int last_floor, const std::function<bool(int64_t, int64_t)>& progress) {
+	findAreas(first_floor, last_floor);
+
+	std::vector<int> floors;
+	int64_t rows_total = 0;
+	for (int floor = first_floor; floor <= last_floor; ++floor) {
+		if (areas[floor].width > 0) {
+			floors.push_back(floor);
+			rows_total += areas[floor].height;
+		}
+	}
+
+	std::vector<std::string> filenames;
+	for (int floor : floors) {
+		FileName file(wxstr(name) + "_" + i2ws(floor) + (format == FORMAT_BMP ? ".bmp" : ".png"));
+		file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
+		filenames.push_back(nstr(file.GetFullPath()));
+	}
+
+	// One floor per thread, the map is only read
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> done(0);
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	auto work = [&]() {
+		for (size_t index = next++; index < floors.size() && !cancelled; index = next++) {
+			if (exportFloor(floors[index], filenames[index])) {
+				++images_written;
+			}
+			if (++done == floors.size()) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	};
+
+	const int threads = std::max<int>(1, std::min<int>(std::thread::hardware_concurrency(), floors.size()));
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i) {
+		workers.emplace_back(work);
+	}
+
+	// This thread only reports the progress, so the dialog stays responsive
+	while (done < floors.size() && !cancelled) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait_for(lock, std::chrono::milliseconds(100), [&]() { return done >= floors.size(); });
+		}
+		if (progress && !progress(std::min<int64_t>(rows_done, rows_total), rows_total)) {
+			cancelled = true;
+		}
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	return !cancelled;
+}
+
+void MinimapExporter::findAreas(int first_floor, int last_floor) {
+	int min_x[MAP_LAYERS], min_y[MAP_LAYERS], max_x[MAP_LAYERS], max_y[MAP_LAYERS];
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		min_x[z] = min_y[z] = 0x10000;
+		max_x[z] = max_y[z] = -1;
+	}
+
+	// A single walk over the leaves finds the used part of every floor
+	for (int node_x = 0; node_x < map.getWidth(); node_x += NodeSize) {
+		for (int node_y = 0; node_y < map.getHeight(); node_y += NodeSize) {
+			if (!map.getNode(node_x, node_y, NodeDepth)) {
+				continue;
+			}
+
+			for (int nd_x = node_x; nd_x < node_x + NodeSize; nd_x += 4) {
+				for (int nd_y = node_y; nd_y < node_y + NodeSize; nd_y += 4) {
+					QTreeNode* node = map.getLeaf(nd_x, nd_y);
+					if (!node) {
+						continue;
+					}
+
+					for (int z = first_floor; z <= last_floor; ++z) {
+						if (!node->getFloor(z)) {
+							continue;
+						}
+
+						for (int x = 0; x < 4; ++x) {
+							for (int y = 0; y < 4; ++y) {
+								const Tile* tile = node->getTile(x, y, z)->get();
+								if (!tile || tile->empty() || (selection_only && !tile->isSelected())) {
+									continue;
+								}
+								min_x[z] = std::min(min_x[z], nd_x + x);
+								min_y[z] = std::min(min_y[z], nd_y + y);
+								max_x[z] = std::max(max_x[z], nd_x + x);
+								max_y[z] = std::max(max_y[z], nd_y + y);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (selection_only) {
+		// The floors line up when the selection spans several of them
+		for (int z = first_floor; z <= last_floor; ++z) {
+			if (max_x[z] < 0) {
+				continue;
+			}
+			for (int other = first_floor; other <= last_floor; ++other) {
+				if (max_x[other] < 0) {
+					continue;
+				}
+				min_x[z] = std::min(min_x[z], min_x[other]);
+				min_y[z] = std::min(min_y[z], min_y[other]);
+				max_x[z] = std::max(max_x[z], max_x[other]);
+				max_y[z] = std::max(max_y[z], max_y[other]);
+			}
+		}
+	}
+
+	for (int z = first_floor; z <= last_floor; ++z) {
+		if (max_x[z] < 0) {
+			areas[z] = Area { 0, 0, 0, 0 };
+			continue;
+		}
+
+		if (!selection_only) {
+			min_x[z] = std::max(0, min_x[z] - Padding);
+			min_y[z] = std::max(0, min_y[z] - Padding);
+			max_x[z] = std::min(MAP_MAX_WIDTH, max_x[z] + Padding);
+			max_y[z] = std::min(MAP_MAX_HEIGHT, max_y[z] + Padding);
+		}
+		areas[z] = Area { min_x[z], min_y[z], max_x[z] - min_x[z] + 1, max_y[z] - min_y[z] + 1 };
+	}
+}
+
+bool MinimapExporter::exportFloor(int floor, const std::string& filename) {
+	try {
+		if (format == FORMAT_BMP) {
+			return writeBMP(floor, areas[floor], filename);
+		}
+		return writePNG(floor, areas[floor], filename);
+	} catch (std::bad_alloc&) {
+		setError("There is not enough memory available to complete the operation.");
+		return false;
+	}
+}
+
+bool MinimapExporter::writeBMP(int floor, const Area& area, const std::string& filename) {
+	// Bitmap width must be divisible by four
+	const int stride = (area.width + 3) / 4 * 4;
+	const uint64_t file_size = 14 // header
+		+ 40 // image data header
+		+ 256 * 4 // color palette
+		+ uint64_t(stride) * area.height; // pixels
+	if (file_size > 0xFFFFFFFFull) {
+		setError("Floor " + i2s(floor) + " is too large for a BMP file, export it as PNG instead.");
+		return false;
+	}
+
+	bool written;
+	{
+		FileWriteHandle fh(filename);
+		if (!fh.isOpen()) {
+			setError("Could not open file \"" + filename + "\" for writing.");
+			return false;
+		}
+
+		// Store the magic number
+		fh.addRAW("BM");
+		fh.addU32(uint32_t(file_size));
+
+		// Two values reserved, must always be 0.
+		fh.addU16(0);
+		fh.addU16(0);
+
+		// Bitmapdata offset
+		fh.addU32(14 + 40 + 256 * 4);
+
+		// Header size
+		fh.addU32(40);
+
+		// Header width/height
+		fh.addU32(area.width);
+		fh.addU32(area.height);
+
+		// Color planes
+		fh.addU16(1);
+
+		// bits per pixel, OT map format is 8
+		fh.addU16(8);
+
+		// compression type, 0 is no compression
+		fh.addU32(0);
+
+		// image size, 0 is valid if we use no compression
+		fh.addU32(0);
+
+		// horizontal/vertical resolution in pixels / meter
+		fh.addU32(4000);
+		fh.addU32(4000);
+
+		// Number of colors
+		fh.addU32(256);
+		// Important colors, 0 is all
+		fh.addU32(0);
+
+		// Write the color palette
+		for (int i = 0; i < 256; ++i) {
+			fh.addU32(uint32_t(minimap_color[i]));
+		}
+
+		// Bitmap rows are saved in reverse order, so the bands go from the bottom up
+		std::vector<uint8_t> colors(size_t(stride) * BandHeight, 0);
+		const int last_band = (area.height - 1) / BandHeight * BandHeight;
+		for (int band = last_band; band >= 0 && !cancelled; band -= BandHeight) {
+			const int rows = std::min(BandHeight, area.height - band);
+			fillRows(floor, area, band, rows, colors.data());
+			for (int y = rows - 1; y >= 0; --y) {
+				// The padding past the width is never written to, it stays 0
+				fh.addRAW(&colors[size_t(y) * stride], stride);
+			}
+			rows_done += rows;
+		}
+		written = fh.isOk();
+	}
+
+	if (!written || cancelled) {
+		wxRemoveFile(wxstr(filename));
+		if (!written) {
+			setError("Could not write file \"" + filename + "\".");
+		}
+		return false;
+	}
+	return true;
+}
+
+bool MinimapExporter::writePNG(int floor, const Area& area, const std::string& filename) {
+	PNGWriter png;
+	if (!png.open(filename, area.width, area.height)) {
+		setError(png.getError());
+		return false;
+	}
+
+	std::vector<uint8_t> colors(size_t(area.width) * BandHeight);
+	std::vector<uint8_t> rgb(size_t(area.width) * 3);
+
+	bool written = true;
+	for (int band = 0; band < area.height && written && !cancelled; band += BandHeight) {
+		const int rows = std::min(BandHeight, area.height - band);
+		fillRows(floor, area, band, rows, colors.data());
+		for (int y = 0; y < rows && written; ++y) {
+			const uint8_t* row = &colors[size_t(y) * area.width];
+			for (int x = 0; x < area.width; ++x) {
+				const RGBQuad& color = minimap_color[row[x]];
+				rgb[x * 3 + 0] = color.red;
+				rgb[x * 3 + 1] = color.green;
+				rgb[x * 3 + 2] = color.blue;
+			}
+			written = png.writeRow(rgb.data());
+		}
+		rows_done += rows;
+	}
+
+	if (!written || cancelled || !png.close()) {
+		png.close();
+		wxRemoveFile(wxstr(filename));
+		if (!cancelled) {
+			setError(png.getError());
+		}
+		return false;
+	}
+	return true;
+}
+
+void MinimapExporter::fillRows(int floor, const Area& area, int first_row, int rows, uint8_t* colors) const {
+	// BMP rows are padded to four bytes, the padding is left alone
+	const int stride = format == FORMAT_BMP ? (area.width + 3) / 4 * 4 : area.width;
+	for (int y = 0; y < rows; ++y) {
+		memset(colors + size_t(y) * stride, 0, area.width);
+	}
+
+	const int start_x = area.x;
+	const int start_y = area.y + first_row;
+	const int end_x = area.x + area.width;
+	const int end_y = start_y + rows;
+
+	for (int nd_y = start_y & ~3; nd_y < end_y; nd_y += 4) {
+		for (int nd_x = start_x & ~3; nd_x < end_x; nd_x += 4) {
+			QTreeNode* node = map.getLeaf(nd_x, nd_y);
+			if (!node || !node->getFloor(floor)) {
+				continue;
+			}
+
+			for (int y = std::max(nd_y, start_y); y < std::min(nd_y + 4, end_y); ++y) {
+				uint8_t* row = colors + size_t(y - start_y) * stride;
+				for (int x = std::max(nd_x, start_x); x < std::min(nd_x + 4, end_x); ++x) {
+					const Tile* tile = node->getTile(x, y, floor)->get();
+					if (!tile || tile->empty() || (selection_only && !tile->isSelected())) {
+						continue;
+					}
+					row[x - start_x] = tile->getMiniMapColor();
+				}
+			}
+		}
+	}
+}
+
+void MinimapExporter::setError(const std::string& message) {
+	std::lock_guard<std::mutex> lock(error_mutex);
+	if (error.empty()) {
+		error = message;
+	}
+	cancelled = true;
+}
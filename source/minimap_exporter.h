@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_EXPORTER_H_
+#define RME_MINIMAP_EXPORTER_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+class Map;
+
+// Writes the minimap of a range of floors, one image per floor named
+// <name>_<floor>.bmp or .png. The floors are exported at the same time on
+// their own threads. Images are written a band of rows at a time, so there
+// is no limit on their size besides what the file format allows.
+class MinimapExporter {
+public:
+	enum Format {
+		FORMAT_BMP, // 8 bit with the minimap palette, as the client minimap
+		FORMAT_PNG,
+	};
+
+	MinimapExporter(Map& map, Format format);
+	~MinimapExporter();
+
+	MinimapExporter(const MinimapExporter&) = delete;
+	MinimapExporter& operator=(const MinimapExporter&) = delete;
+
+	// Only exports the selected tiles, all floors get the size of the selection
+	void setSelectionOnly(bool selection_only) {
+		this->selection_only = selection_only;
+	}
+
+	// progress is called on the calling thread every now and then, returning
+	// false cancels the export. The map must not be changed while this runs.
+	bool run(const FileName& directory, const std::string& name, int first_floor, int last_floor, const std::function<bool(int64_t done, int64_t total)>& progress);
+
+	int getImagesWritten() const {
+		return images_written;
+	}
+	// Empty if the export was cancelled
+	const std::string& getError() const {
+		return error;
+	}
+
+	// Empty tiles around the used part of a floor
+	static const int Padding = 10;
+	// Rows read from the map at once, a multiple of the leaf size
+	static const int BandHeight = 256;
+
+private:
+	struct Area {
+		int x, y;
+		int width, height;
+	};
+
+	void findAreas(int first_floor, int last_floor);
+
+	bool exportFloor(int floor, const std::string& filename);
+	bool writeBMP(int floor, const Area& area, const std::string& filename);
+	bool writePNG(int floor, const Area& area, const std::string& filename);
+	// Minimap colors of the rows first_row to first_row + rows - 1 of the area
+	void fillRows(int floor, const Area& area, int first_row, int rows, uint8_t* colors) const;
+
+	void setError(const std::string& message);
+
+	Map& map;
+	Format format;
+	bool selection_only;
+
+	// Empty areas (0 width) are not exported
+	Area areas[MAP_LAYERS];
+
+	std::atomic<bool> cancelled;
+	std::atomic<int64_t> rows_done;
+	std::atomic<int> images_written;
+	std::mutex error_mutex;
+	std::string error;
+};
+
+#endif
@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "minimap_importer.h"
+
+#include "map.h"
+#include "map_region.h"
+#include "tile.h"
+#include "item.h"
+#include "items.h"
+#include "brush.h"
+#include "ground_brush.h"
+#include "graphics.h"
+#include "action.h"
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+	uint32_t packColor(uint8_t red, uint8_t green, uint8_t blue) {
+		return (uint32_t(red) << 16) | (uint32_t(green) << 8) | blue;
+	}
+
+	uint8_t getClosestColor(uint8_t red, uint8_t green, uint8_t blue) {
+		int best = 0;
+		int best_distance = std::numeric_limits<int>::max();
+		for (int i = 0; i < 256; ++i) {
+			const int dr = int(minimap_color[i].red) - red;
+			const int dg = int(minimap_color[i].green) - green;
+			const int db = int(minimap_color[i].blue) - blue;
+			const int distance = dr * dr + dg * dg + db * db;
+			if (distance < best_distance) {
+				best = i;
+				best_distance = distance;
+			}
+		}
+		return uint8_t(best);
+	}
+
+	// Same chance for a position every time, without sharing a random generator between threads
+	int getChance(int x, int y, int z, int total_chance) {
+		uint32_t hash = uint32_t(x) * 73856093u ^ uint32_t(y) * 19349663u ^ uint32_t(z) * 83492791u;
+		hash ^= hash >> 13;
+		hash *= 0x5bd1e995u;
+		hash ^= hash >> 15;
+		return 1 + int(hash % uint32_t(std::max(1, total_chance)));
+	}
+
+	const int LeafJobSize = 64;
+}
+
+MinimapImporter::MinimapImporter(Map& map) :
+	map(map),
+	width(0),
+	height(0),
+	color_counts(256, 0) {
+	////
+}
+
+MinimapImporter::~MinimapImporter() {
+	////
+}
+
+bool MinimapImporter::load(const FileName& filename) {
+	wxImage image;
+	{
+		// wx pops up its own message box for unreadable files
+		wxLogNull log;
+		if (!image.LoadFile(filename.GetFullPath())) {
+			error = "Could not read the image \"" + nstr(filename.GetFullPath()) + "\".";
+			return false;
+		}
+	}
+
+	width = image.GetWidth();
+	height = image.GetHeight();
+	colors.resize(size_t(width) * height);
+	std::fill(color_counts.begin(), color_counts.end(), 0);
+
+	std::unordered_map<uint32_t, uint8_t> lookup;
+	for (int i = 255; i >= 0; --i) {
+		lookup[packColor(minimap_color[i].red, minimap_color[i].green, minimap_color[i].blue)] = uint8_t(i);
+	}
+
+	const uint8_t* pixels = image.GetData();
+	const uint8_t* alpha = image.HasAlpha() ? image.GetAlpha() : nullptr;
+	uint32_t last_rgb = packColor(minimap_color[0].red, minimap_color[0].green, minimap_color[0].blue);
+	uint8_t last_color = 0;
+	for (size_t i = 0; i < colors.size(); ++i, pixels += 3) {
+		uint8_t color = 0;
+		if (!alpha || alpha[i] >= 128) {
+			const uint32_t rgb = packColor(pixels[0], pixels[1], pixels[2]);
+			if (rgb != last_rgb) {
+				auto it = lookup.find(rgb);
+				if (it == lookup.end()) {
+					it = lookup.emplace(rgb, getClosestColor(pixels[0], pixels[1], pixels[2])).first;
+				}
+				last_rgb = rgb;
+				last_color = it->second;
+			}
+			color = last_color;
+		}
+		colors[i] = color;
+		++color_counts[color];
+	}
+	return true;
+}
+
+int64_t MinimapImporter::run(const std::vector<GroundBrush*>& brushes, const Position& offset, Action& action, int threads) {
+	ASSERT(brushes.size() == 256);
+
+	// The part of the image that is on the map
+	const int start_x = std::max(0, offset.x);
+	const int start_y = std::max(0, offset.y);
+	const int end_x = std::min(MAP_MAX_WIDTH + 1, offset.x + width);
+	const int end_y = std::min(MAP_MAX_HEIGHT + 1, offset.y + height);
+	const int z = offset.z;
+	if (start_x >= end_x || start_y >= end_y) {
+		return 0;
+	}
+
+	auto getBrush = [&](int x, int y) -> GroundBrush* {
+		if (x < start_x || y < start_y || x >= end_x || y >= end_y) {
+			return nullptr;
+		}
+		return brushes[colors[size_t(y - offset.y) * width + (x - offset.x)]];
+	};
+
+	// Creating leaves changes the map tree, so that is done here first. The
+	// locations stay empty until the action puts the tiles on them.
+	struct Leaf {
+		QTreeNode* node;
+		LeafTiles* tiles;
+	};
+	std::vector<Leaf> leaves;
+	for (int nd_y = start_y & ~3; nd_y < end_y; nd_y += 4) {
+		for (int nd_x = start_x & ~3; nd_x < end_x; nd_x += 4) {
+			bool used = false;
+			for (int i = 0; i < 16 && !used; ++i) {
+				used = getBrush(nd_x + (i >> 2), nd_y + (i & 3)) != nullptr;
+			}
+			if (used) {
+				QTreeNode* node = map.createLeaf(nd_x, nd_y);
+				node->createFloor(nd_x, nd_y, z);
+				leaves.push_back(Leaf { node, newd LeafTiles(nd_x, nd_y, z) });
+			}
+		}
+	}
+
+	// The tiles of a leaf only belong to it, so the leaves are split over the threads
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t first = next.fetch_add(LeafJobSize); first < leaves.size(); first = next.fetch_add(LeafJobSize)) {
+			const size_t last = std::min(leaves.size(), first + LeafJobSize);
+			for (size_t index = first; index < last; ++index) {
+				Leaf& leaf = leaves[index];
+				for (int i = 0; i < 16; ++i) {
+					const int x = leaf.tiles->x + (i >> 2);
+					const int y = leaf.tiles->y + (i & 3);
+					GroundBrush* brush = getBrush(x, y);
+					const uint16_t ground_id = brush ? brush->getGroundID(getChance(x, y, z, brush->getTotalChance())) : 0;
+					if (ground_id == 0) {
+						continue;
+					}
+
+					// A copy of the tile, the map is only changed when the action is committed
+					TileLocation* location = leaf.node->getTile(x, y, z);
+					Tile* tile = location->get() ? location->get()->deepCopy(map) : map.allocator(location);
+					tile->addItem(Item::Create(ground_id));
+					tile->update();
+					leaf.tiles->setTile(i, tile);
+				}
+			}
+		}
+	};
+
+	if (threads <= 0) {
+		threads = std::max<int>(1, std::thread::hardware_concurrency());
+	}
+	threads = std::max<int>(1, std::min<int>(threads, (leaves.size() + LeafJobSize - 1) / LeafJobSize));
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; ++i) {
+		workers.emplace_back(work);
+	}
+	work();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	// One change per leaf, the action swaps all of its tiles at once
+	int64_t tiles_drawn = 0;
+	for (Leaf& leaf : leaves) {
+		if (leaf.tiles->mask == 0) {
+			delete leaf.tiles;
+			continue;
+		}
+		tiles_drawn += leaf.tiles->getTileCount();
+		action.addChange(newd Change(leaf.tiles));
+	}
+	return tiles_drawn;
+}
+
+GroundBrush* MinimapImporter::findBrush(uint8_t color) {
+	if (color == 0) {
+		return nullptr;
+	}
+
+	for (const auto& it : g_brushes.getMap()) {
+		Brush* brush = it.second;
+		if (!brush->isGround()) {
+			continue;
+		}
+
+		GroundBrush* ground = brush->asGround();
+		const uint16_t id = ground->getGroundID(1);
+		if (id != 0 && g_items[id].sprite && g_items[id].sprite->getMiniMapColor() == color) {
+			return ground;
+		}
+	}
+	return nullptr;
+}
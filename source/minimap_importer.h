@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_IMPORTER_H_
+#define RME_MINIMAP_IMPORTER_H_
+
+class Map;
+class GroundBrush;
+class Action;
+
+// Turns a minimap image into ground tiles, each minimap color is drawn with
+// the ground brush it is given. The tiles are made on several threads, a
+// map leaf (4x4 tiles) at a time, as one change per leaf of an action so the
+// import can be undone.
+class MinimapImporter {
+public:
+	explicit MinimapImporter(Map& map);
+	~MinimapImporter();
+
+	MinimapImporter(const MinimapImporter&) = delete;
+	MinimapImporter& operator=(const MinimapImporter&) = delete;
+
+	// Reads the image and matches its pixels to the closest minimap colors,
+	// transparent pixels become color 0
+	bool load(const FileName& filename);
+
+	int getWidth() const {
+		return width;
+	}
+	int getHeight() const {
+		return height;
+	}
+	// Pixels of each of the 256 minimap colors in the image
+	const std::vector<int64_t>& getColorCounts() const {
+		return color_counts;
+	}
+	const std::string& getError() const {
+		return error;
+	}
+
+	// Adds the tiles with the grounds of brushes[color] (nullptr skips the color)
+	// to action, with the top left corner of the image at offset, made on threads
+	// (0 for one per core). Existing tiles keep their items. Returns the number of
+	// tiles drawn.
+	int64_t run(const std::vector<GroundBrush*>& brushes, const Position& offset, Action& action, int threads = 0);
+
+	// The ground brush drawing items of the color on the minimap, nullptr if none does
+	static GroundBrush* findBrush(uint8_t color);
+
+private:
+	Map& map;
+	int width;
+	int height;
+	// Minimap color of every pixel, row by row
+	std::vector<uint8_t> colors;
+	std::vector<int64_t> color_counts;
+	std::string error;
+};
+
+#endif
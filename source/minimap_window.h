@@ -20,14 +20,9 @@
 
 #include "position.h"
 #include <wx/panel.h>
-#include <memory>
-#include <map>
-#include <thread>
-#include <mutex>
-#include <atomic>
 #include <wx/timer.h>
-#include <wx/pen.h>
 
+// Draws the minimap of the current editor from its MinimapCache
 class MinimapWindow : public wxPanel {
 public:
 	enum {
@@ -40,8 +35,10 @@ public:
 	void OnPaint(wxPaintEvent&);
 	void OnEraseBackground(wxEraseEvent&) { }
 	void OnMouseClick(wxMouseEvent&);
+	void OnMouseWheel(wxMouseEvent&);
 	void OnSize(wxSizeEvent&);
 	void OnClose(wxCloseEvent&);
+	void OnIdle(wxIdleEvent&);
 
 	void DelayedUpdate();
 	void OnDelayedUpdate(wxTimerEvent& event);
@@ -49,65 +46,16 @@ public:
 
 	void ClearCache();
 
+	// The cache of the editor already knows which tiles changed
 	void UpdateDrawnTiles(const PositionVector& positions);
 
-	static const int BLOCK_SIZE = 256;  // 256 IS most optimal 512 is too laggy and 64 is too small
-	
-	struct MinimapBlock {
-		wxBitmap bitmap;
-		bool needsUpdate = true;
-		bool wasSeen = false;
-		int floor = -1;
-		
-		MinimapBlock() : needsUpdate(true), wasSeen(false) {}
-	};
-	
-	using BlockPtr = std::shared_ptr<MinimapBlock>;
-	using BlockMap = std::map<uint32_t, BlockPtr>;
-
-	bool needs_update;
-
-	void MarkBlockForUpdate(int x, int y) {
-		if (auto block = getBlock(x, y)) {
-			block->needsUpdate = true;
-		}
-	}
-
 private:
-	BlockMap m_blocks;
-	std::mutex m_mutex;
-	
-	// Helper methods
-	uint32_t getBlockIndex(int x, int y) const {
-		return ((x / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (y / BLOCK_SIZE);
-	}
-	
-	wxPoint getBlockOffset(int x, int y) {
-		return wxPoint(x - x % BLOCK_SIZE, y - y % BLOCK_SIZE);
-	}
-	
-	BlockPtr getBlock(int x, int y);
-	void updateBlock(BlockPtr block, int startX, int startY, int floor);
-
-	wxBitmap buffer;
-	std::mutex buffer_mutex;
-	std::thread render_thread;
-	std::atomic<bool> thread_running;
-
-	
-	void RenderThreadFunction();
-	void StartRenderThread();
-	void StopRenderThread();
-	
-	// Store last known state to detect changes
-	int last_center_x;
-	int last_center_y;
-	int last_floor;
+	// Top left corner of the window in pixels of the current zoom
+	void getStart(int& start_x, int& start_y);
 
-	wxPen* pens[256];
 	wxTimer update_timer;
-	int last_start_x;
-	int last_start_y;
+	// Minimap pixels are 2^zoom map tiles wide
+	int zoom;
 
 	DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "png_writer.h"
+
+namespace {
+	// Size of the compressed IDAT chunks
+	const size_t ChunkSize = 256 * 1024;
+
+	void putU32(uint8_t* data, uint32_t value) {
+		data[0] = uint8_t(value >> 24);
+		data[1] = uint8_t(value >> 16);
+		data[2] = uint8_t(value >> 8);
+		data[3] = uint8_t(value);
+	}
+}
+
+PNGWriter::PNGWriter() :
+	stream_open(false),
+	width(0),
+	height(0),
+	rows_written(0),
+	output_used(0) {
+	memset(&stream, 0, sizeof(stream));
+}
+
+PNGWriter::~PNGWriter() {
+	if (stream_open) {
+		deflateEnd(&stream);
+	}
+}
+
+bool PNGWriter::open(const std::string& filename, uint32_t width, uint32_t height) {
+	if (width == 0 || height == 0 || width > 0x7FFFFFFF / 3 || height > 0x7FFFFFFF) {
+		return fail("Invalid image size.");
+	}
+
+	file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return fail("Could not open " + filename + " for writing.");
+	}
+
+	if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		return fail("Could not initialize the compressor.");
+	}
+	stream_open = true;
+
+	this->width = width;
+	this->height = height;
+	rows_written = 0;
+	filtered.resize(1 + size_t(width) * 3);
+	output.resize(ChunkSize);
+	output_used = 0;
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	// 8 bit RGB, no interlacing
+	uint8_t header[13];
+	putU32(header, width);
+	putU32(header + 4, height);
+	header[8] = 8;
+	header[9] = 2;
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	return writeChunk("IHDR", header, sizeof(header));
+}
+
+bool PNGWriter::writeRow(const uint8_t* pixels) {
+	if (!stream_open || rows_written >= height) {
+		return fail("Too many rows written.");
+	}
+
+	// The "sub" filter, neighbouring map pixels are mostly alike so this compresses well
+	filtered[0] = 1;
+	const size_t bytes = size_t(width) * 3;
+	for (size_t i = 0; i < bytes; ++i) {
+		filtered[i + 1] = pixels[i] - (i >= 3 ? pixels[i - 3] : 0);
+	}
+
+	++rows_written;
+	return compress(filtered.data(), filtered.size(), Z_NO_FLUSH);
+}
+
+bool PNGWriter::close() {
+	if (!stream_open) {
+		return false;
+	}
+
+	// An incomplete image still gets its file closed, so it can be removed
+	bool ok = rows_written == height || fail("The image is incomplete.");
+	ok = ok && compress(nullptr, 0, Z_FINISH) && writeChunk("IEND", nullptr, 0);
+	deflateEnd(&stream);
+	stream_open = false;
+
+	file.close();
+	if (ok && file.fail()) {
+		return fail("Could not write the image file.");
+	}
+	return ok;
+}
+
+bool PNGWriter::writeChunk(const char* type, const uint8_t* data, size_t size) {
+	uint8_t length[4];
+	putU32(length, uint32_t(size));
+
+	uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+	if (size > 0) {
+		crc = crc32(crc, data, uInt(size));
+	}
+	uint8_t checksum[4];
+	putU32(checksum, uint32_t(crc));
+
+	file.write(reinterpret_cast<const char*>(length), 4);
+	file.write(type, 4);
+	if (size > 0) {
+		file.write(reinterpret_cast<const char*>(data), size);
+	}
+	file.write(reinterpret_cast<const char*>(checksum), 4);
+
+	if (!file.good()) {
+		return fail("Could not write the image file.");
+	}
+	return true;
+}
+
+bool PNGWriter::compress(const uint8_t* data, size_t size, int flush) {
+	stream.next_in = const_cast<Bytef*>(data);
+	stream.avail_in = uInt(size);
+
+	int result;
+	do {
+		stream.next_out = output.data() + output_used;
+		stream.avail_out = uInt(output.size() - output_used);
+		result = deflate(&stream, flush);
+		if (result == Z_STREAM_ERROR) {
+			return fail("Could not compress the image.");
+		}
+		output_used = output.size() - stream.avail_out;
+
+		// Emit an IDAT chunk every time the buffer fills up
+		if (output_used == output.size()) {
+			if (!writeChunk("IDAT", output.data(), output_used)) {
+				return false;
+			}
+			output_used = 0;
+		}
+	} while (stream.avail_in > 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+
+	if (flush == Z_FINISH && output_used > 0) {
+		if (!writeChunk("IDAT", output.data(), output_used)) {
+			return false;
+		}
+		output_used = 0;
+	}
+	return true;
+}
+
+bool PNGWriter::fail(const std::string& message) {
+	if (error.empty()) {
+		error = message;
+	}
+	return false;
+}
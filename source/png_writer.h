@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PNG_WRITER_H_
+#define RME_PNG_WRITER_H_
+
+#include <zlib.h>
+
+// Writes an RGB PNG one row at a time, so images far larger than
+// what fits in memory can be saved. Rows go top to bottom.
+class PNGWriter {
+public:
+	PNGWriter();
+	~PNGWriter();
+
+	bool open(const std::string& filename, uint32_t width, uint32_t height);
+	// width * 3 bytes of RGB
+	bool writeRow(const uint8_t* pixels);
+	// Finishes and closes the file, fails if not all rows were written
+	bool close();
+
+	uint32_t getRowsWritten() const noexcept {
+		return rows_written;
+	}
+	const std::string& getError() const noexcept {
+		return error;
+	}
+
+private:
+	bool writeChunk(const char* type, const uint8_t* data, size_t size);
+	bool compress(const uint8_t* data, size_t size, int flush);
+	bool fail(const std::string& message);
+
+	std::ofstream file;
+	z_stream stream;
+	bool stream_open;
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t rows_written;
+
+	std::vector<uint8_t> filtered;
+	std::vector<uint8_t> output;
+	size_t output_used;
+	std::string error;
+};
+
+#endif
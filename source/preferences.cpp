@@ -79,6 +79,11 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	always_make_backup_chkbox->SetValue(g_settings.getInteger(Config::ALWAYS_MAKE_BACKUP) == 1);
 	sizer->Add(always_make_backup_chkbox, 0, wxLEFT | wxTOP, 5);
 
+	save_minimap_cache_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Save minimap cache with the map");
+	save_minimap_cache_chkbox->SetValue(g_settings.getInteger(Config::SAVE_MINIMAP_CACHE) == 1);
+	save_minimap_cache_chkbox->SetToolTip("Keeps the minimap in a file next to the map, so it does not have to be built again when the map is opened.");
+	sizer->Add(save_minimap_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+
 	update_check_on_startup_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Check for updates on startup");
 	update_check_on_startup_chkbox->SetValue(g_settings.getInteger(Config::USE_UPDATER) == 1);
 	sizer->Add(update_check_on_startup_chkbox, 0, wxLEFT | wxTOP, 5);
@@ -113,16 +118,26 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	grid_sizer->Add(undo_mem_size_spin, 0);
 	SetWindowToolTip(tmptext, undo_mem_size_spin, "The approximite limit for the memory usage of the undo queue.");
 
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Undo maximum disk size (MB): "), 0);
+	undo_disk_size_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::UNDO_DISK_SIZE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0x100000);
+	grid_sizer->Add(undo_disk_size_spin, 0);
+	SetWindowToolTip(tmptext, undo_disk_size_spin, "Undo history past the memory limit is compressed into a temporary file of up to this size, 0 deletes it instead.");
+
 	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Worker Threads: "), 0);
-	worker_threads_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::WORKER_THREADS)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 64);
+	worker_threads_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::WORKER_THREADS)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 64);
 	grid_sizer->Add(worker_threads_spin, 0);
-	SetWindowToolTip(tmptext, worker_threads_spin, "How many threads the editor will use for intensive operations. This should be equivalent to the amount of logical processors in your system.");
+	SetWindowToolTip(tmptext, worker_threads_spin, "How many threads the editor will use for intensive operations, 0 uses one per logical processor in your system.");
 
 	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Replace count: "), 0);
 	replace_size_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::REPLACE_SIZE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 100000);
 	grid_sizer->Add(replace_size_spin, 0);
 	SetWindowToolTip(tmptext, replace_size_spin, "How many items you can replace on the map using the Replace Item tool.");
 
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Fill maximum area: "), 0);
+	fill_max_area_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::FILL_MAX_AREA)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 0x10000000);
+	grid_sizer->Add(fill_max_area_spin, 0);
+	SetWindowToolTip(tmptext, fill_max_area_spin, "How many tiles Fill Area and Ctrl+D can fill at once, larger areas are not filled.");
+
 	sizer->Add(grid_sizer, 0, wxALL, 5);
 	sizer->AddSpacer(10);
 
@@ -286,6 +301,24 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	subsizer->Add(screenshot_format_choice, 0);
 	SetWindowToolTip(screenshot_format_choice, tmp, "This will affect the screenshot format used by the editor.\nTo take a screenshot, press F11.");
 
+	// Simplified rendering
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Simplified rendering above zoom: "), 0);
+	lod_zoom_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::LOD_ZOOM_THRESHOLD)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 25);
+	subsizer->Add(lod_zoom_spin, 0);
+	SetWindowToolTip(lod_zoom_spin, tmp, "When zoomed out further than this, every tile is drawn as a single averaged color from a cache instead of its sprites.\nSet to 0 to always draw the sprites.");
+
+	// Background sprite loading
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Sprite uploads per frame: "), 0);
+	sprite_upload_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::SPRITE_UPLOAD_BUDGET)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 4096);
+	subsizer->Add(sprite_upload_spin, 0);
+	SetWindowToolTip(sprite_upload_spin, tmp, "Sprites are decoded in the background and at most this many are sent to the graphics card each frame, the others are drawn as placeholders until they are ready.\nSet to 0 to load every sprite right away while drawing.");
+
+	// Texture budget
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Texture memory budget (MB): "), 0);
+	texture_memory_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::TEXTURE_MEMORY_BUDGET)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 4096);
+	subsizer->Add(texture_memory_spin, 0);
+	SetWindowToolTip(texture_memory_spin, tmp, "When the sprites on the graphics card take more memory than this, the ones that were not drawn for the longest time are unloaded.");
+
 	sizer->Add(subsizer, 1, wxEXPAND | wxALL, 5);
 
 	// Advanced g_settings
@@ -303,21 +336,6 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 		wxFlexGridSizer* pane_grid_sizer = newd wxFlexGridSizer(2, 10, 10);
 		pane_grid_sizer->AddGrowableCol(1);
 
-		pane_grid_sizer->Add(tmp = newd wxStaticText(pane->GetPane(), wxID_ANY, "Texture clean interval: "), 0);
-		clean_interval_spin = newd wxSpinCtrl(pane->GetPane(), wxID_ANY, i2ws(g_settings.getInteger(Config::TEXTURE_CLEAN_PULSE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0x1000000);
-		pane_grid_sizer->Add(clean_interval_spin, 0);
-		SetWindowToolTip(clean_interval_spin, tmp, "This controls how often the editor tries to free hardware texture resources.");
-
-		pane_grid_sizer->Add(tmp = newd wxStaticText(pane->GetPane(), wxID_ANY, "Texture longevity: "), 0);
-		texture_longevity_spin = newd wxSpinCtrl(pane->GetPane(), wxID_ANY, i2ws(g_settings.getInteger(Config::TEXTURE_LONGEVITY)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0x1000000);
-		pane_grid_sizer->Add(texture_longevity_spin, 0);
-		SetWindowToolTip(texture_longevity_spin, tmp, "This controls for how long (in seconds) that the editor will keep textures in memory before it cleans them up.");
-
-		pane_grid_sizer->Add(tmp = newd wxStaticText(pane->GetPane(), wxID_ANY, "Texture clean threshold: "), 0);
-		texture_threshold_spin = newd wxSpinCtrl(pane->GetPane(), wxID_ANY, i2ws(g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 100, 0x1000000);
-		pane_grid_sizer->Add(texture_threshold_spin, 0);
-		SetWindowToolTip(texture_threshold_spin, tmp, "This controls how many textures the editor will hold in memory before it attempts to clean up old textures. However, an infinite amount MIGHT be loaded.");
-
 		pane_grid_sizer->Add(tmp = newd wxStaticText(pane->GetPane(), wxID_ANY, "Software clean threshold: "), 0);
 		software_threshold_spin = newd wxSpinCtrl(pane->GetPane(), wxID_ANY, i2ws(g_settings.getInteger(Config::SOFTWARE_CLEAN_THRESHOLD)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 100, 0x1000000);
 		pane_grid_sizer->Add(software_threshold_spin, 0);
@@ -590,12 +608,15 @@ void PreferencesWindow::Apply() {
 	// General
 	g_settings.setInteger(Config::WELCOME_DIALOG, show_welcome_dialog_chkbox->GetValue());
 	g_settings.setInteger(Config::ALWAYS_MAKE_BACKUP, always_make_backup_chkbox->GetValue());
+	g_settings.setInteger(Config::SAVE_MINIMAP_CACHE, save_minimap_cache_chkbox->GetValue());
 	g_settings.setInteger(Config::USE_UPDATER, update_check_on_startup_chkbox->GetValue());
 	g_settings.setInteger(Config::ONLY_ONE_INSTANCE, only_one_instance_chkbox->GetValue());
 	g_settings.setInteger(Config::UNDO_SIZE, undo_size_spin->GetValue());
 	g_settings.setInteger(Config::UNDO_MEM_SIZE, undo_mem_size_spin->GetValue());
+	g_settings.setInteger(Config::UNDO_DISK_SIZE, undo_disk_size_spin->GetValue());
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
+	g_settings.setInteger(Config::FILL_MAX_AREA, fill_max_area_spin->GetValue());
 	g_settings.setInteger(Config::COPY_POSITION_FORMAT, position_format->GetSelection());
 
 	if (g_settings.getBoolean(Config::SHOW_TILESET_EDITOR) != enable_tileset_editing_chkbox->GetValue()) {
@@ -665,11 +686,11 @@ void PreferencesWindow::Apply() {
 	// g_settings.setInteger(Config::CURSOR_ALT_ALPHA, clr.Alpha());
 
 	g_settings.setInteger(Config::HIDE_ITEMS_WHEN_ZOOMED, hide_items_when_zoomed_chkbox->GetValue());
+	g_settings.setInteger(Config::LOD_ZOOM_THRESHOLD, lod_zoom_spin->GetValue());
+	g_settings.setInteger(Config::SPRITE_UPLOAD_BUDGET, sprite_upload_spin->GetValue());
+	g_settings.setInteger(Config::TEXTURE_MEMORY_BUDGET, texture_memory_spin->GetValue());
 	/*
 	g_settings.setInteger(Config::TEXTURE_MANAGEMENT, texture_managment_chkbox->GetValue());
-	g_settings.setInteger(Config::TEXTURE_CLEAN_PULSE, clean_interval_spin->GetValue());
-	g_settings.setInteger(Config::TEXTURE_LONGEVITY, texture_longevity_spin->GetValue());
-	g_settings.setInteger(Config::TEXTURE_CLEAN_THRESHOLD, texture_threshold_spin->GetValue());
 	g_settings.setInteger(Config::SOFTWARE_CLEAN_THRESHOLD, software_threshold_spin->GetValue());
 	g_settings.setInteger(Config::SOFTWARE_CLEAN_SIZE, software_clean_amount_spin->GetValue());
 	*/
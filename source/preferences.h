@@ -45,6 +45,7 @@ protected:
 
 	// General
 	wxCheckBox* always_make_backup_chkbox;
+	wxCheckBox* save_minimap_cache_chkbox;
 	wxCheckBox* create_on_startup_chkbox;
 	wxCheckBox* update_check_on_startup_chkbox;
 	wxCheckBox* only_one_instance_chkbox;
@@ -52,8 +53,10 @@ protected:
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
+	wxSpinCtrl* undo_disk_size_spin;
 	wxSpinCtrl* worker_threads_spin;
 	wxSpinCtrl* replace_size_spin;
+	wxSpinCtrl* fill_max_area_spin;
 	wxRadioBox* position_format;
 
 	// Editor
@@ -75,13 +78,13 @@ protected:
 	wxDirPickerCtrl* screenshot_directory_picker;
 	wxChoice* screenshot_format_choice;
 	wxCheckBox* hide_items_when_zoomed_chkbox;
+	wxSpinCtrl* lod_zoom_spin;
+	wxSpinCtrl* sprite_upload_spin;
+	wxSpinCtrl* texture_memory_spin;
 	wxColourPickerCtrl* cursor_color_pick;
 	wxColourPickerCtrl* cursor_alt_color_pick;
 	/*
 	wxCheckBox* texture_managment_chkbox;
-	wxSpinCtrl* clean_interval_spin;
-	wxSpinCtrl* texture_longevity_spin;
-	wxSpinCtrl* texture_threshold_spin;
 	wxSpinCtrl* software_threshold_spin;
 	wxSpinCtrl* software_clean_amount_spin;
 	*/
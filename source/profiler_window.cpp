@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "profiler_window.h"
+#include "frame_profiler.h"
+#include "gui.h"
+
+#include <tuple>
+
+BEGIN_EVENT_TABLE(ProfilerWindow, wxPanel)
+EVT_TIMER(wxID_ANY, ProfilerWindow::OnUpdateTimer)
+EVT_BUTTON(wxID_SAVE, ProfilerWindow::OnClickExport)
+EVT_BUTTON(wxID_CLEAR, ProfilerWindow::OnClickClear)
+END_EVENT_TABLE()
+
+ProfilerWindow::ProfilerWindow(wxWindow* parent) :
+	wxPanel(parent, wxID_ANY),
+	update_timer(this) {
+	wxSizer* sizer = newd wxBoxSizer(wxVERTICAL);
+
+	value_list = newd wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(240, 250), wxLC_REPORT | wxLC_SINGLE_SEL);
+	value_list->InsertColumn(0, "Name", wxLIST_FORMAT_LEFT, 110);
+	value_list->InsertColumn(1, "Last", wxLIST_FORMAT_RIGHT, 60);
+	value_list->InsertColumn(2, "Average", wxLIST_FORMAT_RIGHT, 60);
+	sizer->Add(value_list, wxSizerFlags(1).Expand());
+
+	histogram = newd wxPanel(this, wxID_ANY, wxDefaultPosition, wxSize(240, 80));
+	histogram->SetBackgroundStyle(wxBG_STYLE_PAINT);
+	histogram->Bind(wxEVT_PAINT, &ProfilerWindow::OnPaintHistogram, this);
+	sizer->Add(histogram, wxSizerFlags(0).Expand().Border(wxTOP, 4));
+
+	wxSizer* buttons_sizer = newd wxBoxSizer(wxHORIZONTAL);
+	buttons_sizer->Add(newd wxButton(this, wxID_SAVE, "Export CSV"), wxSizerFlags(0).Center());
+	buttons_sizer->Add(newd wxButton(this, wxID_CLEAR, "Clear"), wxSizerFlags(0).Center());
+	sizer->Add(buttons_sizer, wxSizerFlags(0).Center().DoubleBorder());
+	SetSizerAndFit(sizer);
+
+	UpdateValues();
+	update_timer.Start(500);
+}
+
+ProfilerWindow::~ProfilerWindow() {
+	update_timer.Stop();
+}
+
+void ProfilerWindow::OnUpdateTimer(wxTimerEvent& WXUNUSED(event)) {
+	if (IsShownOnScreen()) {
+		UpdateValues();
+		histogram->Refresh();
+	}
+}
+
+void ProfilerWindow::UpdateValues() {
+	const std::deque<FrameProfiler::Frame>& history = g_profiler.getHistory();
+	const FrameProfiler::Frame last = history.empty() ? FrameProfiler::Frame() : history.back();
+	const FrameProfiler::Frame average = g_profiler.getAverage();
+	const GraphicManager::TextureStats textures = g_gui.gfx.getTextureStats();
+
+	std::vector<std::tuple<wxString, wxString, wxString>> rows;
+	rows.emplace_back("frame (ms)", wxString::Format("%.2f", last.total), wxString::Format("%.2f", average.total));
+	for (int i = 0; i < FrameProfiler::STAGE_COUNT; ++i) {
+		FrameProfiler::Stage stage = static_cast<FrameProfiler::Stage>(i);
+		rows.emplace_back(wxString(FrameProfiler::getStageName(stage)) + " (ms)", wxString::Format("%.2f", last.stages[i]), wxString::Format("%.2f", average.stages[i]));
+	}
+	for (int i = 0; i < FrameProfiler::COUNTER_COUNT; ++i) {
+		FrameProfiler::Counter counter = static_cast<FrameProfiler::Counter>(i);
+		rows.emplace_back(FrameProfiler::getCounterName(counter), wxString::Format("%llu", (unsigned long long)last.counters[i]), wxString::Format("%llu", (unsigned long long)average.counters[i]));
+	}
+	rows.emplace_back("resident_textures", wxString::Format("%d", textures.resident), wxString::Format("%.1f MB", textures.resident_bytes / (1024.0 * 1024.0)));
+	rows.emplace_back("texture_evictions", wxString::Format("%llu", (unsigned long long)textures.evictions), "");
+
+	if (value_list->GetItemCount() != static_cast<int>(rows.size())) {
+		value_list->DeleteAllItems();
+		for (size_t i = 0; i < rows.size(); ++i) {
+			value_list->InsertItem(i, std::get<0>(rows[i]));
+		}
+	}
+	for (size_t i = 0; i < rows.size(); ++i) {
+		value_list->SetItem(i, 1, std::get<1>(rows[i]));
+		value_list->SetItem(i, 2, std::get<2>(rows[i]));
+	}
+}
+
+void ProfilerWindow::OnPaintHistogram(wxPaintEvent& WXUNUSED(event)) {
+	wxAutoBufferedPaintDC dc(histogram);
+	const wxSize size = histogram->GetClientSize();
+	dc.SetBackground(*wxBLACK_BRUSH);
+	dc.Clear();
+
+	// Stacked bars of the stage times, newest on the right, the line marks 60 fps
+	const double pixels_per_ms = size.GetHeight() / 33.3;
+	const std::deque<FrameProfiler::Frame>& history = g_profiler.getHistory();
+	int x = size.GetWidth() - 1;
+	for (auto it = history.rbegin(); it != history.rend() && x >= 0; ++it, --x) {
+		int y = size.GetHeight();
+		for (int i = 0; i < FrameProfiler::STAGE_COUNT; ++i) {
+			int height = static_cast<int>(it->stages[i] * pixels_per_ms + 0.5);
+			if (height <= 0) {
+				continue;
+			}
+			const uint32_t color = FrameProfiler::getStageColor(static_cast<FrameProfiler::Stage>(i));
+			dc.SetPen(wxPen(wxColor((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF)));
+			dc.DrawLine(x, y, x, y - height);
+			y -= height;
+		}
+	}
+
+	const int target = size.GetHeight() - static_cast<int>(16.7 * pixels_per_ms);
+	dc.SetPen(*wxWHITE_PEN);
+	dc.DrawLine(0, target, size.GetWidth(), target);
+}
+
+void ProfilerWindow::OnClickExport(wxCommandEvent& WXUNUSED(event)) {
+	wxFileDialog dialog(this, "Export frame timings...", "", "frame_profile.csv", "CSV files (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dialog.ShowModal() != wxID_OK) {
+		return;
+	}
+
+	if (!g_profiler.exportCSV(nstr(dialog.GetPath()))) {
+		g_gui.PopupDialog(this, "Error", "Could not write " + dialog.GetPath(), wxOK);
+	}
+}
+
+void ProfilerWindow::OnClickClear(wxCommandEvent& WXUNUSED(event)) {
+	g_profiler.clear();
+	UpdateValues();
+	histogram->Refresh();
+}
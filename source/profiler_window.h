@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PROFILER_WINDOW_H_
+#define RME_PROFILER_WINDOW_H_
+
+#include "main.h"
+
+#include <wx/listctrl.h>
+
+// Dockable panel listing the frame profiler timings and counters,
+// with a histogram of the recent frame times
+class ProfilerWindow : public wxPanel {
+public:
+	ProfilerWindow(wxWindow* parent);
+	virtual ~ProfilerWindow();
+
+	void OnUpdateTimer(wxTimerEvent& event);
+	void OnPaintHistogram(wxPaintEvent& event);
+	void OnClickExport(wxCommandEvent& event);
+	void OnClickClear(wxCommandEvent& event);
+
+protected:
+	void UpdateValues();
+
+	wxListCtrl* value_list;
+	wxPanel* histogram;
+	wxTimer update_timer;
+
+	DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -315,16 +315,39 @@ void SelectionThread::Execute() {
 wxThread::ExitCode SelectionThread::Entry() {
 	selection.start(Selection::SUBTHREAD);
 	for (int z = start.z; z >= end.z; --z) {
-		for (int x = start.x; x <= end.x; ++x) {
-			for (int y = start.y; y <= end.y; ++y) {
-				Tile* tile = editor.map.getTile(x, y, z);
-				if (!tile) {
+		const int start_x = std::max(0, start.x);
+		const int start_y = std::max(0, start.y);
+
+		// Parts of the map without any leaves are skipped 256 tiles at a time
+		for (int node_x = start_x & ~255; node_x <= end.x; node_x += 256) {
+			for (int node_y = start_y & ~255; node_y <= end.y; node_y += 256) {
+				if (!editor.map.getNode(node_x, node_y, 4)) {
 					continue;
 				}
 
-				selection.add(tile);
+				const int node_end_x = std::min(end.x, node_x + 255);
+				const int node_end_y = std::min(end.y, node_y + 255);
+				for (int nd_x = std::max(start_x, node_x) & ~3; nd_x <= node_end_x; nd_x += 4) {
+					for (int nd_y = std::max(start_y, node_y) & ~3; nd_y <= node_end_y; nd_y += 4) {
+						QTreeNode* leaf = editor.map.getLeaf(nd_x, nd_y);
+						Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+						if (!floor) {
+							continue;
+						}
+
+						for (int x = std::max(start_x, nd_x); x <= std::min(node_end_x, nd_x + 3); ++x) {
+							for (int y = std::max(start_y, nd_y); y <= std::min(node_end_y, nd_y + 3); ++y) {
+								Tile* tile = floor->locs[(x & 3) * 4 + (y & 3)].get();
+								if (tile) {
+									selection.add(tile);
+								}
+							}
+						}
+					}
+				}
 			}
 		}
+
 		if (z <= GROUND_LAYER && g_settings.getInteger(Config::COMPENSATED_SELECT)) {
 			++start.x;
 			++start.y;
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
 
 Settings g_settings;
 
@@ -73,6 +74,14 @@ int Settings::getInteger(uint32_t key) const {
 	return 0;
 }
 
+int Settings::getWorkerThreads() const {
+	const int threads = getInteger(Config::WORKER_THREADS);
+	if (threads <= 0) {
+		return std::max<int>(1, std::thread::hardware_concurrency());
+	}
+	return threads;
+}
+
 float Settings::getFloat(uint32_t key) const {
 	if (key > Config::LAST) {
 		return 0.0;
@@ -230,6 +239,7 @@ void Settings::IO(IOMode mode) {
 	Int(SHOW_TOWNS, 0);
 	Int(ALWAYS_SHOW_ZONES, 1);
 	Int(EXT_HOUSE_SHADER, 1);
+	Int(SHOW_FRAME_PROFILER, 0);
 
 	section("Version");
 	Int(VERSION_ID, 0);
@@ -241,11 +251,12 @@ void Settings::IO(IOMode mode) {
 
 	section("Editor");
 	String(RECENT_FILES, "");
-	Int(WORKER_THREADS, 1);
+	Int(WORKER_THREADS, 0);
 	Int(MERGE_MOVE, 0);
 	Int(MERGE_PASTE, 0);
 	Int(UNDO_SIZE, 400);
 	Int(UNDO_MEM_SIZE, 40);
+	Int(UNDO_DISK_SIZE, 1024);
 	Int(GROUP_ACTIONS, 1);
 	Int(SELECTION_TYPE, SELECT_CURRENT_FLOOR);
 	Int(COMPENSATED_SELECT, 1);
@@ -260,6 +271,7 @@ void Settings::IO(IOMode mode) {
 	Int(BORDERIZE_DRAG_THRESHOLD, 6000);
 	Int(BORDERIZE_PASTE_THRESHOLD, 10000);
 	Int(ALWAYS_MAKE_BACKUP, 0);
+	Int(SAVE_MINIMAP_CACHE, 1);
 	Int(USE_AUTOMAGIC, 1);
 	Int(HOUSE_BRUSH_REMOVE_ITEMS, 0);
 	Int(AUTO_ASSIGN_DOORID, 1);
@@ -278,24 +290,27 @@ void Settings::IO(IOMode mode) {
 	Int(USE_OTGZ, 1);
 	Int(SAVE_WITH_OTB_MAGIC_NUMBER, 0);
 	Int(REPLACE_SIZE, 500);
+	Int(FILL_MAX_AREA, 1000000);
 	Int(COPY_POSITION_FORMAT, 0);
 
 	section("Graphics");
 	Int(TEXTURE_MANAGEMENT, 1);
-	Int(TEXTURE_CLEAN_PULSE, 15);
-	Int(TEXTURE_LONGEVITY, 20);
-	Int(TEXTURE_CLEAN_THRESHOLD, 2500);
 	Int(SOFTWARE_CLEAN_THRESHOLD, 1800);
 	Int(SOFTWARE_CLEAN_SIZE, 500);
 	Int(ICON_BACKGROUND, 0);
 	Int(HARD_REFRESH_RATE, 200);
 	Int(HIDE_ITEMS_WHEN_ZOOMED, 1);
+	Int(LOD_ZOOM_THRESHOLD, 4);
+	Int(SPRITE_UPLOAD_BUDGET, 256);
+	Int(TEXTURE_MEMORY_BUDGET, 64);
 	String(SCREENSHOT_DIRECTORY, "");
 	String(SCREENSHOT_FORMAT, "png");
 	IntToSave(USE_MEMCACHED_SPRITES, 0);
 	Int(MINIMAP_UPDATE_DELAY, 333);
 	Int(MINIMAP_VIEW_BOX, 1);
 	String(MINIMAP_EXPORT_DIR, "");
+	String(MINIMAP_IMPORT_BRUSHES, "");
+	String(WEB_MAP_EXPORT_DIR, "");
 	String(TILESET_EXPORT_DIR, "");
 
 	Int(CURSOR_RED, 0);
@@ -31,9 +31,6 @@ namespace Config {
 
 		MERGE_MOVE,
 		TEXTURE_MANAGEMENT,
-		TEXTURE_CLEAN_PULSE,
-		TEXTURE_CLEAN_THRESHOLD,
-		TEXTURE_LONGEVITY,
 		HARD_REFRESH_RATE,
 		USE_MEMCACHED_SPRITES,
 		USE_MEMCACHED_SPRITES_TO_SAVE,
@@ -65,6 +62,7 @@ namespace Config {
 		ZOOM_SPEED,
 		UNDO_SIZE,
 		UNDO_MEM_SIZE,
+		UNDO_DISK_SIZE,
 		MERGE_PASTE,
 		SELECTION_TYPE,
 		COMPENSATED_SELECT,
@@ -75,6 +73,7 @@ namespace Config {
 		BORDERIZE_PASTE_THRESHOLD,
 		ICON_BACKGROUND,
 		ALWAYS_MAKE_BACKUP,
+		SAVE_MINIMAP_CACHE,
 		USE_AUTOMAGIC,
 		HOUSE_BRUSH_REMOVE_ITEMS,
 		AUTO_ASSIGN_DOORID,
@@ -86,6 +85,7 @@ namespace Config {
 		USE_OTGZ,
 		SAVE_WITH_OTB_MAGIC_NUMBER,
 		REPLACE_SIZE,
+		FILL_MAX_AREA,
 
 		USE_LARGE_CONTAINER_ICONS,
 		USE_LARGE_CHOOSE_ITEM_ICONS,
@@ -140,6 +140,8 @@ namespace Config {
 		MINIMAP_UPDATE_DELAY,
 		MINIMAP_VIEW_BOX,
 		MINIMAP_EXPORT_DIR,
+		MINIMAP_IMPORT_BRUSHES,
+		WEB_MAP_EXPORT_DIR,
 		TILESET_EXPORT_DIR,
 		WINDOW_HEIGHT,
 		WINDOW_WIDTH,
@@ -182,6 +184,11 @@ namespace Config {
 
 		AUTO_SELECT_RAW_ON_RIGHTCLICK,
 
+		LOD_ZOOM_THRESHOLD,
+		SPRITE_UPLOAD_BUDGET,
+		TEXTURE_MEMORY_BUDGET,
+		SHOW_FRAME_PROFILER,
+
 		
 
 		LAST,
@@ -207,6 +214,8 @@ public:
 	int getInteger(uint32_t key) const;
 	float getFloat(uint32_t key) const;
 	std::string getString(uint32_t key) const;
+	// Config::WORKER_THREADS, 0 is one thread per logical processor
+	int getWorkerThreads() const;
 
 	void setInteger(uint32_t key, int newval);
 	void setFloat(uint32_t key, float newval);
@@ -0,0 +1,442 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "software_renderer.h"
+
+#include "basemap.h"
+#include "map_region.h"
+#include "tile.h"
+#include "item.h"
+#include "items.h"
+#include "graphics.h"
+#include "filehandle.h"
+#include "settings.h"
+#include "gui.h"
+#include "creature.h"
+#include "png_writer.h"
+
+#include <cstdio>
+
+namespace {
+	// Valid outfit colors are below 256, so no valid outfit has this hash
+	const uint32_t PlainSprite = 0xFFFFFFFF;
+
+	inline uint64_t getSpriteKey(uint32_t sprite_id, uint32_t color_hash) {
+		return (uint64_t(sprite_id) << 32) | color_hash;
+	}
+}
+
+SoftwareRenderer::SoftwareRenderer(BaseMap& map, int threads) :
+	map(map),
+	max_sprites(DefaultCacheSize / (SPRITE_PIXELS_SIZE * 4)),
+	image_width(0),
+	first_row(0),
+	rows(0),
+	target(nullptr),
+	next_strip(0),
+	generation(0),
+	busy_workers(0),
+	stopping(false) {
+	if (!g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) {
+		sprite_file.reset(newd FileReadHandle(g_gui.gfx.getSpriteFile()));
+	}
+
+	if (threads <= 0) {
+		threads = std::max<int>(1, std::thread::hardware_concurrency());
+	}
+	for (int i = 1; i < threads; ++i) {
+		workers.emplace_back(&SoftwareRenderer::workerLoop, this);
+	}
+}
+
+SoftwareRenderer::~SoftwareRenderer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void SoftwareRenderer::render(const Position& from, const Position& to, std::vector<uint8_t>& rgba) {
+	const int height = getImageHeight(from, to);
+	rgba.resize(size_t(getImageWidth(from, to)) * height * 4);
+	render(from, to, 0, height, rgba.data());
+}
+
+void SoftwareRenderer::render(const Position& from, const Position& to, int first_row, int rows, uint8_t* rgba) {
+	const int floor = from.z;
+	image_width = getImageWidth(from, to);
+	this->first_row = first_row;
+	this->rows = rows;
+	strips.assign((rows + StripHeight - 1) / StripHeight, std::vector<Blit>());
+
+	// The area is placed like the map view places it at the top left corner
+	const int view_offset = floor <= GROUND_LAYER ? GROUND_LAYER - floor : 0;
+	const int scroll_x = (from.x - view_offset) * TileSize;
+	const int scroll_y = (from.y - view_offset) * TileSize;
+
+	const int start_z = floor <= GROUND_LAYER ? GROUND_LAYER : std::min(MAP_MAX_LAYER, floor + 2);
+
+	// Sprites are read here, on one thread, only the blending is done in parallel
+	for (int map_z = start_z; map_z >= floor; --map_z) {
+		int offset;
+		if (map_z <= GROUND_LAYER) {
+			offset = (GROUND_LAYER - map_z) * TileSize;
+		} else {
+			offset = TileSize * (floor - map_z);
+		}
+
+		const int start_x = std::max(0, (scroll_x + offset) / TileSize - 1);
+		const int start_y = std::max(0, (scroll_y + offset + first_row) / TileSize - 1);
+		const int end_x = (scroll_x + offset + image_width) / TileSize + SpriteMargin;
+		const int end_y = (scroll_y + offset + first_row + rows) / TileSize + SpriteMargin;
+
+		// Same order as the map view draws the tiles in
+		for (int nd_map_x = start_x & ~3; nd_map_x <= end_x; nd_map_x += 4) {
+			for (int nd_map_y = start_y & ~3; nd_map_y <= end_y; nd_map_y += 4) {
+				QTreeNode* node = map.getLeaf(nd_map_x, nd_map_y);
+				if (!node) {
+					continue;
+				}
+
+				for (int map_x = 0; map_x < 4; ++map_x) {
+					for (int map_y = 0; map_y < 4; ++map_y) {
+						TileLocation* location = node->getTile(map_x, map_y, map_z);
+						Tile* tile = location ? location->get() : nullptr;
+						if (tile) {
+							addTile(tile, tile->getX() * TileSize - scroll_x - offset, tile->getY() * TileSize - scroll_y - offset);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	drawStrips(rgba);
+	strips.clear();
+
+	// The blits point into the cache, so it's only trimmed once they are drawn
+	trimCache();
+}
+
+bool SoftwareRenderer::writePNG(const std::string& filename, const Position& from, const Position& to, const std::function<bool(int)>& progress) {
+	const int width = getImageWidth(from, to);
+	const int height = getImageHeight(from, to);
+	// Rows rendered at once, kept below 64MB
+	const int band = std::max(TileSize, std::min(256, int(64 * 1024 * 1024 / (size_t(width) * 4))));
+
+	PNGWriter png;
+	if (!png.open(filename, width, height)) {
+		error = png.getError();
+		return false;
+	}
+
+	std::vector<uint8_t> rgba;
+	std::vector<uint8_t> rgb;
+	try {
+		rgba.resize(size_t(width) * band * 4);
+		rgb.resize(size_t(width) * 3);
+	} catch (std::bad_alloc&) {
+		png.close();
+		std::remove(filename.c_str());
+		error = "There is not enough memory available to complete the operation.";
+		return false;
+	}
+
+	error.clear();
+	bool written = true;
+	bool cancelled = false;
+	for (int row = 0; row < height && written && !cancelled; row += band) {
+		const int rows = std::min(band, height - row);
+		render(from, to, row, rows, rgba.data());
+
+		for (int y = 0; y < rows && written; ++y) {
+			const uint8_t* source = &rgba[size_t(y) * width * 4];
+			for (int x = 0; x < width; ++x) {
+				rgb[x * 3 + 0] = source[x * 4 + 0];
+				rgb[x * 3 + 1] = source[x * 4 + 1];
+				rgb[x * 3 + 2] = source[x * 4 + 2];
+			}
+			written = png.writeRow(rgb.data());
+		}
+		cancelled = progress && !progress(int(int64_t(row + rows) * 100 / height));
+	}
+
+	if (cancelled || !written || !png.close()) {
+		if (!cancelled) {
+			error = png.getError();
+		}
+		png.close();
+		std::remove(filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+void SoftwareRenderer::setCacheSize(size_t bytes) {
+	max_sprites = std::max<size_t>(1, bytes / (SPRITE_PIXELS_SIZE * 4));
+	trimCache();
+}
+
+void SoftwareRenderer::clear() {
+	sprites.clear();
+	sprite_uses.clear();
+}
+
+void SoftwareRenderer::addTile(Tile* tile, int draw_x, int draw_y) {
+	if (tile->ground) {
+		addItem(tile, tile->ground, draw_x, draw_y);
+	}
+	for (Item* item : tile->items) {
+		addItem(tile, item, draw_x, draw_y);
+	}
+	if (tile->creature) {
+		addCreature(tile->creature, draw_x, draw_y);
+	}
+}
+
+void SoftwareRenderer::addItem(const Tile* tile, Item* item, int& draw_x, int& draw_y) {
+	const ItemType& type = g_items[item->getID()];
+	GameSprite* sprite = type.sprite;
+	if (type.isMetaItem() || !sprite) {
+		return;
+	}
+
+	const int screen_x = draw_x - sprite->getDrawOffset().first;
+	const int screen_y = draw_y - sprite->getDrawOffset().second;
+
+	// Items on top are drawn higher
+	draw_x -= sprite->getDrawHeight();
+	draw_y -= sprite->getDrawHeight();
+
+	int subtype, pattern_x, pattern_y, pattern_z;
+	item->getSpritePattern(sprite, tile->getPosition(), tile, subtype, pattern_x, pattern_y, pattern_z);
+
+	for (int cx = 0; cx != sprite->width; ++cx) {
+		for (int cy = 0; cy != sprite->height; ++cy) {
+			for (int layer = 0; layer != sprite->layers; ++layer) {
+				const uint8_t* pixels = getPixels(sprite, sprite->getSpriteIndex(cx, cy, layer, subtype, pattern_x, pattern_y, pattern_z, 0));
+				if (pixels) {
+					addBlit(screen_x - cx * TileSize, screen_y - cy * TileSize, pixels);
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::addCreature(const Creature* creature, int draw_x, int draw_y) {
+	// Same as MapDrawer::BlitCreature
+	const Outfit& outfit = creature->getLookType();
+	const int dir = creature->getDirection();
+	if (outfit.lookItem != 0) {
+		GameSprite* sprite = g_items[outfit.lookItem].sprite;
+		if (!sprite) {
+			return;
+		}
+		for (int cx = 0; cx != sprite->width; ++cx) {
+			for (int cy = 0; cy != sprite->height; ++cy) {
+				const uint8_t* pixels = getPixels(sprite, sprite->getSpriteIndex(cx, cy, 0, -1, 0, 0, 0, 0));
+				if (pixels) {
+					addBlit(draw_x - cx * TileSize, draw_y - cy * TileSize, pixels);
+				}
+			}
+		}
+		return;
+	}
+
+	GameSprite* sprite = g_gui.gfx.getCreatureSprite(outfit.lookType);
+	if (!sprite || outfit.lookType == 0) {
+		return;
+	}
+
+	int pattern_z = 0;
+	if (outfit.lookMount != 0) {
+		if (GameSprite* mount = g_gui.gfx.getCreatureSprite(outfit.lookMount)) {
+			Outfit mount_outfit;
+			mount_outfit.lookType = outfit.lookMount;
+			mount_outfit.lookHead = outfit.lookMountHead;
+			mount_outfit.lookBody = outfit.lookMountBody;
+			mount_outfit.lookLegs = outfit.lookMountLegs;
+			mount_outfit.lookFeet = outfit.lookMountFeet;
+			addOutfit(mount, mount_outfit, dir, 0, 0, draw_x, draw_y);
+
+			pattern_z = std::min<int>(1, sprite->pattern_z - 1);
+		}
+	}
+
+	// pattern_y is the addon
+	for (int addon = 0; addon < sprite->pattern_y; ++addon) {
+		if (addon > 0 && !(outfit.lookAddon & (1 << (addon - 1)))) {
+			continue;
+		}
+		addOutfit(sprite, outfit, dir, addon, pattern_z, draw_x, draw_y);
+	}
+}
+
+void SoftwareRenderer::addOutfit(GameSprite* sprite, const Outfit& outfit, int dir, int addon, int pattern_z, int draw_x, int draw_y) {
+	for (int cx = 0; cx != sprite->width; ++cx) {
+		for (int cy = 0; cy != sprite->height; ++cy) {
+			const uint8_t* pixels = getOutfitPixels(sprite, sprite->getOutfitSpriteIndex(cx, cy, dir, addon, pattern_z, 0), outfit);
+			if (pixels) {
+				addBlit(draw_x - cx * TileSize, draw_y - cy * TileSize, pixels);
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::addBlit(int x, int y, const uint8_t* pixels) {
+	const int top = y - first_row;
+	const int bottom = top + TileSize;
+	if (bottom <= 0 || top >= rows || x + TileSize <= 0 || x >= image_width) {
+		return;
+	}
+
+	// A sprite is in at most two strips
+	const int first_strip = std::max(0, top) / StripHeight;
+	const int last_strip = (std::min(rows, bottom) - 1) / StripHeight;
+	for (int strip = first_strip; strip <= last_strip; ++strip) {
+		strips[strip].push_back(Blit { x, top, pixels });
+	}
+}
+
+const uint8_t* SoftwareRenderer::getPixels(GameSprite* sprite, uint32_t sprite_index) {
+	return getCached(getSpriteKey(sprite->getSpriteID(sprite_index), PlainSprite), [&]() {
+		return sprite->decodeRGBAData(sprite_index, sprite_file.get());
+	});
+}
+
+const uint8_t* SoftwareRenderer::getOutfitPixels(GameSprite* sprite, uint32_t sprite_index, const Outfit& outfit) {
+	if (sprite->layers <= 1) {
+		return getPixels(sprite, sprite_index);
+	}
+	uint32_t color_hash = outfit.getColorHash();
+	if (color_hash == PlainSprite) {
+		// All colors are invalid and drawn as 0
+		color_hash = 0;
+	}
+	return getCached(getSpriteKey(sprite->getSpriteID(sprite_index), color_hash), [&]() {
+		return sprite->decodeOutfitRGBAData(sprite_index, outfit, sprite_file.get());
+	});
+}
+
+const uint8_t* SoftwareRenderer::getCached(uint64_t key, const std::function<uint8_t*()>& decode) {
+	auto it = sprites.find(key);
+	if (it != sprites.end()) {
+		sprite_uses.splice(sprite_uses.begin(), sprite_uses, it->second.use);
+		return it->second.pixels.get();
+	}
+
+	sprite_uses.push_front(key);
+	CachedSprite& sprite = sprites[key];
+	sprite.pixels.reset(decode());
+	sprite.use = sprite_uses.begin();
+	return sprite.pixels.get();
+}
+
+void SoftwareRenderer::trimCache() {
+	while (sprites.size() > max_sprites) {
+		sprites.erase(sprite_uses.back());
+		sprite_uses.pop_back();
+	}
+}
+
+void SoftwareRenderer::drawStrips(uint8_t* rgba) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		target = rgba;
+		next_strip = 0;
+		busy_workers = workers.size();
+		++generation;
+	}
+	work_ready.notify_all();
+
+	drawNextStrips();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	work_done.wait(lock, [this]() { return busy_workers == 0; });
+}
+
+void SoftwareRenderer::drawNextStrips() {
+	for (size_t strip = next_strip++; strip < strips.size(); strip = next_strip++) {
+		drawStrip(strip, target);
+	}
+}
+
+void SoftwareRenderer::workerLoop() {
+	uint64_t done_generation = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		work_ready.wait(lock, [&]() { return stopping || generation != done_generation; });
+		if (stopping) {
+			return;
+		}
+		done_generation = generation;
+
+		lock.unlock();
+		drawNextStrips();
+		lock.lock();
+
+		if (--busy_workers == 0) {
+			work_done.notify_one();
+		}
+	}
+}
+
+void SoftwareRenderer::drawStrip(size_t strip, uint8_t* rgba) const {
+	const int top = int(strip) * StripHeight;
+	const int bottom = std::min(rows, top + StripHeight);
+
+	// The black background of the map view
+	uint8_t* end = rgba + size_t(bottom) * image_width * 4;
+	for (uint8_t* pixel = rgba + size_t(top) * image_width * 4; pixel != end; pixel += 4) {
+		pixel[0] = 0;
+		pixel[1] = 0;
+		pixel[2] = 0;
+		pixel[3] = 255;
+	}
+
+	for (const Blit& blit : strips[strip]) {
+		const int start_x = std::max(0, -blit.x);
+		const int end_x = std::min(TileSize, image_width - blit.x);
+		const int start_y = std::max(0, top - blit.y);
+		const int end_y = std::min(TileSize, bottom - blit.y);
+
+		for (int sy = start_y; sy < end_y; ++sy) {
+			const uint8_t* source = blit.pixels + (sy * TileSize + start_x) * 4;
+			uint8_t* target = rgba + (size_t(blit.y + sy) * image_width + blit.x + start_x) * 4;
+			for (int sx = start_x; sx < end_x; ++sx, source += 4, target += 4) {
+				// Same blending as the map view, source alpha over the image
+				const int alpha = source[3];
+				if (alpha == 0) {
+					continue;
+				} else if (alpha == 255) {
+					target[0] = source[0];
+					target[1] = source[1];
+					target[2] = source[2];
+				} else {
+					target[0] = uint8_t((source[0] * alpha + target[0] * (255 - alpha)) / 255);
+					target[1] = uint8_t((source[1] * alpha + target[1] * (255 - alpha)) / 255);
+					target[2] = uint8_t((source[2] * alpha + target[2] * (255 - alpha)) / 255);
+				}
+			}
+		}
+	}
+}
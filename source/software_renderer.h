@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SOFTWARE_RENDERER_H_
+#define RME_SOFTWARE_RENDERER_H_
+
+#include "position.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class BaseMap;
+class Tile;
+class Item;
+class Creature;
+class GameSprite;
+class FileReadHandle;
+struct Outfit;
+
+// Composes the map into an RGBA image on the CPU, it needs neither an OpenGL
+// context nor a window. Tiles are drawn like the map view draws them in game
+// mode: the floors above ground, then ground, items and creatures in order with
+// their elevation, at 32 pixels per tile. Animations show their first frame and
+// light is not drawn. A renderer reads the sprites through its own file handle,
+// so several of them can run on different threads.
+class SoftwareRenderer {
+public:
+	// The strips of an image are drawn on threads (0 for one per core), the
+	// caller's thread is one of them and the others are kept until destruction
+	explicit SoftwareRenderer(BaseMap& map, int threads = 1);
+	~SoftwareRenderer();
+
+	SoftwareRenderer(const SoftwareRenderer&) = delete;
+	SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+	// Size of the image of the area from-to, both corners included
+	static int getImageWidth(const Position& from, const Position& to) {
+		return (to.x - from.x + 1) * TileSize;
+	}
+	static int getImageHeight(const Position& from, const Position& to) {
+		return (to.y - from.y + 1) * TileSize;
+	}
+
+	// Renders rows first_row to first_row + rows of the image of the area on floor from.z,
+	// as image width * rows * 4 bytes of RGBA. Must not run while the map is being changed.
+	void render(const Position& from, const Position& to, int first_row, int rows, uint8_t* rgba);
+	void render(const Position& from, const Position& to, std::vector<uint8_t>& rgba);
+
+	// Renders the area into a PNG a band of rows at a time. progress gets the
+	// percentage done after every band, returning false cancels.
+	bool writePNG(const std::string& filename, const Position& from, const Position& to, const std::function<bool(int)>& progress);
+	const std::string& getError() const {
+		return error;
+	}
+
+	// Decoded sprites beyond this are dropped after a render, least recently used first
+	void setCacheSize(size_t bytes);
+	// Frees the decoded sprites
+	void clear();
+
+	// Tiles further down and right than the area whose sprites can still reach into it
+	static const int SpriteMargin = 3;
+	static const size_t DefaultCacheSize = 64 * 1024 * 1024;
+
+private:
+	// A sprite at its place in the image, in drawing order
+	struct Blit {
+		int x, y;
+		const uint8_t* pixels;
+	};
+
+	struct CachedSprite {
+		std::unique_ptr<uint8_t[]> pixels;
+		std::list<uint64_t>::iterator use;
+	};
+
+	void addTile(Tile* tile, int draw_x, int draw_y);
+	void addItem(const Tile* tile, Item* item, int& draw_x, int& draw_y);
+	void addCreature(const Creature* creature, int draw_x, int draw_y);
+	void addOutfit(GameSprite* sprite, const Outfit& outfit, int dir, int addon, int pattern_z, int draw_x, int draw_y);
+	void addBlit(int x, int y, const uint8_t* pixels);
+	const uint8_t* getPixels(GameSprite* sprite, uint32_t sprite_index);
+	const uint8_t* getOutfitPixels(GameSprite* sprite, uint32_t sprite_index, const Outfit& outfit);
+	const uint8_t* getCached(uint64_t key, const std::function<uint8_t*()>& decode);
+	void trimCache();
+
+	void drawStrips(uint8_t* rgba);
+	void drawNextStrips();
+	void drawStrip(size_t strip, uint8_t* rgba) const;
+	void workerLoop();
+
+	static const int StripHeight = 32;
+
+	BaseMap& map;
+
+	// Own handle of the sprite file, nullptr if the sprites are memcached
+	std::unique_ptr<FileReadHandle> sprite_file;
+	// Decoded sprites by sprite id and outfit colors, nullptr for the ones that can't be read
+	std::unordered_map<uint64_t, CachedSprite> sprites;
+	// Keys of the sprites, most recently used first
+	std::list<uint64_t> sprite_uses;
+	size_t max_sprites;
+
+	// Set up for the rows being rendered
+	int image_width;
+	int first_row;
+	int rows;
+	std::vector<std::vector<Blit>> strips;
+	uint8_t* target;
+	std::atomic<size_t> next_strip;
+
+	// Workers wait for the generation to change, then draw strips until none are left
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+	uint64_t generation;
+	size_t busy_workers;
+	bool stopping;
+
+	std::string error;
+};
+
+#endif
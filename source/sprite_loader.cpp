@@ -0,0 +1,198 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "sprite_loader.h"
+
+#include "filehandle.h"
+#include "gui.h"
+
+SpriteLoader::SpriteLoader() :
+	stopping(false),
+	refresh_posted(false),
+	extended(false),
+	transparency(false) {
+	////
+}
+
+SpriteLoader::~SpriteLoader() {
+	stop();
+}
+
+void SpriteLoader::start(const std::string& spritefile, bool extended, bool transparency, int threads) {
+	stop();
+
+	this->spritefile = spritefile;
+	this->extended = extended;
+	this->transparency = transparency;
+	stopping = false;
+
+	for (int i = 0; i < std::max(threads, 1); ++i) {
+		workers.emplace_back(&SpriteLoader::run, this);
+	}
+}
+
+void SpriteLoader::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	requests.clear();
+	for (Decoded& sprite : decoded) {
+		delete[] sprite.rgba;
+	}
+	decoded.clear();
+}
+
+void SpriteLoader::request(uint32_t id, const uint8_t* dump, uint16_t size) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.push_back(Request { id, dump, size });
+	}
+	condition.notify_one();
+}
+
+void SpriteLoader::takeDecoded(std::vector<Decoded>& out, size_t max) {
+	std::lock_guard<std::mutex> lock(mutex);
+	while (!decoded.empty() && out.size() < max) {
+		out.push_back(decoded.front());
+		decoded.pop_front();
+	}
+	refresh_posted = false;
+}
+
+bool SpriteLoader::hasDecoded() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return !decoded.empty();
+}
+
+void SpriteLoader::run() {
+	std::unique_ptr<FileReadHandle> fh;
+	if (!spritefile.empty()) {
+		fh.reset(newd FileReadHandle(spritefile));
+	}
+	std::vector<uint8_t> buffer;
+
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !requests.empty(); });
+			if (stopping) {
+				return;
+			}
+			request = requests.front();
+			requests.pop_front();
+		}
+
+		uint8_t* rgba = nullptr;
+		if (request.dump) {
+			rgba = decode(request.dump, request.size, transparency);
+		} else if (fh && fh->isOk() && readDump(*fh, extended, request.id, buffer)) {
+			rgba = decode(buffer.data(), static_cast<uint16_t>(buffer.size()), transparency);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decoded.push_back(Decoded { request.id, rgba });
+		}
+
+		// Wake up the map views once, they pick up everything that is ready when they paint
+		if (!refresh_posted.exchange(true)) {
+			wxTheApp->CallAfter([]() {
+				g_gui.RefreshView();
+			});
+		}
+	}
+}
+
+uint8_t* SpriteLoader::decode(const uint8_t* dump, uint16_t size, bool transparency) {
+	const int pixels_data_size = SPRITE_PIXELS_SIZE * 4;
+	uint8_t* data = newd uint8_t[pixels_data_size];
+	uint8_t bpp = transparency ? 4 : 3;
+	int write = 0;
+	int read = 0;
+
+	// decompress pixels
+	while (read < size && write < pixels_data_size) {
+		int transparent = dump[read] | dump[read + 1] << 8;
+		if (transparency && transparent >= SPRITE_PIXELS_SIZE) { // Corrupted sprite?
+			break;
+		}
+		read += 2;
+		for (int i = 0; i < transparent && write < pixels_data_size; i++) {
+			data[write + 0] = 0x00; // red
+			data[write + 1] = 0x00; // green
+			data[write + 2] = 0x00; // blue
+			data[write + 3] = 0x00; // alpha
+			write += 4;
+		}
+
+		int colored = dump[read] | dump[read + 1] << 8;
+		read += 2;
+		for (int i = 0; i < colored && write < pixels_data_size; i++) {
+			data[write + 0] = dump[read + 0]; // red
+			data[write + 1] = dump[read + 1]; // green
+			data[write + 2] = dump[read + 2]; // blue
+			data[write + 3] = transparency ? dump[read + 3] : 0xFF; // alpha
+			write += 4;
+			read += bpp;
+		}
+	}
+
+	// fill remaining pixels
+	while (write < pixels_data_size) {
+		data[write + 0] = 0x00; // red
+		data[write + 1] = 0x00; // green
+		data[write + 2] = 0x00; // blue
+		data[write + 3] = 0x00; // alpha
+		write += 4;
+	}
+	return data;
+}
+
+bool SpriteLoader::readDump(FileReadHandle& fh, bool extended, uint32_t id, std::vector<uint8_t>& dump) {
+	dump.clear();
+	if (id == 0) {
+		// Empty GameSprite
+		return true;
+	}
+
+	if (!fh.seek((extended ? 4 : 2) + id * sizeof(uint32_t))) {
+		return false;
+	}
+
+	uint32_t to_seek = 0;
+	if (!fh.getU32(to_seek) || !fh.seek(to_seek + 3)) {
+		return false;
+	}
+
+	uint16_t sprite_size;
+	if (!fh.getU16(sprite_size)) {
+		return false;
+	}
+
+	dump.resize(sprite_size);
+	return sprite_size == 0 || fh.getRAW(dump.data(), sprite_size);
+}
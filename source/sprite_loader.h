@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_LOADER_H_
+#define RME_SPRITE_LOADER_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class FileReadHandle;
+
+// Reads and decodes sprites on worker threads, so that drawing never waits
+// for the sprite file. The decoded pixels are picked up by the GL thread,
+// which uploads a limited amount of them every frame.
+class SpriteLoader {
+public:
+	struct Decoded {
+		uint32_t id;
+		uint8_t* rgba; // nullptr if the sprite could not be read
+	};
+
+	SpriteLoader();
+	~SpriteLoader();
+
+	SpriteLoader(const SpriteLoader&) = delete;
+	SpriteLoader& operator=(const SpriteLoader&) = delete;
+
+	// spritefile is only used for sprites requested without a dump (when not memcached)
+	void start(const std::string& spritefile, bool extended, bool transparency, int threads);
+	void stop();
+	bool isRunning() const {
+		return !workers.empty();
+	}
+
+	// Queues a sprite, the dump must stay valid until the loader is stopped
+	void request(uint32_t id, const uint8_t* dump, uint16_t size);
+	// Moves at most max decoded sprites to out, the caller owns the pixels
+	void takeDecoded(std::vector<Decoded>& out, size_t max);
+	bool hasDecoded();
+
+	// Decodes a compressed sprite to 32x32 RGBA pixels allocated with new[]
+	static uint8_t* decode(const uint8_t* dump, uint16_t size, bool transparency);
+	// Reads the compressed sprite from an open sprite file
+	static bool readDump(FileReadHandle& fh, bool extended, uint32_t id, std::vector<uint8_t>& dump);
+
+private:
+	struct Request {
+		uint32_t id;
+		const uint8_t* dump;
+		uint16_t size;
+	};
+
+	void run();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<Request> requests;
+	std::deque<Decoded> decoded;
+	bool stopping;
+
+	// Set while a refresh of the map views is queued on the main thread
+	std::atomic<bool> refresh_posted;
+
+	std::string spritefile;
+	bool extended;
+	bool transparency;
+};
+
+#endif
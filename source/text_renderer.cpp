@@ -0,0 +1,190 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "text_renderer.h"
+
+#include "gui.h"
+
+TextRenderer::TextRenderer() :
+	line_height(FontHeight + 2),
+	texture(0),
+	frame(0) {
+	////
+}
+
+TextRenderer::~TextRenderer() {
+	clear();
+}
+
+const TextRenderer::Layout& TextRenderer::getLayout(const std::string& text, size_t max_line_chars, size_t max_chars) {
+	auto it = layouts.find(text);
+	if (it != layouts.end()) {
+		it->second.lastframe = frame;
+		return it->second;
+	}
+
+	if (texture == 0) {
+		createAtlas();
+	}
+
+	Layout& layout = layouts[text];
+	layout.lastframe = frame;
+
+	std::string visible = text;
+	if (visible.size() > max_chars + 3) {
+		visible.resize(max_chars);
+		visible += "...";
+	}
+
+	float x = 0.f;
+	float y = 0.f;
+	size_t line_chars = 0;
+	for (char c : visible) {
+		const uint8_t glyph = static_cast<uint8_t>(c);
+		if (c == '\n' || (line_chars >= max_line_chars && c == ' ')) {
+			x = 0.f;
+			y += line_height;
+			line_chars = 0;
+			continue;
+		}
+
+		if (glyph >= 0x20 && glyph != 0x7F) {
+			layout.characters.push_back(Layout::Character { x, y, glyph });
+			x += glyphs[glyph].width;
+			layout.width = std::max(layout.width, x);
+		}
+		++line_chars;
+	}
+	layout.height = y + line_height;
+	return layout;
+}
+
+void TextRenderer::draw(const Layout& layout, float x, float y, float scale) {
+	if (layout.characters.empty()) {
+		return;
+	}
+
+	const float texel = 1.f / AtlasSize;
+	const float height = line_height * scale;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBegin(GL_QUADS);
+	for (const Layout::Character& character : layout.characters) {
+		const Glyph& glyph = glyphs[character.glyph];
+		const float left = x + character.x * scale;
+		const float top = y + character.y * scale;
+		const float right = left + glyph.width * scale;
+		const float bottom = top + height;
+		const float u0 = glyph.x * texel;
+		const float v0 = glyph.y * texel;
+		const float u1 = (glyph.x + glyph.width) * texel;
+		const float v1 = (glyph.y + line_height) * texel;
+
+		glTexCoord2f(u0, v0);
+		glVertex2f(left, top);
+		glTexCoord2f(u1, v0);
+		glVertex2f(right, top);
+		glTexCoord2f(u1, v1);
+		glVertex2f(right, bottom);
+		glTexCoord2f(u0, v1);
+		glVertex2f(left, bottom);
+	}
+	glEnd();
+}
+
+void TextRenderer::finishFrame() {
+	++frame;
+	if (layouts.size() <= MaxLayouts) {
+		return;
+	}
+
+	// Drop everything that wasn't drawn this frame
+	for (auto it = layouts.begin(); it != layouts.end();) {
+		if (it->second.lastframe != frame - 1) {
+			it = layouts.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void TextRenderer::clear() {
+	if (texture != 0) {
+		glDeleteTextures(1, &texture);
+		texture = 0;
+	}
+	layouts.clear();
+}
+
+void TextRenderer::createAtlas() {
+	wxBitmap bitmap(AtlasSize, AtlasSize, 24);
+	wxMemoryDC dc(bitmap);
+	dc.SetBackground(*wxBLACK_BRUSH);
+	dc.Clear();
+	dc.SetFont(wxFont(wxSize(0, FontHeight), wxFONTFAMILY_SWISS, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+	dc.SetTextForeground(*wxWHITE);
+
+	line_height = std::max<float>(dc.GetCharHeight(), FontHeight + 2);
+	const int cell_height = static_cast<int>(line_height) + 1;
+
+	// Glyphs are packed in rows, with a pixel of space so filtering doesn't bleed between them
+	int x = 0;
+	int y = 0;
+	for (int c = 0x20; c < 256; ++c) {
+		if (c == 0x7F) {
+			continue;
+		}
+
+		const wxString character(wxUniChar(static_cast<unsigned int>(c)));
+		wxCoord width, height;
+		dc.GetTextExtent(character, &width, &height);
+		if (x + width >= AtlasSize) {
+			x = 0;
+			y += cell_height;
+		}
+		if (y + cell_height > AtlasSize) {
+			break;
+		}
+
+		dc.DrawText(character, x, y);
+		glyphs[c].x = x;
+		glyphs[c].y = y;
+		glyphs[c].width = width;
+		x += width + 1;
+	}
+	dc.SelectObject(wxNullBitmap);
+
+	// The glyphs are white, the rendered intensity becomes the alpha
+	const wxImage image = bitmap.ConvertToImage();
+	const uint8_t* rgb = image.GetData();
+	std::vector<uint8_t> rgba(AtlasSize * AtlasSize * 4);
+	for (int i = 0; i < AtlasSize * AtlasSize; ++i) {
+		rgba[i * 4 + 0] = 0xFF;
+		rgba[i * 4 + 1] = 0xFF;
+		rgba[i * 4 + 2] = 0xFF;
+		rgba[i * 4 + 3] = std::max({ rgb[i * 3 + 0], rgb[i * 3 + 1], rgb[i * 3 + 2] });
+	}
+
+	texture = g_gui.gfx.getFreeTextureID();
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, AtlasSize, AtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+}
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_TEXT_RENDERER_H
+#define RME_TEXT_RENDERER_H
+
+#include "graphics.h"
+
+#include <unordered_map>
+
+// Draws text on the map from a texture holding every Latin-1 glyph, so a whole
+// string is sent as one batch of quads. The layout of each string is kept
+// between frames since the same tooltips are drawn over and over.
+class TextRenderer {
+	struct Glyph {
+		uint16_t x = 0;
+		uint16_t y = 0;
+		uint16_t width = 0;
+	};
+
+public:
+	struct Layout {
+		struct Character {
+			float x, y; // Offset from the top left corner of the text
+			uint8_t glyph;
+		};
+
+		std::vector<Character> characters;
+		float width = 0.f;
+		float height = 0.f;
+		int lastframe = 0;
+	};
+
+	TextRenderer();
+	virtual ~TextRenderer();
+
+	// Lines are broken at newlines and at the first space after max_line_chars characters,
+	// text longer than max_chars is cut off with an ellipsis
+	const Layout& getLayout(const std::string& text, size_t max_line_chars, size_t max_chars);
+	// Draws the text with its top left corner at x, y using the current color
+	void draw(const Layout& layout, float x, float y, float scale);
+	// Must be called once per frame, after all text has been drawn
+	void finishFrame();
+	void clear();
+
+	float getLineHeight() const noexcept {
+		return line_height;
+	}
+
+	static const int AtlasSize = 256;
+	static const int FontHeight = 12;
+	static const size_t MaxLayouts = 2048;
+
+private:
+	void createAtlas();
+
+	Glyph glyphs[256];
+	float line_height;
+	GLuint texture;
+
+	std::unordered_map<std::string, Layout> layouts;
+	int frame;
+};
+
+#endif
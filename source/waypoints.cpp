@@ -30,6 +30,7 @@ void Waypoints::addWaypoint(Waypoint* wp) {
 		t->getLocation()->increaseWaypointCount();
 	}
 	waypoints.insert(std::make_pair(as_lower_str(wp->name), wp));
+	addPosition(wp);
 }
 
 Waypoint* Waypoints::getWaypoint(std::string name) {
@@ -42,17 +43,14 @@ Waypoint* Waypoints::getWaypoint(std::string name) {
 }
 
 Waypoint* Waypoints::getWaypoint(TileLocation* location) {
-	if (!location) {
+	if (!location || positions.empty()) {
 		return nullptr;
 	}
-	// TODO find waypoint by position hash.
-	for (WaypointMap::iterator it = waypoints.begin(); it != waypoints.end(); it++) {
-		Waypoint* waypoint = it->second;
-		if (waypoint && waypoint->pos == location->position) {
-			return waypoint;
-		}
+	auto it = positions.find(makeKey(location->position));
+	if (it == positions.end()) {
+		return nullptr;
 	}
-	return nullptr;
+	return it->second;
 }
 
 void Waypoints::removeWaypoint(std::string name) {
@@ -61,6 +59,49 @@ void Waypoints::removeWaypoint(std::string name) {
 	if (iter == waypoints.end()) {
 		return;
 	}
-	delete iter->second;
+	Waypoint* wp = iter->second;
 	waypoints.erase(iter);
+	removePosition(wp);
+	delete wp;
+}
+
+void Waypoints::moveWaypoint(Waypoint* wp, const Position& pos) {
+	removePosition(wp);
+	wp->pos = pos;
+	addPosition(wp);
+}
+
+void Waypoints::merge(Waypoints& other, const Position& offset) {
+	for (WaypointMap::iterator iter = other.waypoints.begin(); iter != other.waypoints.end(); ++iter) {
+		Waypoint* wp = iter->second;
+		wp->pos += offset;
+		if (waypoints.insert(*iter).second) {
+			addPosition(wp);
+		} else {
+			delete wp;
+		}
+	}
+	other.waypoints.clear();
+	other.positions.clear();
+}
+
+void Waypoints::addPosition(Waypoint* wp) {
+	positions.emplace(makeKey(wp->pos), wp);
+}
+
+void Waypoints::removePosition(Waypoint* wp) {
+	auto it = positions.find(makeKey(wp->pos));
+	if (it == positions.end() || it->second != wp) {
+		return;
+	}
+	positions.erase(it);
+
+	// Another waypoint may share the position, this is rare so a scan is fine
+	for (WaypointMap::iterator iter = waypoints.begin(); iter != waypoints.end(); ++iter) {
+		Waypoint* other = iter->second;
+		if (other != wp && other->pos == wp->pos) {
+			addPosition(other);
+			break;
+		}
+	}
 }
@@ -20,6 +20,8 @@
 
 #include "position.h"
 
+#include <unordered_map>
+
 class Waypoint {
 public:
 	std::string name;
@@ -44,6 +46,14 @@ public:
 	Waypoint* getWaypoint(std::string name);
 	Waypoint* getWaypoint(TileLocation* location);
 	void removeWaypoint(std::string name);
+	// Positions of waypoints in the list must be changed through here to keep the position lookup up to date
+	void moveWaypoint(Waypoint* wp, const Position& pos);
+	// Takes over all waypoints of other, moved by offset, names that already exist here are dropped
+	void merge(Waypoints& other, const Position& offset);
+
+	size_t getWaypointCount() const {
+		return waypoints.size();
+	}
 
 	WaypointMap waypoints;
 
@@ -59,6 +69,17 @@ public:
 	WaypointMap::const_iterator end() const {
 		return waypoints.end();
 	}
+
+private:
+	void addPosition(Waypoint* wp);
+	void removePosition(Waypoint* wp);
+
+	static uint64_t makeKey(const Position& pos) {
+		return (uint64_t(uint16_t(pos.x)) << 32) | (uint64_t(uint16_t(pos.y)) << 16) | uint64_t(uint8_t(pos.z));
+	}
+
+	// First waypoint on every position, used when drawing tiles
+	std::unordered_map<uint64_t, Waypoint*> positions;
 };
 
 #endif
@@ -0,0 +1,602 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "web_map_exporter.h"
+
+#include "map.h"
+#include "tile.h"
+#include "item.h"
+#include "creature.h"
+#include "graphics.h"
+#include "gui.h"
+#include "software_renderer.h"
+#include "png_writer.h"
+
+#include <wx/dir.h>
+
+#include <condition_variable>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+	uint64_t makeKey(int x, int y) {
+		return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+	}
+	int getKeyX(uint64_t key) {
+		return int(key >> 32);
+	}
+	int getKeyY(uint64_t key) {
+		return int(key & 0xFFFFFFFF);
+	}
+
+	// FNV-1a
+	const uint64_t HashSeed = 14695981039346656037ULL;
+	void hashValue(uint64_t& hash, uint32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ULL;
+		}
+	}
+}
+
+WebMapExporter::WebMapExporter(Map& map, const std::string& directory, Source source) :
+	map(map),
+	directory(directory),
+	source(source),
+	client_version(g_gui.GetCurrentVersion().getName()),
+	tiles_per_image(source == SOURCE_SPRITES ? ImageSize / TileSize : ImageSize),
+	max_zoom(0),
+	threads(1),
+	jobs_done(0),
+	jobs_total(0),
+	cancelled(false),
+	tiles_written(0),
+	tiles_skipped(0) {
+	////
+}
+
+WebMapExporter::~WebMapExporter() {
+	////
+}
+
+bool WebMapExporter::run(int first_floor, int last_floor, int threads, const std::function<bool(int64_t, int64_t)>& progress) {
+	first_floor = std::max(0, first_floor);
+	last_floor = std::min(MAP_MAX_LAYER, last_floor);
+
+	if (threads <= 0) {
+		threads = std::max<int>(1, std::thread::hardware_concurrency());
+	}
+	this->threads = threads;
+	this->progress = progress;
+
+	// The renderers are made here, they read the settings
+	renderers.clear();
+	if (source == SOURCE_SPRITES) {
+		for (int i = 0; i < threads; ++i) {
+			renderers.emplace_back(newd SoftwareRenderer(map));
+			renderers.back()->setCacheSize(SpriteCacheSize / threads);
+		}
+	}
+
+	findTiles(first_floor, last_floor);
+
+	bool ok = true;
+	for (int floor = first_floor; floor <= last_floor && ok; ++floor) {
+		ok = exportFloor(floor);
+		// Floors share few sprites, above and below ground hardly any
+		for (auto& renderer : renderers) {
+			renderer->clear();
+		}
+	}
+
+	renderers.clear();
+	return ok && !cancelled;
+}
+
+void WebMapExporter::findTiles(int first_floor, int last_floor) {
+	std::vector<std::unordered_set<uint64_t>> found(MAP_LAYERS);
+	int max_tile = 0;
+
+	auto add = [&](int floor, int column, int row, int margin) {
+		for (int x = std::max(0, column - margin) / tiles_per_image; x <= column / tiles_per_image; ++x) {
+			for (int y = std::max(0, row - margin) / tiles_per_image; y <= row / tiles_per_image; ++y) {
+				found[floor].insert(makeKey(x, y));
+				max_tile = std::max(max_tile, std::max(x, y));
+			}
+		}
+	};
+
+	for (MapIterator it = map.begin(); it != map.end(); ++it) {
+		const Tile* tile = (*it)->get();
+		if (!tile || (!tile->ground && tile->items.empty())) {
+			continue;
+		}
+
+		const int z = tile->getZ();
+		if (source == SOURCE_MINIMAP) {
+			if (z >= first_floor && z <= last_floor) {
+				add(z, tile->getX(), tile->getY(), 0);
+			}
+			continue;
+		}
+
+		// The floors this tile is drawn on, a floor shows the ones above it down to the ground
+		// floor, underground it shows two floors below
+		const int lowest = z <= GROUND_LAYER ? 0 : std::max(GROUND_LAYER + 1, z - 2);
+		for (int floor = std::max(lowest, first_floor); floor <= std::min(z, last_floor); ++floor) {
+			// Tiles on lower floors are drawn down and to the right, their sprites reach up and to the left
+			const int shift = z - floor;
+			const int column = tile->getX() + shift;
+			const int row = tile->getY() + shift;
+			if (column >= 0 && row >= 0) {
+				add(floor, column, row, SoftwareRenderer::SpriteMargin);
+			}
+		}
+	}
+
+	max_zoom = 0;
+	while ((1 << max_zoom) <= max_tile) {
+		++max_zoom;
+	}
+
+	floor_tiles.assign(MAP_LAYERS, std::vector<uint64_t>());
+	jobs_done = 0;
+	jobs_total = 0;
+	for (int floor = first_floor; floor <= last_floor; ++floor) {
+		std::vector<uint64_t>& tiles = floor_tiles[floor];
+		tiles.assign(found[floor].begin(), found[floor].end());
+		std::sort(tiles.begin(), tiles.end());
+
+		// Every zoom has about a quarter of the tiles of the one below
+		std::unordered_set<uint64_t> level(found[floor]);
+		for (int zoom = max_zoom; zoom >= 0 && !level.empty(); --zoom) {
+			jobs_total += level.size();
+			std::unordered_set<uint64_t> parents;
+			for (uint64_t key : level) {
+				parents.insert(makeKey(getKeyX(key) >> 1, getKeyY(key) >> 1));
+			}
+			level.swap(parents);
+		}
+	}
+}
+
+bool WebMapExporter::exportFloor(int floor) {
+	// Zooms past the deepest one are left from a map that reached further. After
+	// an export of another kind none of the tiles are current, so all go.
+	Hashes hashes;
+	const bool exported = wxFileExists(wxstr(getFloorDirectory(floor) + "/hashes.txt"));
+	const bool current = loadHashes(floor, hashes);
+	if (!removeZooms(floor, current || !exported ? max_zoom + 1 : 0)) {
+		return false;
+	}
+
+	Level base;
+	if (exportBase(floor, base, hashes)) {
+		Level level(base);
+		Level children;
+		for (int zoom = max_zoom - 1; zoom >= 0 && !cancelled; --zoom) {
+			children.swap(level);
+			level.clear();
+			exportLevel(floor, zoom, children, level);
+		}
+	}
+
+	// The changes only count once the zooms above them are updated too, an export
+	// that was stopped draws and removes those tiles again next time
+	for (const auto& tile : base) {
+		if (cancelled && tile.second == TILE_CHANGED) {
+			hashes.erase(tile.first);
+		} else if (!cancelled && tile.second == TILE_REMOVED) {
+			hashes.erase(tile.first);
+		}
+	}
+	return saveHashes(floor, hashes) && !cancelled;
+}
+
+bool WebMapExporter::exportBase(int floor, Level& level, Hashes& hashes) {
+	const std::vector<uint64_t>& tiles = floor_tiles[floor];
+	if (!makeDirectories(floor, max_zoom, tiles)) {
+		return false;
+	}
+
+	// Tiles that have nothing left on them
+	std::unordered_set<uint64_t> present(tiles.begin(), tiles.end());
+	for (auto it = hashes.begin(); it != hashes.end(); ++it) {
+		if (present.count(it->first) == 0) {
+			const std::string path = getTilePath(floor, max_zoom, getKeyX(it->first), getKeyY(it->first));
+			if (wxFileExists(path)) {
+				wxRemoveFile(path);
+			}
+			level[it->first] = TILE_REMOVED;
+		}
+	}
+
+	std::vector<uint64_t> new_hashes(tiles.size());
+	std::vector<TileState> states(tiles.size(), TILE_UNCHANGED);
+	std::vector<uint8_t> done(tiles.size(), 0);
+
+	const bool completed = runJobs(tiles.size(), [&](int worker, size_t index) {
+		const int x = getKeyX(tiles[index]);
+		const int y = getKeyY(tiles[index]);
+		const std::string path = getTilePath(floor, max_zoom, x, y);
+
+		new_hashes[index] = getSourceHash(floor, x, y);
+		auto old = hashes.find(tiles[index]);
+		if (old != hashes.end() && old->second == new_hashes[index] && wxFileExists(path)) {
+			++tiles_skipped;
+		} else {
+			std::vector<uint8_t> rgb(ImageSize * ImageSize * 3);
+			drawBase(worker, floor, x, y, rgb.data());
+			if (!writeImage(path, rgb.data())) {
+				return;
+			}
+			states[index] = TILE_CHANGED;
+		}
+		done[index] = 1;
+	});
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		if (!done[i]) {
+			continue;
+		}
+		level[tiles[i]] = states[i];
+		hashes[tiles[i]] = new_hashes[i];
+	}
+	return completed;
+}
+
+bool WebMapExporter::exportLevel(int floor, int zoom, const Level& children, Level& level) {
+	// A tile has to be drawn again if any of its four children changed
+	std::unordered_map<uint64_t, std::pair<bool, bool>> parents; // present, changed
+	for (const auto& child : children) {
+		std::pair<bool, bool>& parent = parents[makeKey(getKeyX(child.first) >> 1, getKeyY(child.first) >> 1)];
+		parent.first = parent.first || child.second != TILE_REMOVED;
+		parent.second = parent.second || child.second != TILE_UNCHANGED;
+	}
+
+	std::vector<uint64_t> tiles;
+	for (const auto& parent : parents) {
+		if (parent.second.first) {
+			tiles.push_back(parent.first);
+		} else {
+			const std::string path = getTilePath(floor, zoom, getKeyX(parent.first), getKeyY(parent.first));
+			if (wxFileExists(path)) {
+				wxRemoveFile(path);
+			}
+			level[parent.first] = TILE_REMOVED;
+		}
+	}
+	std::sort(tiles.begin(), tiles.end());
+
+	if (!makeDirectories(floor, zoom, tiles)) {
+		return false;
+	}
+
+	std::vector<TileState> states(tiles.size(), TILE_UNCHANGED);
+	const bool completed = runJobs(tiles.size(), [&](int WXUNUSED(worker), size_t index) {
+		const int x = getKeyX(tiles[index]);
+		const int y = getKeyY(tiles[index]);
+		const std::string path = getTilePath(floor, zoom, x, y);
+
+		if (!parents.at(tiles[index]).second && wxFileExists(path)) {
+			++tiles_skipped;
+			return;
+		}
+
+		std::vector<uint8_t> rgb(ImageSize * ImageSize * 3, 0);
+		if (drawParent(zoom, floor, x, y, children, rgb.data()) && writeImage(path, rgb.data())) {
+			states[index] = TILE_CHANGED;
+		}
+	});
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		level[tiles[i]] = states[i];
+	}
+	return completed;
+}
+
+uint64_t WebMapExporter::getSourceHash(int floor, int x, int y) const {
+	uint64_t hash = HashSeed;
+	const int start_x = x * tiles_per_image;
+	const int start_y = y * tiles_per_image;
+	const int end_x = start_x + tiles_per_image - 1;
+	const int end_y = start_y + tiles_per_image - 1;
+
+	if (source == SOURCE_MINIMAP) {
+		hashArea(hash, start_x, start_y, end_x, end_y, floor);
+		return hash;
+	}
+
+	// The same floors and area SoftwareRenderer draws
+	const int start_z = floor <= GROUND_LAYER ? GROUND_LAYER : std::min(MAP_MAX_LAYER, floor + 2);
+	for (int map_z = start_z; map_z >= floor; --map_z) {
+		const int shift = floor - map_z;
+		hashArea(hash, start_x + shift - 1, start_y + shift - 1, end_x + shift + SoftwareRenderer::SpriteMargin, end_y + shift + SoftwareRenderer::SpriteMargin, map_z);
+	}
+	return hash;
+}
+
+void WebMapExporter::hashArea(uint64_t& hash, int start_x, int start_y, int end_x, int end_y, int z) const {
+	// Hashed per leaf, the leaves are the smallest parts of the map that are stored on their own
+	for (int nd_x = std::max(0, start_x) & ~3; nd_x <= end_x; nd_x += 4) {
+		for (int nd_y = std::max(0, start_y) & ~3; nd_y <= end_y; nd_y += 4) {
+			QTreeNode* node = map.getLeaf(nd_x, nd_y);
+			if (!node) {
+				continue;
+			}
+
+			uint64_t leaf_hash = HashSeed;
+			for (int local_x = 0; local_x < 4; ++local_x) {
+				for (int local_y = 0; local_y < 4; ++local_y) {
+					TileLocation* location = node->getTile(local_x, local_y, z);
+					const Tile* tile = location ? location->get() : nullptr;
+					if (!tile) {
+						hashValue(leaf_hash, 0);
+						continue;
+					}
+
+					hashValue(leaf_hash, tile->ground ? tile->ground->getID() : 0);
+					hashValue(leaf_hash, tile->ground ? tile->ground->getSubtype() : 0);
+					for (const Item* item : tile->items) {
+						hashValue(leaf_hash, item->getID());
+						hashValue(leaf_hash, item->getSubtype());
+					}
+					hashValue(leaf_hash, uint32_t(tile->items.size()));
+					if (const Creature* creature = tile->creature) {
+						const Outfit& outfit = creature->getLookType();
+						hashValue(leaf_hash, outfit.lookType);
+						hashValue(leaf_hash, outfit.lookItem);
+						hashValue(leaf_hash, outfit.lookMount);
+						hashValue(leaf_hash, outfit.lookAddon);
+						hashValue(leaf_hash, outfit.getColorHash());
+						hashValue(leaf_hash, creature->getDirection());
+					}
+				}
+			}
+
+			hashValue(hash, nd_x);
+			hashValue(hash, nd_y);
+			hashValue(hash, uint32_t(leaf_hash));
+			hashValue(hash, uint32_t(leaf_hash >> 32));
+		}
+	}
+}
+
+void WebMapExporter::drawBase(int worker, int floor, int x, int y, uint8_t* rgb) {
+	const int start_x = x * tiles_per_image;
+	const int start_y = y * tiles_per_image;
+
+	if (source == SOURCE_MINIMAP) {
+		for (int row = 0; row < ImageSize; ++row) {
+			for (int column = 0; column < ImageSize; ++column) {
+				const Tile* tile = map.getTile(start_x + column, start_y + row, floor);
+				const RGBQuad& color = minimap_color[tile ? tile->getMiniMapColor() : 0];
+				uint8_t* pixel = rgb + (row * ImageSize + column) * 3;
+				pixel[0] = color.red;
+				pixel[1] = color.green;
+				pixel[2] = color.blue;
+			}
+		}
+		return;
+	}
+
+	const Position from(start_x, start_y, floor);
+	const Position to(start_x + tiles_per_image - 1, start_y + tiles_per_image - 1, floor);
+	std::vector<uint8_t> rgba(ImageSize * ImageSize * 4);
+	renderers[worker]->render(from, to, 0, ImageSize, rgba.data());
+
+	for (int i = 0; i < ImageSize * ImageSize; ++i) {
+		rgb[i * 3 + 0] = rgba[i * 4 + 0];
+		rgb[i * 3 + 1] = rgba[i * 4 + 1];
+		rgb[i * 3 + 2] = rgba[i * 4 + 2];
+	}
+}
+
+bool WebMapExporter::drawParent(int zoom, int floor, int x, int y, const Level& children, uint8_t* rgb) const {
+	// Each child fills a quarter, every pixel is the average of four child pixels
+	const int half = ImageSize / 2;
+	for (int part = 0; part < 4; ++part) {
+		const int child_x = x * 2 + (part & 1);
+		const int child_y = y * 2 + (part >> 1);
+		auto child = children.find(makeKey(child_x, child_y));
+		if (child == children.end() || child->second == TILE_REMOVED) {
+			continue;
+		}
+
+		wxImage image;
+		{
+			wxLogNull suppress;
+			image.LoadFile(wxstr(getTilePath(floor, zoom + 1, child_x, child_y)), wxBITMAP_TYPE_PNG);
+		}
+		if (!image.IsOk() || image.GetWidth() != ImageSize || image.GetHeight() != ImageSize) {
+			continue;
+		}
+
+		const uint8_t* source = image.GetData();
+		for (int row = 0; row < half; ++row) {
+			const uint8_t* top = source + size_t(row * 2) * ImageSize * 3;
+			const uint8_t* bottom = top + ImageSize * 3;
+			uint8_t* target = rgb + (size_t(row + (part >> 1) * half) * ImageSize + (part & 1) * half) * 3;
+			for (int column = 0; column < half; ++column) {
+				for (int channel = 0; channel < 3; ++channel) {
+					const int left = column * 6 + channel;
+					target[column * 3 + channel] = uint8_t((top[left] + top[left + 3] + bottom[left] + bottom[left + 3] + 2) / 4);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+std::string WebMapExporter::getFloorDirectory(int floor) const {
+	return directory + "/" + i2s(floor);
+}
+
+std::string WebMapExporter::getTilePath(int floor, int zoom, int x, int y) const {
+	return getFloorDirectory(floor) + "/" + i2s(zoom) + "/" + i2s(x) + "/" + i2s(y) + ".png";
+}
+
+bool WebMapExporter::makeDirectories(int floor, int zoom, const std::vector<uint64_t>& keys) {
+	// Made up front, the workers only write files
+	int last_x = -1;
+	for (uint64_t key : keys) {
+		if (getKeyX(key) == last_x) {
+			continue;
+		}
+		last_x = getKeyX(key);
+
+		const wxString path = wxstr(getFloorDirectory(floor) + "/" + i2s(zoom) + "/" + i2s(last_x));
+		if (!wxFileName::DirExists(path) && !wxFileName::Mkdir(path, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+			setError("Could not create the folder " + nstr(path) + ".");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool WebMapExporter::removeZooms(int floor, int first_zoom) {
+	const wxString path = wxstr(getFloorDirectory(floor));
+	if (!wxFileName::DirExists(path)) {
+		return true;
+	}
+
+	std::vector<wxString> stale;
+	wxDir dir(path);
+	wxString name;
+	for (bool found = dir.IsOpened() && dir.GetFirst(&name, wxEmptyString, wxDIR_DIRS); found; found = dir.GetNext(&name)) {
+		long zoom;
+		if (name.ToLong(&zoom) && zoom >= first_zoom) {
+			stale.push_back(path + "/" + name);
+		}
+	}
+
+	for (const wxString& zoom_path : stale) {
+		if (!wxFileName::Rmdir(zoom_path, wxPATH_RMDIR_RECURSIVE)) {
+			setError("Could not remove the old tiles in " + nstr(zoom_path) + ".");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool WebMapExporter::writeImage(const std::string& path, const uint8_t* rgb) {
+	PNGWriter png;
+	bool ok = png.open(path, ImageSize, ImageSize);
+	for (int row = 0; row < ImageSize && ok; ++row) {
+		ok = png.writeRow(rgb + row * ImageSize * 3);
+	}
+	ok = png.close() && ok;
+
+	if (!ok) {
+		setError(png.getError());
+		return false;
+	}
+	++tiles_written;
+	return true;
+}
+
+bool WebMapExporter::loadHashes(int floor, Hashes& hashes) const {
+	std::ifstream file((getFloorDirectory(floor) + "/hashes.txt").c_str());
+	if (!file.is_open()) {
+		return false;
+	}
+
+	// Tiles from another kind of export are all drawn again
+	std::string header;
+	if (!std::getline(file, header) || header != getHashesHeader()) {
+		return false;
+	}
+
+	int x, y;
+	uint64_t hash;
+	while (file >> x >> y >> std::hex >> hash >> std::dec) {
+		hashes[makeKey(x, y)] = hash;
+	}
+	return true;
+}
+
+bool WebMapExporter::saveHashes(int floor, const Hashes& hashes) {
+	const wxString path = wxstr(getFloorDirectory(floor));
+	if (!wxFileName::DirExists(path) && !wxFileName::Mkdir(path, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+		setError("Could not create the folder " + nstr(path) + ".");
+		return false;
+	}
+
+	std::ofstream file((getFloorDirectory(floor) + "/hashes.txt").c_str(), std::ios::out | std::ios::trunc);
+	file << getHashesHeader() << "\n";
+	for (const auto& hash : hashes) {
+		file << getKeyX(hash.first) << " " << getKeyY(hash.first) << " " << std::hex << hash.second << std::dec << "\n";
+	}
+
+	if (!file.good()) {
+		setError("Could not write " + nstr(path) + "/hashes.txt.");
+		return false;
+	}
+	return true;
+}
+
+std::string WebMapExporter::getHashesHeader() const {
+	return std::string("rme-web-map ") + (source == SOURCE_SPRITES ? "sprites" : "minimap") + " " + i2s(max_zoom) + " " + client_version;
+}
+
+bool WebMapExporter::runJobs(size_t count, const std::function<void(int, size_t)>& job) {
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> done(0);
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	auto work = [&](int worker) {
+		for (size_t index = next++; index < count && !cancelled; index = next++) {
+			job(worker, index);
+			if (++done == count) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < std::min<int>(threads, int(count)); ++i) {
+		workers.emplace_back(work, i);
+	}
+
+	// This thread only reports the progress, so the dialog stays responsive
+	while (done < count && !cancelled) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait_for(lock, std::chrono::milliseconds(100), [&]() { return done >= count; });
+		}
+		if (progress && !progress(std::min(jobs_total, jobs_done + int64_t(done)), jobs_total)) {
+			cancelled = true;
+		}
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	jobs_done += done;
+	return !cancelled;
+}
+
+void WebMapExporter::setError(const std::string& message) {
+	std::lock_guard<std::mutex> lock(error_mutex);
+	if (error.empty()) {
+		error = message;
+	}
+	cancelled = true;
+}
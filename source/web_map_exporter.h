@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_WEB_MAP_EXPORTER_H_
+#define RME_WEB_MAP_EXPORTER_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class Map;
+class SoftwareRenderer;
+
+// Writes the map as 256x256 PNG tiles for web map viewers (Leaflet, OpenLayers),
+// laid out as <directory>/<floor>/<zoom>/<x>/<y>.png where zoom 0 holds the whole
+// map in one tile. The deepest zoom is drawn from the map, every other zoom is
+// scaled down from the one below it.
+//
+// The hashes of the map leaves each tile was drawn from are kept in
+// <directory>/<floor>/hashes.txt, exporting into the same folder again only
+// redraws the tiles whose part of the map has changed. Zoom folders past the
+// deepest zoom of the export are deleted.
+class WebMapExporter {
+public:
+	enum Source {
+		SOURCE_SPRITES, // 32 pixels per map tile, as the map view draws it
+		SOURCE_MINIMAP, // 1 pixel per map tile, in minimap colors
+	};
+
+	WebMapExporter(Map& map, const std::string& directory, Source source);
+	~WebMapExporter();
+
+	WebMapExporter(const WebMapExporter&) = delete;
+	WebMapExporter& operator=(const WebMapExporter&) = delete;
+
+	// Exports the floors first_floor to last_floor on threads (0 for one per core).
+	// progress is called on the calling thread every now and then, returning false
+	// cancels the export. The map must not be changed while this runs.
+	bool run(int first_floor, int last_floor, int threads, const std::function<bool(int64_t done, int64_t total)>& progress);
+
+	int64_t getTilesWritten() const {
+		return tiles_written;
+	}
+	int64_t getTilesSkipped() const {
+		return tiles_skipped;
+	}
+	// Empty if the export was cancelled
+	const std::string& getError() const {
+		return error;
+	}
+
+	static const int ImageSize = 256;
+	// Decoded sprites kept by all the workers together
+	static const size_t SpriteCacheSize = 256 * 1024 * 1024;
+
+private:
+	enum TileState : uint8_t {
+		TILE_UNCHANGED,
+		TILE_CHANGED,
+		TILE_REMOVED,
+	};
+
+	// By tile key (x << 32 | y)
+	typedef std::unordered_map<uint64_t, TileState> Level;
+	typedef std::unordered_map<uint64_t, uint64_t> Hashes;
+
+	void findTiles(int first_floor, int last_floor);
+	bool exportFloor(int floor);
+	bool exportBase(int floor, Level& level, Hashes& hashes);
+	bool exportLevel(int floor, int zoom, const Level& children, Level& level);
+
+	uint64_t getSourceHash(int floor, int x, int y) const;
+	void hashArea(uint64_t& hash, int start_x, int start_y, int end_x, int end_y, int z) const;
+	void drawBase(int worker, int floor, int x, int y, uint8_t* rgb);
+	bool drawParent(int zoom, int floor, int x, int y, const Level& children, uint8_t* rgb) const;
+
+	std::string getFloorDirectory(int floor) const;
+	std::string getTilePath(int floor, int zoom, int x, int y) const;
+	bool makeDirectories(int floor, int zoom, const std::vector<uint64_t>& keys);
+	// Deletes the zoom folders of the floor from first_zoom on
+	bool removeZooms(int floor, int first_zoom);
+	bool writeImage(const std::string& path, const uint8_t* rgb);
+	bool loadHashes(int floor, Hashes& hashes) const;
+	bool saveHashes(int floor, const Hashes& hashes);
+	std::string getHashesHeader() const;
+
+	// Runs job(worker, index) for index 0 to count - 1 on the worker threads
+	bool runJobs(size_t count, const std::function<void(int worker, size_t index)>& job);
+	void setError(const std::string& message);
+
+	Map& map;
+	std::string directory;
+	Source source;
+	std::string client_version;
+
+	// Map tiles per tile at the deepest zoom
+	int tiles_per_image;
+	int max_zoom;
+	// Tiles with something drawn on them at the deepest zoom, per floor
+	std::vector<std::vector<uint64_t>> floor_tiles;
+
+	int threads;
+	std::vector<std::unique_ptr<SoftwareRenderer>> renderers;
+	std::function<bool(int64_t, int64_t)> progress;
+	int64_t jobs_done;
+	int64_t jobs_total;
+
+	std::atomic<bool> cancelled;
+	std::atomic<int64_t> tiles_written;
+	std::atomic<int64_t> tiles_skipped;
+	std::mutex error_mutex;
+	std::string error;
+};
+
+#endif
@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// Times DirtyList::AddPosition and GetPosList for a commit of 1M tiles, with
+// the std::set the list used to be (a copy kept here) and source/dirty_list.cpp:
+//
+//   g++ -O2 -std=c++17 tools/dirty_list_bench.cpp source/dirty_list.cpp -o dirty_list_bench
+//   ./dirty_list_bench
+
+#include "../source/dirty_list.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+typedef DirtyList::ValueType ValueType;
+
+class SetDirtyList {
+public:
+	struct Comparator {
+		bool operator()(const ValueType& a, const ValueType& b) const {
+			return a.pos < b.pos;
+		}
+	};
+	typedef std::set<ValueType, Comparator> SetType;
+
+	void AddPosition(int x, int y, int z) {
+		uint32_t m = ((x >> 2) << 18) | ((y >> 2) << 4);
+		ValueType fi = { m, 0 };
+		SetType::iterator s = iset.find(fi);
+		if (s != iset.end()) {
+			ValueType v = *s;
+			iset.erase(s);
+			v.floors = (1 << z) | v.floors;
+			iset.insert(v);
+		} else {
+			ValueType v = { m, (uint32_t)(1 << z) };
+			iset.insert(v);
+		}
+	}
+
+	SetType& GetPosList() {
+		return iset;
+	}
+
+private:
+	SetType iset;
+};
+
+struct Tile {
+	int x, y, z;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed(Clock::time_point since) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+template <class List>
+static void run(const char* name, const std::vector<Tile>& tiles, int repeats) {
+	double add_time = 1e30;
+	double list_time = 1e30;
+	uint64_t checksum = 0;
+	for (int i = 0; i < repeats; ++i) {
+		List list;
+		Clock::time_point start = Clock::now();
+		for (const Tile& tile : tiles) {
+			list.AddPosition(tile.x, tile.y, tile.z);
+		}
+		add_time = std::min(add_time, elapsed(start));
+
+		start = Clock::now();
+		checksum = 0;
+		for (const ValueType& value : list.GetPosList()) {
+			checksum = checksum * 31 + value.pos + value.floors;
+		}
+		list_time = std::min(list_time, elapsed(start));
+	}
+	std::printf("  %-8s AddPosition %8.2f ms   GetPosList %7.2f ms   (%llx)\n", name, add_time, list_time, (unsigned long long)checksum);
+}
+
+static void bench(const char* name, const std::vector<Tile>& tiles) {
+	std::printf("%s, %zu tiles\n", name, tiles.size());
+	run<SetDirtyList>("set", tiles, 5);
+	run<DirtyList>("vector", tiles, 5);
+}
+
+int main() {
+	// A 1000x1000 area on one floor, in the order of a selection (by position)
+	std::vector<Tile> tiles;
+	for (int x = 1000; x < 2000; ++x) {
+		for (int y = 1000; y < 2000; ++y) {
+			tiles.push_back(Tile { x, y, 7 });
+		}
+	}
+	bench("1000x1000, column by column", tiles);
+
+	// The same tiles leaf by leaf, the order of a paste or a map-wide change
+	tiles.clear();
+	for (int nd_x = 1000; nd_x < 2000; nd_x += 4) {
+		for (int nd_y = 1000; nd_y < 2000; nd_y += 4) {
+			for (int i = 0; i < 16; ++i) {
+				tiles.push_back(Tile { nd_x + (i >> 2), nd_y + (i & 3), 7 });
+			}
+		}
+	}
+	bench("1000x1000, leaf by leaf", tiles);
+
+	// 500x500 on floors 4 to 7 in random order
+	tiles.clear();
+	for (int z = 4; z <= 7; ++z) {
+		for (int x = 1000; x < 1500; ++x) {
+			for (int y = 1000; y < 1500; ++y) {
+				tiles.push_back(Tile { x, y, z });
+			}
+		}
+	}
+	std::shuffle(tiles.begin(), tiles.end(), std::mt19937(42));
+	bench("500x500x4 floors, shuffled", tiles);
+	return 0;
+}